@@ -0,0 +1,79 @@
+// audit_queue.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <applocker/audit_queue.hpp>
+#include <applocker/respawn_guard.hpp>
+
+namespace mjx {
+    _Audit_queue::_Producer::~_Producer() noexcept {
+        if (_Owner) { // the remaining records are drained by the writer thread, the next owner continues
+            _Owner->_Myrings[_Ring]._Owned.store(false, ::std::memory_order_release);
+        }
+    }
+
+    _Audit_queue::_Audit_queue() noexcept : _Myrings(), _Mydropped(0), _Myevent() {}
+
+    _Audit_queue::~_Audit_queue() noexcept {}
+
+    size_t _Audit_queue::_Claim() noexcept {
+        bool _Expected;
+        for (size_t _Idx = 0; _Idx < _Audit_queue_traits::_Max_rings; ++_Idx) {
+            _Expected = false;
+            if (_Myrings[_Idx]._Owned.compare_exchange_strong(_Expected, true, ::std::memory_order_acquire)) {
+                return _Idx;
+            }
+        }
+
+        return _Audit_queue_traits::_None;
+    }
+
+    void _Audit_queue::_Append(const uint32_t _Id, const audit_reason _Reason,
+        const checksum_t _Checksum, const audit_outcome _Outcome) noexcept {
+        // Note: The ring is claimed on the first append, the thread keeps it until it exits.
+        //       There is a single queue per process, so the ring doesn't have to be looked up.
+        static thread_local _Producer _Local = {nullptr, _Audit_queue_traits::_None};
+        if (!_Local._Owner) {
+            _Local._Ring = _Claim();
+            if (_Local._Ring == _Audit_queue_traits::_None) { // all rings are taken, try again next time
+                _Mydropped.fetch_add(1, ::std::memory_order_relaxed);
+                return;
+            }
+
+            _Local._Owner = this;
+        }
+
+        const audit_record _Record = {_Respawn_guard_traits::_Get_system_time(), _Checksum, _Id, _Reason, _Outcome, 0};
+        auto& _Queue               = _Myrings[_Local._Ring]._Queue;
+        if (_Queue._Push(_Record) && _Queue._Depth() == _Audit_queue_traits::_Wake_depth) {
+            _Myevent.notify(); // the ring fills up faster than it's drained
+        }
+    }
+
+    void _Audit_queue::_Drain(::std::vector<audit_record>& _Records) {
+        audit_record _Record;
+        for (_Ring& _Entry : _Myrings) {
+            while (_Entry._Queue._Pop(_Record)) {
+                _Records.push_back(_Record);
+            }
+        }
+    }
+
+    size_t _Audit_queue::_Dropped() const noexcept {
+        size_t _Count = _Mydropped.load(::std::memory_order_relaxed);
+        for (const _Ring& _Entry : _Myrings) {
+            _Count += _Entry._Queue._Overflows();
+        }
+
+        return _Count;
+    }
+
+    void _Audit_queue::_Wait(const uint32_t _Timeout) noexcept {
+        _Myevent.wait_and_reset(_Timeout);
+    }
+
+    void _Audit_queue::_Wake() noexcept {
+        _Myevent.notify();
+    }
+} // namespace mjx
\ No newline at end of file
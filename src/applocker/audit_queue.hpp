@@ -0,0 +1,77 @@
+// audit_queue.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_AUDIT_QUEUE_HPP_
+#define _APPLOCKER_AUDIT_QUEUE_HPP_
+#include <applocker/pipeline.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/audit_log.hpp>
+#include <dbmgr/checksum.hpp>
+#include <mjsync/waitable_event.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Audit_queue_traits {
+        // Note: Each thread that terminates processes gets its own ring, so appending a record is
+        //       a single store to memory owned by the thread, without any lock or system call. The writer
+        //       thread drains all rings periodically, or sooner if any of them is half full. If a ring is
+        //       full or all rings are taken, the record is dropped rather than stalling the enforcement.
+        static constexpr size_t _Ring_capacity  = 512; // records buffered per thread
+        static constexpr size_t _Max_rings      = 16; // threads that can log at the same time
+        static constexpr size_t _Wake_depth     = _Ring_capacity / 2; // wakes up the writer thread
+        static constexpr uint32_t _Flush_period = 5'000; // maximum time between two writes (in milliseconds)
+        static constexpr size_t _None           = SIZE_MAX; // no ring
+    };
+
+    class _Audit_queue { // collects the audit records from all threads
+    public:
+        _Audit_queue() noexcept;
+        ~_Audit_queue() noexcept;
+
+        _Audit_queue(const _Audit_queue&)            = delete;
+        _Audit_queue& operator=(const _Audit_queue&) = delete;
+
+        // appends the record to the calling thread's ring, never blocks
+        void _Append(const uint32_t _Id, const audit_reason _Reason,
+            const checksum_t _Checksum, const audit_outcome _Outcome) noexcept;
+
+        // moves all buffered records to _Records (called only by the writer thread)
+        void _Drain(::std::vector<audit_record>& _Records);
+
+        // returns the number of records dropped so far
+        size_t _Dropped() const noexcept;
+
+        // waits until a ring is half full or the timeout elapses (called only by the writer thread)
+        void _Wait(const uint32_t _Timeout) noexcept;
+
+        // wakes up the writer thread
+        void _Wake() noexcept;
+
+    private:
+        struct _Ring {
+            ::std::atomic<bool> _Owned; // true if a thread appends to the ring
+            _Spsc_queue<audit_record, _Audit_queue_traits::_Ring_capacity> _Queue;
+        };
+
+        struct _Producer { // releases the ring when the thread exits
+            _Audit_queue* _Owner;
+            size_t _Ring;
+
+            ~_Producer() noexcept;
+        };
+
+        // takes a free ring, returns _None if all rings are taken
+        size_t _Claim() noexcept;
+
+        _Ring _Myrings[_Audit_queue_traits::_Max_rings];
+        ::std::atomic<size_t> _Mydropped; // records dropped because all rings were taken
+        waitable_event _Myevent;
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_AUDIT_QUEUE_HPP_
\ No newline at end of file
@@ -8,23 +8,22 @@
 #include <dbmgr/database.hpp>
 
 namespace mjx {
-    directory_watcher::directory_watcher(waitable_event& _Event) noexcept
-        : _Mydir(_Open_watched_directory()), _Mybuf{0}, _Myevents(_Event), _Myovl() {
-        if (is_watching()) {
-            _Myovl.hEvent = _Myevents._Dir_event.native_handle();
-        }
-    }
+    directory_watcher::directory_watcher() noexcept
+        : _Mydir(_Open_watched_directory()), _Mybuf{0}, _Myovl(), _Mypending(false) {}
 
     directory_watcher::~directory_watcher() noexcept {
         if (is_watching()) {
+            if (_Mypending) { // the buffer must stay valid until the request is cancelled
+                unsigned long _Bytes;
+                ::CancelIoEx(_Mydir, &_Myovl);
+                ::GetOverlappedResult(_Mydir, &_Myovl, &_Bytes, true);
+            }
+
             ::CloseHandle(_Mydir);
             _Mydir = nullptr;
         }
     }
 
-    directory_watcher::_Notification_events::_Notification_events(waitable_event& _Event) noexcept
-        : _Thread_event(_Event), _Dir_event() {}
-
     [[nodiscard]] void* directory_watcher::_Open_watched_directory() noexcept {
         return ::CreateFileW(database_location::current().directory().c_str(),
             GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
@@ -45,26 +44,23 @@ namespace mjx {
         return _Mydir != nullptr && _Mydir != INVALID_HANDLE_VALUE;
     }
 
-    directory_watcher::wait_result directory_watcher::wait_for_changes() noexcept {
-        // Note: We are waiting for two events. The first one signals that changes have been
-        //       made to the directory being monitored. The second event is used to interrupt
-        //       the current thread's waiting state when waiting for directory changes.
-        void* _Events[2] = {
-            _Myevents._Dir_event.native_handle(), _Myevents._Thread_event.native_handle()};
-        unsigned long _Bytes; // returned bytes (unused)
-        if (::ReadDirectoryChangesW(_Mydir, _Mybuf, _Max_buffer_size, false,
-            FILE_NOTIFY_CHANGE_LAST_WRITE, &_Bytes, &_Myovl, nullptr) == 0) {
-            return error;
-        }
+    void* directory_watcher::native_handle() const noexcept {
+        return _Mydir;
+    }
+
+    bool directory_watcher::request_changes() noexcept {
+        // Note: The directory handle is attached to a completion port, so no event is needed,
+        //       the completion wakes up the thread that waits for the port.
+        _Myovl     = OVERLAPPED{};
+        _Mypending = ::ReadDirectoryChangesW(_Mydir, _Mybuf, _Max_buffer_size, false,
+            FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, &_Myovl, nullptr) != 0;
+        return _Mypending;
+    }
 
-        switch (::WaitForMultipleObjects(2, _Events, false, 0xFFFF'FFFF)) {
-        case 0: // notified by directory's event (WAIT_OBJECT_0)
-            return _Should_notify(
-                reinterpret_cast<FILE_NOTIFY_INFORMATION*>(_Mybuf)) ? update_required : continue_wait;
-        case 1: // notified by thread's event (WAIT_OBJECT_0 + 1)
-            return stop_watching;
-        default: // error occured
-            return error;
-        };
+    bool directory_watcher::is_update_required(const unsigned long _Bytes) noexcept {
+        // Note: No bytes are reported if the changes didn't fit into the buffer, then the database
+        //       may have changed as well.
+        _Mypending = false;
+        return _Bytes == 0 || _Should_notify(reinterpret_cast<FILE_NOTIFY_INFORMATION*>(_Mybuf));
     }
 } // namespace mjx
\ No newline at end of file
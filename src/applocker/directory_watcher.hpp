@@ -8,7 +8,6 @@
 #define _APPLOCKER_DIRECTORY_WATCHER_HPP_
 #include <dbmgr/tinywin.hpp>
 #include <mjstr/char_traits.hpp>
-#include <mjsync/waitable_event.hpp>
 
 namespace mjx {
     template <class _Elem, size_t _Size>
@@ -18,34 +17,25 @@ namespace mjx {
 
     class directory_watcher { // class for database file observation
     public:
-        directory_watcher(waitable_event& _Event) noexcept;
+        directory_watcher() noexcept;
         ~directory_watcher() noexcept;
 
-        directory_watcher()                                    = delete;
         directory_watcher(const directory_watcher&)            = delete;
         directory_watcher& operator=(const directory_watcher&) = delete;
 
-        enum wait_result : unsigned char {
-            error,
-            stop_watching,
-            continue_wait,
-            update_required
-        };
-
         // checks if the watcher is watching
         bool is_watching() const noexcept;
 
-        // waits for some directory changes
-        wait_result wait_for_changes() noexcept;
+        // returns the directory handle, its changes complete to the port it's attached to
+        void* native_handle() const noexcept;
 
-    private:
-        struct _Notification_events {
-            explicit _Notification_events(waitable_event& _Event) noexcept;
+        // starts waiting for the next directory change
+        bool request_changes() noexcept;
 
-            waitable_event& _Thread_event;
-            waitable_event _Dir_event;
-        };
+        // checks if the completed change requires the database to be reloaded
+        bool is_update_required(const unsigned long _Bytes) noexcept;
 
+    private:
         // Note: The max buffer size used by ReadDirectoryChangesW() can be calculated using this
         //       equation: sizeof(FILE_NOTIFY_INFORMATION) + (strlen(filename) * sizeof(wchar_t)).
         //       It is correct since we are only interested in one file (apps.db).
@@ -65,8 +55,8 @@ namespace mjx {
 
         void* _Mydir;
         byte_t _Mybuf[_Max_buffer_size];
-        _Notification_events _Myevents;
         OVERLAPPED _Myovl;
+        bool _Mypending; // true if a request is in progress
     };
 } // namespace mjx
 
@@ -0,0 +1,70 @@
+// event_loop.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <applocker/event_loop.hpp>
+#include <dbmgr/tinywin.hpp>
+
+namespace mjx {
+    bool _Event_batch::_Has(const _Event_source _Source) const noexcept {
+        return (_Ready & static_cast<uint32_t>(_Source)) != 0;
+    }
+
+    _Event_loop::_Event_loop() noexcept
+        : _Myport(::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1)), _Mypending() {
+        for (::std::atomic<bool>& _Pending : _Mypending) {
+            _Pending.store(false, ::std::memory_order_relaxed);
+        }
+    }
+
+    _Event_loop::~_Event_loop() noexcept {
+        if (_Myport) {
+            ::CloseHandle(_Myport);
+            _Myport = nullptr;
+        }
+    }
+
+    size_t _Event_loop::_Posted_index(const _Event_source _Source) noexcept {
+        return _Source == _Event_source::_State ? 0 : 1;
+    }
+
+    bool _Event_loop::_Valid() const noexcept {
+        return _Myport != nullptr;
+    }
+
+    bool _Event_loop::_Attach(void* const _Handle, const _Event_source _Source) noexcept {
+        return ::CreateIoCompletionPort(_Handle, _Myport, static_cast<ULONG_PTR>(_Source), 0) == _Myport;
+    }
+
+    void _Event_loop::_Notify(const _Event_source _Source) noexcept {
+        if (!_Mypending[_Posted_index(_Source)].exchange(true, ::std::memory_order_acq_rel)) { // not queued yet
+            ::PostQueuedCompletionStatus(_Myport, 0, static_cast<ULONG_PTR>(_Source), nullptr);
+        }
+    }
+
+    _Event_batch _Event_loop::_Wait(const uint32_t _Timeout) noexcept {
+        // Note: The pending flag is cleared before the source is handled, so a notification that
+        //       arrives meanwhile is posted again and never lost.
+        OVERLAPPED_ENTRY _Entries[_Event_loop_traits::_Batch_size];
+        unsigned long _Count = 0;
+        _Event_batch _Batch  = {0, 0};
+        if (!::GetQueuedCompletionStatusEx(_Myport, _Entries,
+            static_cast<unsigned long>(_Event_loop_traits::_Batch_size), &_Count, _Timeout, false)) {
+            return _Batch; // timeout elapsed
+        }
+
+        _Event_source _Source;
+        for (unsigned long _Idx = 0; _Idx < _Count; ++_Idx) {
+            _Source        = static_cast<_Event_source>(_Entries[_Idx].lpCompletionKey);
+            _Batch._Ready |= static_cast<uint32_t>(_Source);
+            if (_Source == _Event_source::_Directory) {
+                _Batch._Directory_bytes = _Entries[_Idx].dwNumberOfBytesTransferred;
+            } else {
+                _Mypending[_Posted_index(_Source)].store(false, ::std::memory_order_release);
+            }
+        }
+
+        return _Batch;
+    }
+} // namespace mjx
\ No newline at end of file
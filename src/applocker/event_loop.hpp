@@ -0,0 +1,65 @@
+// event_loop.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_EVENT_LOOP_HPP_
+#define _APPLOCKER_EVENT_LOOP_HPP_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mjx {
+    enum class _Event_source : unsigned char { // also used as the completion key
+        _State     = 1, // the service state has changed
+        _Task      = 2, // new processes have been queued or a rescan has been requested
+        _Directory = 4 // the database directory has changed
+    };
+
+    struct _Event_loop_traits {
+        // Note: All sources complete to a single I/O completion port, so the service thread sleeps in one
+        //       wait and wakes up only when a source is ready or the timer expires. The posted sources are
+        //       coalesced, a source that's already queued isn't posted again until the loop dequeues it.
+        static constexpr size_t _Batch_size   = 8; // completions dequeued at once
+        static constexpr size_t _Posted_count = 2; // number of sources that can be posted (_State and _Task)
+    };
+
+    struct _Event_batch { // sources that are ready
+        uint32_t _Ready; // combination of _Event_source values
+        unsigned long _Directory_bytes; // bytes reported by the directory change, valid if it's ready
+
+        // checks if the source is ready
+        bool _Has(const _Event_source _Source) const noexcept;
+    };
+
+    class _Event_loop { // waits for all the service event sources at once
+    public:
+        _Event_loop() noexcept;
+        ~_Event_loop() noexcept;
+
+        _Event_loop(const _Event_loop&)            = delete;
+        _Event_loop& operator=(const _Event_loop&) = delete;
+
+        // checks if the completion port has been created
+        bool _Valid() const noexcept;
+
+        // attaches the overlapped handle, its I/O completes as the selected source
+        bool _Attach(void* const _Handle, const _Event_source _Source) noexcept;
+
+        // marks the source as ready, wakes up the waiting thread
+        void _Notify(const _Event_source _Source) noexcept;
+
+        // waits until any source is ready or the timeout elapses (then no source is ready)
+        _Event_batch _Wait(const uint32_t _Timeout) noexcept;
+
+    private:
+        // returns the index of the posted source
+        static size_t _Posted_index(const _Event_source _Source) noexcept;
+
+        void* _Myport;
+        ::std::atomic<bool> _Mypending[_Event_loop_traits::_Posted_count]; // true if the source is queued
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_EVENT_LOOP_HPP_
\ No newline at end of file
@@ -26,10 +26,16 @@ namespace mjx {
         return &_Mystg;
     }
 
-    _Event_sink::_Event_sink(waitable_event& _Event) noexcept : _Myrefs(1), _Myevent(_Event) {}
+    _Event_sink::_Event_sink(_Event_loop& _Loop) noexcept : _Myrefs(1), _Myloop(_Loop) {}
 
     _Event_sink::~_Event_sink() noexcept {}
 
+    bool _Event_sink::_Is_exit_event(IWbemClassObject* const _Obj) noexcept {
+        _Variant _Val;
+        return _Obj->Get(L"__CLASS", 0, _Val._Get(), nullptr, nullptr) == 0 && _Val._Get()->bstrVal
+            && unicode_string_view{_Val._Get()->bstrVal} == L"__InstanceDeletionEvent";
+    }
+
     IWbemClassObject* _Event_sink::_Get_target_instance(
         IWbemClassObject* const _Obj, _Variant& _Val) noexcept {
         return _Obj->Get(L"TargetInstance", 0, _Val._Get(), nullptr, nullptr) == 0
@@ -42,10 +48,15 @@ namespace mjx {
             ? _Val._Get()->uintVal : 0;
     }
 
-    checksum_t _Event_sink::_Get_process_module_checksum(IWbemClassObject* const _Inst) noexcept {
+    uint32_t _Event_sink::_Get_parent_process_id(IWbemClassObject* const _Inst) noexcept {
         _Variant _Val;
-        return _Inst->Get(L"Name", 0, _Val._Get(), nullptr, nullptr) == 0
-            ? compute_checksum(_Val._Get()->bstrVal) : 0;
+        return _Inst->Get(L"ParentProcessId", 0, _Val._Get(), nullptr, nullptr) == 0
+            ? _Val._Get()->uintVal : 0;
+    }
+
+    const wchar_t* _Event_sink::_Get_process_module_name(IWbemClassObject* const _Inst, _Variant& _Val) noexcept {
+        return _Inst->Get(L"Name", 0, _Val._Get(), nullptr, nullptr) == 0 && _Val._Get()->bstrVal
+            ? _Val._Get()->bstrVal : nullptr;
     }
 
     _Event_sink::_Ref_t __stdcall _Event_sink::AddRef() {
@@ -72,21 +83,80 @@ namespace mjx {
     }
 
     long __stdcall _Event_sink::Indicate(long _Count, IWbemClassObject** _Objects) {
+        // Note: The snapshot is taken once per batch, so all the processes are screened against
+        //       the same reload, even if a new one is published in the meantime.
+        _Service_shared_cache& _Cache = _Service_shared_cache::_Get();
+        const auto _Locked            = _Cache._Locked._Get();
+        const bool _Limit_instances   = _Cache._Limit_instances.load(::std::memory_order_relaxed);
         _Process_list _Procs;
         IWbemClassObject* _Inst;
+        const wchar_t* _Name;
         _Process_traits::_Basic_data _Data;
+        bool _Limited;
         for (long _Idx = 0; _Idx < _Count; ++_Idx) {
             _Variant _Val;
+            _Variant _Name_val;
             _Inst = _Get_target_instance(_Objects[_Idx], _Val);
-            if (_Inst) {
-                _Data._Id              = _Get_process_id(_Inst);
-                _Data._Module_checksum = _Get_process_module_checksum(_Inst);
-                _Procs.push_back(_Data);
+            if (!_Inst) {
+                continue;
             }
+
+            _Data._Id = _Get_process_id(_Inst);
+            if (_Is_exit_event(_Objects[_Idx])) { // only the process tree and the instance counters are interested
+                _Cache._Tree._Remove(_Data._Id);
+                if (_Limit_instances) {
+                    _Cache._Instances._Remove(_Data._Id);
+                }
+
+                continue;
+            }
+
+            // Note: The process is protected only if its image is a critical system executable,
+            //       which is checked right before it's terminated. A process without a name is still
+            //       passed on, since the rules match it by its image path.
+            _Name = _Get_process_module_name(_Inst, _Name_val);
+            if (_Cache._Tree._Insert(_Data._Id, _Get_parent_process_id(_Inst))) {
+                _Cache._Tree._Terminate(_Data._Id, audit_reason::descendant, 0); // spawned by a terminated process
+                continue;
+            }
+
+            _Data._Module_checksum = _Name ? compute_checksum(_Name, _Locked->_Mode) : 0;
+            if (_Cache._Respawns._Hit(_Data._Module_checksum)) { // relaunched in a loop, terminate on sight
+                _Cache._Tree._Terminate(_Data._Id, audit_reason::respawn, _Data._Module_checksum);
+                continue;
+            }
+
+            _Limited = _Limit_instances && _Cache._Instances._Is_limited(_Data._Module_checksum);
+            // Note: The rules don't match by the name checksum, so if there are any,
+            //       all new processes must be passed to the task's thread. The same applies
+            //       to the allow-list mode, since the filter can't prove that a process is listed.
+            if (_Limited || _Locked->_Allow_list || _Locked->_Match_rules
+                || _Locked->_Filter.may_contain(_Data._Module_checksum)) {
+                if (_Limited && _Cache._Instances._Add(_Data._Id, _Data._Module_checksum)) {
+                    // the newest instance exceeds the limit
+                    _Cache._Tree._Terminate(_Data._Id, audit_reason::instance_limit, _Data._Module_checksum);
+                } else {
+                    _Procs.push_back(_Data);
+                }
+            }
+        }
+
+        // Note: If the task's thread falls so far behind that the queue is full, the remaining processes
+        //       are dropped and the thread scans all running processes instead, so none of them is missed.
+        if (!_Procs.empty()) {
+            {
+                lock_guard _Guard(_Cache._Ingest_lock);
+                for (const _Process_traits::_Basic_data& _Proc : _Procs) {
+                    if (!_Cache._Ingest_queue._Push(_Proc)) {
+                        _Cache._Rescan.store(true, ::std::memory_order_release);
+                        break;
+                    }
+                }
+            }
+
+            _Myloop._Notify(_Event_source::_Task); // notify that new processes have been created
         }
 
-        _Service_shared_cache::_Get()._New_procs._Assign(::std::move(_Procs));
-        _Myevent.notify(); // notify that new processes have been created
         return WBEM_S_NO_ERROR;
     }
 
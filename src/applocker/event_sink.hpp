@@ -6,9 +6,9 @@
 #pragma once
 #ifndef _APPLOCKER_EVENT_SINK_HPP_
 #define _APPLOCKER_EVENT_SINK_HPP_
+#include <applocker/event_loop.hpp>
 #include <applocker/process.hpp>
 #include <guiddef.h>
-#include <mjsync/waitable_event.hpp>
 #include <WbemIdl.h>
 
 namespace mjx {
@@ -31,7 +31,7 @@ namespace mjx {
     public:
         using _Ref_t = unsigned long;
 
-        explicit _Event_sink(waitable_event& _Event) noexcept;
+        explicit _Event_sink(_Event_loop& _Loop) noexcept;
         ~_Event_sink() noexcept;
 
         // increments the reference count
@@ -43,7 +43,7 @@ namespace mjx {
         // queries another interface from this class
         long __stdcall QueryInterface(const IID& _Id, void** _Obj) override;
 
-        // receives notification objects (notifies waiting thread)
+        // receives notification objects (wakes up the task's thread)
         long __stdcall Indicate(long _Count, IWbemClassObject** _Objects) override;
 
         // changes the current status (does nothing)
@@ -51,6 +51,9 @@ namespace mjx {
             long _Flags, long _Result, wchar_t* _Param, IWbemClassObject* _Obj) override;
 
     private:
+        // checks if the event reports the process exit
+        static bool _Is_exit_event(IWbemClassObject* const _Obj) noexcept;
+
         // obtains the process instance
         static IWbemClassObject* _Get_target_instance(
             IWbemClassObject* const _Obj, _Variant& _Val) noexcept;
@@ -58,11 +61,14 @@ namespace mjx {
         // obtains the process ID from the target instance
         static uint32_t _Get_process_id(IWbemClassObject* const _Inst) noexcept;
 
-        // obtains the process module checksum from the target instance
-        static checksum_t _Get_process_module_checksum(IWbemClassObject* const _Inst) noexcept;
+        // obtains the parent process ID from the target instance
+        static uint32_t _Get_parent_process_id(IWbemClassObject* const _Inst) noexcept;
+
+        // obtains the process module name from the target instance
+        static const wchar_t* _Get_process_module_name(IWbemClassObject* const _Inst, _Variant& _Val) noexcept;
 
         _Ref_t _Myrefs;
-        waitable_event& _Myevent;
+        _Event_loop& _Myloop;
     };
 } // namespace mjx
 
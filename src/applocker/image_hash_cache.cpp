@@ -0,0 +1,142 @@
+// image_hash_cache.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <applocker/image_hash_cache.hpp>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/database.hpp>
+#include <dbmgr/tinywin.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+#include <vector>
+
+namespace mjx {
+    path _Image_cache_traits::_Get_file_path() {
+        return database_location::current().directory() / L"images.cache";
+    }
+
+    _Image_hash_cache::_Image_hash_cache()
+        : _Myentries(), _Mypath(_Image_cache_traits::_Get_file_path()),
+        _Mylast_save(::GetTickCount64()), _Mydirty(false) {
+        _Load();
+    }
+
+    _Image_hash_cache::~_Image_hash_cache() noexcept {
+        _Save();
+    }
+
+    void _Image_hash_cache::_Load() {
+        file _File(_Mypath, file_access::read, file_share::read);
+        file_stream _Stream(_File);
+        if (!_Stream.is_open()) { // no cache yet
+            return;
+        }
+
+        _Image_cache_traits::_File_header _Header;
+        if (_Stream.read(reinterpret_cast<byte_t*>(&_Header), sizeof(_Header)) != sizeof(_Header)
+            || _Header._Magic != _Image_cache_traits::_Magic || _Header._Version != _Image_cache_traits::_Version
+            || _Header._Reserved != 0 || _Header._Count > _Image_cache_traits::_Max_count
+            || _File.size() != sizeof(_Header) + _Header._Count * sizeof(_Image_cache_traits::_File_record)) {
+            return; // unknown or truncated file, start with an empty cache
+        }
+
+        const size_t _Size = _Header._Count * sizeof(_Image_cache_traits::_File_record);
+        ::std::vector<_Image_cache_traits::_File_record> _Records(_Header._Count);
+        if (_Stream.read(reinterpret_cast<byte_t*>(_Records.data()), _Size) != _Size
+            || static_cast<uint32_t>(compute_checksum(byte_string_view{
+                reinterpret_cast<const byte_t*>(_Records.data()), _Size})) != _Header._Checksum) {
+            return; // corrupted records
+        }
+
+        _Myentries.reserve(_Records.size());
+        for (const _Image_cache_traits::_File_record& _Record : _Records) {
+            _Myentries.emplace(_Image_cache_traits::_Key{_Record._File_index, _Record._Volume},
+                _Image_cache_traits::_Value{_Record._Last_write, _Record._Size, _Record._Hash});
+        }
+    }
+
+    bool _Image_hash_cache::_Get_hash(const path& _Path, image_hash& _Hash) {
+        // Note: The file stays open while it's being checked, so it can't be replaced between
+        //       reading its identity and hashing it.
+        file _File(_Path, file_access::read, file_share::all);
+        BY_HANDLE_FILE_INFORMATION _Info;
+        if (!_File.is_open() || !::GetFileInformationByHandle(_File.native_handle(), &_Info)) {
+            return false;
+        }
+
+        const _Image_cache_traits::_Key _Key = {(static_cast<uint64_t>(_Info.nFileIndexHigh) << 32)
+            | _Info.nFileIndexLow, static_cast<uint32_t>(_Info.dwVolumeSerialNumber)};
+        const uint64_t _Last_write = (static_cast<uint64_t>(_Info.ftLastWriteTime.dwHighDateTime) << 32)
+            | _Info.ftLastWriteTime.dwLowDateTime;
+        const uint64_t _Size       = (static_cast<uint64_t>(_Info.nFileSizeHigh) << 32) | _Info.nFileSizeLow;
+        const auto _Iter           = _Myentries.find(_Key);
+        if (_Iter != _Myentries.end() && _Iter->second._Last_write == _Last_write && _Iter->second._Size == _Size) {
+            _Hash = _Iter->second._Hash; // the file hasn't changed since it was hashed
+            return true;
+        }
+
+        if (!::mjx::compute_image_hash(_File.native_handle(), _Size, _Hash)) {
+            return false;
+        }
+
+        if (_Iter != _Myentries.end()) { // the file has changed, replace its hash
+            _Iter->second = _Image_cache_traits::_Value{_Last_write, _Size, _Hash};
+        } else {
+            if (_Myentries.size() >= _Image_cache_traits::_Max_count) { // cache full, start over
+                _Myentries.clear();
+            }
+
+            _Myentries.emplace(_Key, _Image_cache_traits::_Value{_Last_write, _Size, _Hash});
+        }
+
+        _Mydirty = true;
+        return true;
+    }
+
+    void _Image_hash_cache::_Save_if_due() noexcept {
+        if (_Mydirty && ::GetTickCount64() - _Mylast_save >= _Image_cache_traits::_Save_period) {
+            _Save();
+        }
+    }
+
+    void _Image_hash_cache::_Save() noexcept {
+        if (!_Mydirty) { // nothing has changed
+            return;
+        }
+
+        _Mylast_save = ::GetTickCount64();
+        ::std::vector<_Image_cache_traits::_File_record> _Records;
+        try {
+            _Records.reserve(_Myentries.size());
+        } catch (...) {
+            return; // try again later
+        }
+
+        _Image_cache_traits::_File_record _Record = {};
+        for (const auto& _Pair : _Myentries) {
+            _Record._File_index = _Pair.first._File_index;
+            _Record._Volume     = _Pair.first._Volume;
+            _Record._Last_write = _Pair.second._Last_write;
+            _Record._Size       = _Pair.second._Size;
+            _Record._Hash       = _Pair.second._Hash;
+            _Records.push_back(_Record);
+        }
+
+        const size_t _Size                        = _Records.size() * sizeof(_Image_cache_traits::_File_record);
+        _Image_cache_traits::_File_header _Header = {};
+        _Header._Magic                            = _Image_cache_traits::_Magic;
+        _Header._Version                          = _Image_cache_traits::_Version;
+        _Header._Count                            = static_cast<uint32_t>(_Records.size());
+        _Header._Checksum                         = static_cast<uint32_t>(compute_checksum(
+            byte_string_view{reinterpret_cast<const byte_t*>(_Records.data()), _Size}));
+        file _File(_Mypath, file_access::write);
+        file_stream _Stream(_File);
+        if (_Stream.is_open() && _File.resize(0)) { // must be empty
+            if (_Stream.write(reinterpret_cast<const byte_t*>(&_Header), sizeof(_Header))
+                && _Stream.write(reinterpret_cast<const byte_t*>(_Records.data()), _Size)) {
+                _Mydirty = false;
+            }
+        }
+    }
+} // namespace mjx
\ No newline at end of file
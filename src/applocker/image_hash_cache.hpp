@@ -0,0 +1,100 @@
+// image_hash_cache.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_IMAGE_HASH_CACHE_HPP_
+#define _APPLOCKER_IMAGE_HASH_CACHE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/image_hash.hpp>
+#include <mjfs/path.hpp>
+#include <unordered_map>
+
+namespace mjx {
+    struct _Image_cache_traits {
+        // Note: Hashing an executable is orders of magnitude slower than checking its identity,
+        //       so the hashes are cached by the file identity (volume serial number and file index),
+        //       and validated by the last write time and size. The cache is persisted, so the images
+        //       aren't hashed again after the service restarts.
+        struct _Key {
+            uint64_t _File_index;
+            uint32_t _Volume;
+
+            bool operator==(const _Key& _Other) const noexcept {
+                return _File_index == _Other._File_index && _Volume == _Other._Volume;
+            }
+        };
+
+        struct _Key_hash {
+            size_t operator()(const _Key& _Val) const noexcept {
+                return static_cast<size_t>(_Val._File_index ^ (static_cast<uint64_t>(_Val._Volume) << 32));
+            }
+        };
+
+        struct _Value {
+            uint64_t _Last_write; // FILETIME of the last write
+            uint64_t _Size; // file size (in bytes)
+            image_hash _Hash;
+        };
+
+        struct _File_header {
+            uint32_t _Magic; // always _Magic
+            uint16_t _Version; // always _Version
+            uint16_t _Reserved; // must be zero
+            uint32_t _Count; // number of records
+            uint32_t _Checksum; // CRC-32C of the records
+        };
+
+        struct _File_record {
+            uint64_t _File_index;
+            uint32_t _Volume;
+            uint32_t _Reserved; // must be zero
+            uint64_t _Last_write;
+            uint64_t _Size;
+            image_hash _Hash;
+        };
+
+        static_assert(sizeof(_File_header) == 16, "_File_header must be 16 bytes long");
+        static_assert(sizeof(_File_record) == 64, "_File_record must be 64 bytes long");
+
+        static constexpr uint32_t _Magic       = 0x4349'4C41; // "ALIC" in little-endian order
+        static constexpr uint16_t _Version     = 1;
+        static constexpr size_t _Max_count     = 65536; // the cache is cleared once it's full
+        static constexpr uint64_t _Save_period = 60'000; // minimum time between two saves (in milliseconds)
+
+        // returns a path to the cache file
+        static path _Get_file_path();
+    };
+
+    class _Image_hash_cache { // cache of executable image hashes, used by a single thread
+    public:
+        _Image_hash_cache();
+        ~_Image_hash_cache() noexcept;
+
+        _Image_hash_cache(const _Image_hash_cache&)            = delete;
+        _Image_hash_cache& operator=(const _Image_hash_cache&) = delete;
+
+        // retrieves the hash of the selected file, computes it if necessary
+        bool _Get_hash(const path& _Path, image_hash& _Hash);
+
+        // saves the cache if it has changed and the save period has elapsed
+        void _Save_if_due() noexcept;
+
+        // saves the cache if it has changed
+        void _Save() noexcept;
+
+    private:
+        // loads the cache from the file, ignores invalid files
+        void _Load();
+
+        ::std::unordered_map<_Image_cache_traits::_Key, _Image_cache_traits::_Value,
+            _Image_cache_traits::_Key_hash> _Myentries;
+        path _Mypath; // path to the cache file
+        uint64_t _Mylast_save; // tick count of the last save
+        bool _Mydirty; // true if the cache has changed since the last save
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_IMAGE_HASH_CACHE_HPP_
\ No newline at end of file
@@ -0,0 +1,110 @@
+// instance_counter.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <applocker/instance_counter.hpp>
+
+namespace mjx {
+    _Instance_counter::_Instance_counter() noexcept : _Myindex(), _Mycounters(), _Myprocs(), _Mylock() {}
+
+    _Instance_counter::~_Instance_counter() noexcept {}
+
+    bool _Instance_counter::_Empty() const noexcept {
+        shared_lock_guard _Guard(_Mylock);
+        return _Mycounters.empty();
+    }
+
+    bool _Instance_counter::_Is_limited(const checksum_t _Checksum) const noexcept {
+        shared_lock_guard _Guard(_Mylock);
+        return _Myindex.find(_Checksum) != _Myindex.end();
+    }
+
+    ::std::vector<_Instance_counter::_Excess_instance> _Instance_counter::_Reset(
+        const ::std::vector<instance_limit>& _Limits, const _Process_list& _Procs) {
+        // Note: The running instances are counted once, when the limits change. If an application
+        //       already runs more instances than allowed, the newest ones exceed the limit.
+        struct _Instance {
+            uint64_t _Created;
+            uint32_t _Id;
+            checksum_t _Checksum;
+            size_t _Counter;
+        };
+
+        ::std::unordered_map<checksum_t, size_t> _Index;
+        ::std::vector<_Counter> _Counters;
+        for (const instance_limit& _Limit : _Limits) {
+            if (_Index.emplace(_Limit.checksum, _Counters.size()).second) {
+                _Counters.push_back(_Counter{_Limit.limit, 0});
+            }
+        }
+
+        ::std::vector<_Instance> _Instances;
+        if (!_Counters.empty()) {
+            for (const _Process_traits::_Basic_data& _Proc : _Procs) {
+                const auto _Iter = _Index.find(_Proc._Module_checksum);
+                if (_Iter != _Index.end()) {
+                    _Instances.push_back(_Instance{_Process_traits::_Get_creation_time(_Proc._Id),
+                        _Proc._Id, _Proc._Module_checksum, _Iter->second});
+                }
+            }
+        }
+
+        ::std::sort(_Instances.begin(), _Instances.end(), // the oldest instances are counted first
+            [](const _Instance& _Left, const _Instance& _Right) noexcept { return _Left._Created < _Right._Created; });
+        ::std::unordered_map<uint32_t, size_t> _Running;
+        ::std::vector<_Excess_instance> _Excess;
+        for (const _Instance& _Inst : _Instances) {
+            _Counter& _Entry = _Counters[_Inst._Counter];
+            if (_Entry._Count < _Entry._Limit) {
+                ++_Entry._Count;
+                _Running.emplace(_Inst._Id, _Inst._Counter);
+            } else {
+                _Excess.push_back(_Excess_instance{_Inst._Id, _Inst._Checksum});
+            }
+        }
+
+        lock_guard _Guard(_Mylock);
+        _Myindex.swap(_Index);
+        _Mycounters.swap(_Counters);
+        _Myprocs.swap(_Running);
+        return _Excess;
+    }
+
+    bool _Instance_counter::_Add(const uint32_t _Id, const checksum_t _Checksum) {
+        lock_guard _Guard(_Mylock);
+        const auto _Iter = _Myindex.find(_Checksum);
+        if (_Iter == _Myindex.end()) { // not limited
+            return false;
+        }
+
+        const auto _Proc = _Myprocs.find(_Id);
+        if (_Proc != _Myprocs.end()) {
+            if (_Proc->second == _Iter->second) { // already counted (e.g. by _Reset())
+                return false;
+            }
+
+            --_Mycounters[_Proc->second]._Count; // the ID has been reused, the exit event was missed
+            _Myprocs.erase(_Proc);
+        }
+
+        _Counter& _Entry = _Mycounters[_Iter->second];
+        if (_Entry._Count >= _Entry._Limit) { // the newest instance exceeds the limit
+            return true;
+        }
+
+        ++_Entry._Count;
+        _Myprocs.emplace(_Id, _Iter->second);
+        return false;
+    }
+
+    void _Instance_counter::_Remove(const uint32_t _Id) noexcept {
+        lock_guard _Guard(_Mylock);
+        const auto _Iter = _Myprocs.find(_Id);
+        if (_Iter != _Myprocs.end()) {
+            --_Mycounters[_Iter->second]._Count;
+            _Myprocs.erase(_Iter);
+        }
+    }
+} // namespace mjx
\ No newline at end of file
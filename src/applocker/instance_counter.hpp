@@ -0,0 +1,63 @@
+// instance_counter.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_INSTANCE_COUNTER_HPP_
+#define _APPLOCKER_INSTANCE_COUNTER_HPP_
+#include <applocker/process.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/instance_limit.hpp>
+#include <mjsync/srwlock.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace mjx {
+    class _Instance_counter { // live number of running instances of the limited applications
+    public:
+        struct _Excess_instance { // instance over the limit of its application
+            uint32_t _Id;
+            checksum_t _Checksum;
+        };
+
+        _Instance_counter() noexcept;
+        ~_Instance_counter() noexcept;
+
+        _Instance_counter(const _Instance_counter&)            = delete;
+        _Instance_counter& operator=(const _Instance_counter&) = delete;
+
+        // checks if there are no limits
+        bool _Empty() const noexcept;
+
+        // checks if the application is limited
+        bool _Is_limited(const checksum_t _Checksum) const noexcept;
+
+        // replaces the limits and counts the running processes, returns the instances over the limits
+        ::std::vector<_Excess_instance> _Reset(
+            const ::std::vector<instance_limit>& _Limits, const _Process_list& _Procs);
+
+        // counts the new process, returns true if it exceeds the limit (it isn't counted then)
+        bool _Add(const uint32_t _Id, const checksum_t _Checksum);
+
+        // stops counting the process
+        void _Remove(const uint32_t _Id) noexcept;
+
+    private:
+        struct _Counter {
+            uint32_t _Limit;
+            uint32_t _Count;
+        };
+
+        // Note: Only the instances of the limited applications are tracked, so both maps stay small
+        //       and each creation or exit event costs a single lookup.
+        ::std::unordered_map<checksum_t, size_t> _Myindex; // checksum -> index of its counter
+        ::std::vector<_Counter> _Mycounters;
+        ::std::unordered_map<uint32_t, size_t> _Myprocs; // process ID -> index of its counter
+        mutable shared_lock _Mylock; // creation and exit events are delivered on different threads
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_INSTANCE_COUNTER_HPP_
\ No newline at end of file
@@ -0,0 +1,13 @@
+// interpreter.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <applocker/interpreter.hpp>
+
+namespace mjx {
+    bool _Interpreter_traits::_Is_interpreter(const unicode_string_view _Name) noexcept {
+        return ::std::binary_search(_Interpreters.begin(), _Interpreters.end(), compute_checksum(_Name, _Mode));
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,51 @@
+// interpreter.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_INTERPRETER_HPP_
+#define _APPLOCKER_INTERPRETER_HPP_
+#include <applocker/protected_process.hpp>
+#include <array>
+#include <dbmgr/checksum.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    struct _Interpreter_traits {
+        // Note: Interpreters run arbitrary workloads under a generic name, so only their command lines
+        //       tell the workloads apart. Querying the command line needs another handle to the process,
+        //       so the command line rules are checked only for the known interpreters.
+        static constexpr checksum_mode _Mode = checksum_mode::case_insensitive;
+
+        // checks if the process is a known interpreter
+        static bool _Is_interpreter(const unicode_string_view _Name) noexcept;
+    };
+
+    inline constexpr ::std::array<checksum_t, 18> _Interpreters = _Protected_process_traits::_Sort(
+        ::std::array<checksum_t, 18>{
+            compute_static_checksum(L"bash.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"cmd.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"cscript.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"java.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"javaw.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"mshta.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"node.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"perl.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"php.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"powershell.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"powershell_ise.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"pwsh.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"py.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"python.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"pythonw.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"pyw.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"ruby.exe", _Interpreter_traits::_Mode),
+            compute_static_checksum(L"wscript.exe", _Interpreter_traits::_Mode)
+        });
+
+    static_assert(_Protected_process_traits::_Is_strictly_sorted(_Interpreters),
+        "the interpreters must be sorted and unique");
+} // namespace mjx
+
+#endif // _APPLOCKER_INTERPRETER_HPP_
\ No newline at end of file
@@ -0,0 +1,19 @@
+// pipeline.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <applocker/pipeline.hpp>
+#include <dbmgr/tinywin.hpp>
+
+namespace mjx {
+    void _Pipeline_traits::_Set_ideal_processor(void* const _Thread, const size_t _Stage) noexcept {
+        // Note: The ideal processor is only a hint for the scheduler, unlike a hard affinity it never
+        //       keeps a stage waiting for a busy core. On a single-core system the hint is pointless.
+        SYSTEM_INFO _Info;
+        ::GetSystemInfo(&_Info);
+        if (_Thread && _Info.dwNumberOfProcessors > 1) {
+            ::SetThreadIdealProcessor(_Thread, static_cast<unsigned long>(_Stage % _Info.dwNumberOfProcessors));
+        }
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,107 @@
+// pipeline.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_PIPELINE_HPP_
+#define _APPLOCKER_PIPELINE_HPP_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/audit_log.hpp>
+#include <dbmgr/checksum.hpp>
+
+namespace mjx {
+    struct _Pipeline_traits {
+        // Note: The processes pass through three stages - the event sink hashes and screens the new processes,
+        //       the task's thread matches them against the locked applications and the rules, and
+        //       the enforcement thread terminates them. The stages are connected by bounded queues,
+        //       so a slow stage (e.g. image hashing) doesn't stall the event delivery or the terminations.
+        static constexpr size_t _Ingest_capacity  = 4096; // processes waiting for the task's thread
+        static constexpr size_t _Enforce_capacity = 1024; // processes waiting for the enforcement thread
+
+        // processors preferred by the stages, the event sink runs on the WMI threads
+        static constexpr size_t _Match_stage   = 1;
+        static constexpr size_t _Enforce_stage = 2;
+
+        // prefers the selected processor for the thread, so the stages run on different cores
+        static void _Set_ideal_processor(void* const _Thread, const size_t _Stage) noexcept;
+    };
+
+    struct _Verdict { // process to be terminated
+        uint32_t _Id;
+        uint32_t _Generation; // generation of the hot set the verdict is based on
+        checksum_t _Checksum;
+        audit_reason _Reason; // only the applications locked by the checksum may become hot
+    };
+
+    template <class _Ty, size_t _Capacity>
+    class _Spsc_queue { // bounded lock-free queue with a single producer and a single consumer
+    public:
+        static_assert((_Capacity & (_Capacity - 1)) == 0, "_Capacity must be a power of 2");
+
+        _Spsc_queue() noexcept : _Myhead(0), _Mytail(0), _Mypeak(0), _Myoverflows(0), _Myslots() {}
+
+        ~_Spsc_queue() noexcept {}
+
+        _Spsc_queue(const _Spsc_queue&)            = delete;
+        _Spsc_queue& operator=(const _Spsc_queue&) = delete;
+
+        // appends the value, returns false if the queue is full (called only by the producer)
+        bool _Push(const _Ty& _Val) noexcept {
+            const size_t _Tail = _Mytail.load(::std::memory_order_relaxed);
+            const size_t _Size = _Tail - _Myhead.load(::std::memory_order_acquire);
+            if (_Size == _Capacity) {
+                _Myoverflows.fetch_add(1, ::std::memory_order_relaxed);
+                return false;
+            }
+
+            _Myslots[_Tail & (_Capacity - 1)] = _Val;
+            _Mytail.store(_Tail + 1, ::std::memory_order_release); // publish the slot
+            if (_Size + 1 > _Mypeak.load(::std::memory_order_relaxed)) {
+                _Mypeak.store(_Size + 1, ::std::memory_order_relaxed);
+            }
+
+            return true;
+        }
+
+        // removes the oldest value, returns false if the queue is empty (called only by the consumer)
+        bool _Pop(_Ty& _Val) noexcept {
+            const size_t _Head = _Myhead.load(::std::memory_order_relaxed);
+            if (_Head == _Mytail.load(::std::memory_order_acquire)) {
+                return false;
+            }
+
+            _Val = _Myslots[_Head & (_Capacity - 1)];
+            _Myhead.store(_Head + 1, ::std::memory_order_release); // release the slot
+            return true;
+        }
+
+        // returns the current number of values
+        size_t _Depth() const noexcept {
+            return _Mytail.load(::std::memory_order_relaxed) - _Myhead.load(::std::memory_order_relaxed);
+        }
+
+        // returns the largest number of values seen so far
+        size_t _Peak_depth() const noexcept {
+            return _Mypeak.load(::std::memory_order_relaxed);
+        }
+
+        // returns the number of values rejected because the queue was full
+        size_t _Overflows() const noexcept {
+            return _Myoverflows.load(::std::memory_order_relaxed);
+        }
+
+    private:
+        // Note: The head and the tail are written by different threads, so they're kept
+        //       on separate cache lines to avoid false sharing.
+        alignas(64) ::std::atomic<size_t> _Myhead; // written by the consumer
+        alignas(64) ::std::atomic<size_t> _Mytail; // written by the producer
+        ::std::atomic<size_t> _Mypeak; // written by the producer
+        ::std::atomic<size_t> _Myoverflows; // written by the producer
+        alignas(64) _Ty _Myslots[_Capacity];
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_PIPELINE_HPP_
\ No newline at end of file
@@ -4,8 +4,11 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <applocker/process.hpp>
+#include <cstring>
 #include <dbmgr/tinywin.hpp>
 #include <TlHelp32.h>
+#include <vector>
+#include <winternl.h>
 
 namespace mjx {
     _Toolhelp_snapshot::_Toolhelp_snapshot() noexcept : _Handle(_Create()) {}
@@ -25,7 +28,7 @@ namespace mjx {
         return _Handle != nullptr && _Handle != INVALID_HANDLE_VALUE;
     }
 
-    _Process_traits::_Process_list _Process_traits::_Get_process_list() {
+    _Process_traits::_Process_list _Process_traits::_Get_process_list(const checksum_mode _Mode) {
         _Toolhelp_snapshot _Snapshot;
         if (!_Snapshot._Valid()) {
             return _Process_list{};
@@ -38,7 +41,7 @@ namespace mjx {
         _Basic_data _Data;
         while (_Next) {
             _Data._Id              = _Entry.th32ProcessID;
-            _Data._Module_checksum = compute_checksum(_Entry.szExeFile);
+            _Data._Module_checksum = compute_checksum(_Entry.szExeFile, _Mode);
             _List.push_back(_Data);
             _Next = ::Process32NextW(_Snapshot._Handle, &_Entry);
         }
@@ -46,11 +49,127 @@ namespace mjx {
         return _List;
     }
 
-    void _Process_traits::_Terminate(const uint32_t _Id) noexcept {
-        void* const _Handle = ::OpenProcess(PROCESS_TERMINATE, false, _Id);
-        if (_Handle) { // valid process, try to terminate
-            ::TerminateProcess(_Handle, 0);
-            ::CloseHandle(_Handle);
+    ::std::vector<_Process_traits::_Tree_data> _Process_traits::_Get_process_tree() {
+        _Toolhelp_snapshot _Snapshot;
+        if (!_Snapshot._Valid()) {
+            return ::std::vector<_Tree_data>{};
+        }
+
+        PROCESSENTRY32W _Entry = {0};
+        _Entry.dwSize          = sizeof(PROCESSENTRY32W);
+        bool _Next             = ::Process32FirstW(_Snapshot._Handle, &_Entry);
+        ::std::vector<_Tree_data> _List;
+        _Tree_data _Data;
+        while (_Next) {
+            _Data._Id        = _Entry.th32ProcessID;
+            _Data._Parent_id = _Entry.th32ParentProcessID;
+            _Data._Created   = _Get_creation_time(_Entry.th32ProcessID);
+            _List.push_back(_Data);
+            _Next = ::Process32NextW(_Snapshot._Handle, &_Entry);
+        }
+
+        return _List;
+    }
+
+    bool _Process_traits::_Get_image_path(const uint32_t _Id, path::string_type& _Path) {
+        // Note: Limited information is enough to query the image path, and unlike full query access
+        //       it's granted for most of the processes.
+        void* const _Handle = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, false, _Id);
+        if (!_Handle) { // process already terminated or inaccessible
+            return false;
+        }
+
+        size_t _Buf_size = 260; // MAX_PATH
+        unsigned long _Copied; // number of elements copied into the buffer
+        bool _Succeeded;
+        for (;;) {
+            _Path.resize(_Buf_size);
+            _Copied    = static_cast<unsigned long>(_Buf_size);
+            _Succeeded = ::QueryFullProcessImageNameW(_Handle, 0, _Path.data(), &_Copied) != 0;
+            if (_Succeeded || ::GetLastError() != ERROR_INSUFFICIENT_BUFFER || _Buf_size >= 32768) {
+                break;
+            }
+
+            _Buf_size *= 2; // increase the buffer and try again
+        }
+
+        ::CloseHandle(_Handle);
+        if (_Succeeded) {
+            _Path.resize(_Copied);
         }
+
+        return _Succeeded;
+    }
+
+    uint64_t _Process_traits::_Get_creation_time(const uint32_t _Id) noexcept {
+        void* const _Handle = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, false, _Id);
+        if (!_Handle) { // process already terminated or inaccessible
+            return 0;
+        }
+
+        FILETIME _Times[4]; // creation, exit, kernel and user time
+        const bool _Succeeded = ::GetProcessTimes(_Handle, &_Times[0], &_Times[1], &_Times[2], &_Times[3]) != 0;
+        ::CloseHandle(_Handle);
+        return _Succeeded ? (static_cast<uint64_t>(_Times[0].dwHighDateTime) << 32) | _Times[0].dwLowDateTime : 0;
+    }
+
+    bool _Process_traits::_Get_command_line(const uint32_t _Id, unicode_string& _Command_line) {
+        // Note: ProcessCommandLineInformation (Windows 8.1+) copies the command line out of the process,
+        //       and, unlike reading its PEB, it needs just limited information access. The function
+        //       isn't exported by any import library, so it's resolved once at runtime.
+        using _Query_fn = long(__stdcall*)(void*, PROCESSINFOCLASS, void*, unsigned long, unsigned long*);
+        static constexpr PROCESSINFOCLASS _Command_line_class = static_cast<PROCESSINFOCLASS>(60);
+        static constexpr long _Length_mismatch                = static_cast<long>(0xC000'0004);
+        static const _Query_fn _Query                         = reinterpret_cast<_Query_fn>(
+            ::GetProcAddress(::GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationProcess"));
+        if (!_Query) {
+            return false;
+        }
+
+        void* const _Handle = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, false, _Id);
+        if (!_Handle) { // process already terminated or inaccessible
+            return false;
+        }
+
+        ::std::vector<unsigned char> _Buf(1024);
+        unsigned long _Required = 0;
+        long _Status            = _Query(
+            _Handle, _Command_line_class, _Buf.data(), static_cast<unsigned long>(_Buf.size()), &_Required);
+        if (_Status == _Length_mismatch && _Required > _Buf.size()) { // the command line is longer, try again
+            _Buf.resize(_Required);
+            _Status = _Query(
+                _Handle, _Command_line_class, _Buf.data(), static_cast<unsigned long>(_Buf.size()), &_Required);
+        }
+
+        ::CloseHandle(_Handle);
+        if (_Status < 0) { // NT_SUCCESS() failed
+            return false;
+        }
+
+        const UNICODE_STRING* const _Str = reinterpret_cast<const UNICODE_STRING*>(_Buf.data());
+        _Command_line.resize(_Str->Length / sizeof(wchar_t));
+        ::memcpy(_Command_line.data(), _Str->Buffer, _Str->Length);
+        return true;
+    }
+
+    audit_outcome _Process_traits::_Terminate(const uint32_t _Id) noexcept {
+        // Note: TerminateProcess() fails with ERROR_ACCESS_DENIED if the process is already exiting,
+        //       so a failure is reported only if the process is still running afterwards.
+        void* const _Handle = ::OpenProcess(PROCESS_TERMINATE | SYNCHRONIZE, false, _Id);
+        if (!_Handle) { // an invalid identifier means that the process no longer exists
+            return ::GetLastError() == ERROR_INVALID_PARAMETER ? audit_outcome::exited : audit_outcome::failed;
+        }
+
+        audit_outcome _Outcome;
+        if (::TerminateProcess(_Handle, 0)) {
+            _Outcome = audit_outcome::terminated;
+        } else if (::WaitForSingleObject(_Handle, 0) == WAIT_OBJECT_0) { // exited on its own
+            _Outcome = audit_outcome::exited;
+        } else {
+            _Outcome = audit_outcome::failed;
+        }
+
+        ::CloseHandle(_Handle);
+        return _Outcome;
     }
 } // namespace mjx
\ No newline at end of file
@@ -7,7 +7,10 @@
 #ifndef _APPLOCKER_PROCESS_HPP_
 #define _APPLOCKER_PROCESS_HPP_
 #include <cstdint>
+#include <dbmgr/audit_log.hpp>
 #include <dbmgr/checksum.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
 #include <vector>
 
 namespace mjx {
@@ -32,13 +35,31 @@ namespace mjx {
             checksum_t _Module_checksum; // process image file checksum
         };
 
+        struct _Tree_data {
+            uint32_t _Id; // process ID (PID)
+            uint32_t _Parent_id; // parent process ID, may refer to an exited process
+            uint64_t _Created; // creation time (in FILETIME ticks), or 0 if it's inaccessible
+        };
+
         using _Process_list = ::std::vector<_Basic_data>;
 
         // returns basic data of all running processes
-        static _Process_list _Get_process_list();
+        static _Process_list _Get_process_list(const checksum_mode _Mode);
+
+        // returns the parent links of all running processes
+        static ::std::vector<_Tree_data> _Get_process_tree();
+
+        // retrieves the full path of the process image file
+        static bool _Get_image_path(const uint32_t _Id, path::string_type& _Path);
+
+        // returns the creation time of the process (in FILETIME ticks), or 0 if it's inaccessible
+        static uint64_t _Get_creation_time(const uint32_t _Id) noexcept;
+
+        // retrieves the command line of the process
+        static bool _Get_command_line(const uint32_t _Id, unicode_string& _Command_line);
 
         // terminates the specified process
-        static void _Terminate(const uint32_t _Id) noexcept;
+        static audit_outcome _Terminate(const uint32_t _Id) noexcept;
     };
 
     using _Process_list = _Process_traits::_Process_list;
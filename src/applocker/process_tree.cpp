@@ -0,0 +1,223 @@
+// process_tree.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <applocker/process_tree.hpp>
+#include <applocker/protected_process.hpp>
+
+namespace mjx {
+    _Process_tree::_Process_tree(_Audit_queue& _Audit) noexcept
+        : _Mynodes(), _Myfree(), _Myindex(), _Myrecent(), _Myrecent_pos(0), _Myaudit(_Audit), _Mylock() {
+        ::std::fill(_Myrecent, _Myrecent + _Process_tree_traits::_Recent_count, _Process_tree_traits::_None);
+    }
+
+    _Process_tree::~_Process_tree() noexcept {}
+
+    uint32_t _Process_tree::_Allocate(const uint32_t _Id, const uint32_t _Parent) {
+        uint32_t _Node_idx;
+        if (!_Myfree.empty()) {
+            _Node_idx = _Myfree.back();
+            _Myfree.pop_back();
+        } else {
+            _Node_idx = static_cast<uint32_t>(_Mynodes.size());
+            _Mynodes.emplace_back();
+        }
+
+        _Node& _New  = _Mynodes[_Node_idx];
+        _New._Id     = _Id;
+        _New._Parent = _Parent;
+        _New._Child  = _Process_tree_traits::_None;
+        _New._Prev   = _Process_tree_traits::_None;
+        _New._Next   = _Process_tree_traits::_None;
+        _New._Doomed = false;
+        if (_Parent != _Process_tree_traits::_None) { // link as the first child
+            _Node& _Owner = _Mynodes[_Parent];
+            _New._Next    = _Owner._Child;
+            if (_Owner._Child != _Process_tree_traits::_None) {
+                _Mynodes[_Owner._Child]._Prev = _Node_idx;
+            }
+
+            _Owner._Child = _Node_idx;
+        }
+
+        _Myindex[_Id] = _Node_idx;
+        return _Node_idx;
+    }
+
+    void _Process_tree::_Release(const uint32_t _Node_idx) noexcept {
+        _Node& _Old = _Mynodes[_Node_idx];
+        if (_Old._Prev != _Process_tree_traits::_None) {
+            _Mynodes[_Old._Prev]._Next = _Old._Next;
+        } else if (_Old._Parent != _Process_tree_traits::_None) {
+            _Mynodes[_Old._Parent]._Child = _Old._Next;
+        }
+
+        if (_Old._Next != _Process_tree_traits::_None) {
+            _Mynodes[_Old._Next]._Prev = _Old._Prev;
+        }
+
+        uint32_t _Next;
+        for (uint32_t _Child = _Old._Child; _Child != _Process_tree_traits::_None; _Child = _Next) {
+            _Node& _Orphan  = _Mynodes[_Child];
+            _Next           = _Orphan._Next;
+            _Orphan._Parent = _Process_tree_traits::_None;
+            _Orphan._Prev   = _Process_tree_traits::_None;
+            _Orphan._Next   = _Process_tree_traits::_None;
+        }
+
+        _Myindex.erase(_Old._Id);
+        _Myfree.push_back(_Node_idx);
+    }
+
+    bool _Process_tree::_Is_recent(const uint32_t _Id) const noexcept {
+        return ::std::find(_Myrecent, _Myrecent + _Process_tree_traits::_Recent_count, _Id)
+            != _Myrecent + _Process_tree_traits::_Recent_count;
+    }
+
+    void _Process_tree::_Forget_recent(const uint32_t _Id) noexcept {
+        ::std::replace(_Myrecent, _Myrecent + _Process_tree_traits::_Recent_count, _Id, _Process_tree_traits::_None);
+    }
+
+    void _Process_tree::_Remember_recent(const uint32_t _Id) noexcept {
+        if (!_Is_recent(_Id)) {
+            _Myrecent[_Myrecent_pos] = _Id;
+            _Myrecent_pos            = (_Myrecent_pos + 1) % _Process_tree_traits::_Recent_count;
+        }
+    }
+
+    void _Process_tree::_Reset(::std::vector<_Process_traits::_Tree_data>&& _Procs) {
+        // Note: The parent ID reported by the system isn't cleared when the parent exits, so it may refer
+        //       to an unrelated process that reused the ID. Such a process is always newer than the child.
+        //       The processes are inserted from the oldest one, and a child is linked only to a parent
+        //       that has already been inserted. The processes whose creation time is unknown are skipped.
+        _Procs.erase(::std::remove_if(_Procs.begin(), _Procs.end(),
+            [](const _Process_traits::_Tree_data& _Proc) noexcept { return _Proc._Created == 0; }), _Procs.end());
+        ::std::sort(_Procs.begin(), _Procs.end(),
+            [](const _Process_traits::_Tree_data& _Left, const _Process_traits::_Tree_data& _Right) noexcept {
+                return _Left._Created < _Right._Created;
+            });
+        lock_guard _Guard(_Mylock);
+        _Mynodes.clear();
+        _Myfree.clear();
+        _Myindex.clear();
+        _Mynodes.reserve(_Procs.size());
+        _Myindex.reserve(_Procs.size());
+        for (const _Process_traits::_Tree_data& _Proc : _Procs) {
+            const auto _Iter = _Proc._Parent_id != _Proc._Id ? _Myindex.find(_Proc._Parent_id) : _Myindex.end();
+            _Allocate(_Proc._Id, _Iter != _Myindex.end() ? _Iter->second : _Process_tree_traits::_None);
+        }
+    }
+
+    bool _Process_tree::_Insert(const uint32_t _Id, const uint32_t _Parent_id) {
+        lock_guard _Guard(_Mylock);
+        auto _Iter = _Myindex.find(_Id);
+        if (_Iter != _Myindex.end()) { // the ID has been reused, the exit event was missed
+            _Release(_Iter->second);
+        }
+
+        _Forget_recent(_Id);
+        _Iter              = _Parent_id != _Id ? _Myindex.find(_Parent_id) : _Myindex.end();
+        const bool _Linked = _Iter != _Myindex.end();
+        const bool _Doomed       = _Linked ? _Mynodes[_Iter->second]._Doomed : _Is_recent(_Parent_id);
+        const uint32_t _Node_idx = _Allocate(_Id, _Linked ? _Iter->second : _Process_tree_traits::_None);
+        _Mynodes[_Node_idx]._Doomed = _Doomed;
+        return _Doomed;
+    }
+
+    void _Process_tree::_Remove(const uint32_t _Id) noexcept {
+        lock_guard _Guard(_Mylock);
+        const auto _Iter = _Myindex.find(_Id);
+        if (_Iter != _Myindex.end()) {
+            if (_Mynodes[_Iter->second]._Doomed) { // its children may still be reported
+                _Remember_recent(_Id);
+            }
+
+            _Release(_Iter->second);
+        }
+    }
+
+    bool _Process_tree::_Terminate(const uint32_t _Id, const audit_reason _Reason, const checksum_t _Checksum) {
+        // Note: The processes are terminated after the lock is released, so the events aren't blocked
+        //       by the system calls. The descendants are recorded with the checksum of the locked application.
+        if (_Protected_process_traits::_Is_protected(_Id)) { // never terminate system processes
+            return false;
+        }
+
+        const ::std::vector<uint32_t> _Ids = _Doom(_Id, &_Protected_process_traits::_Is_protected);
+        for (size_t _Idx = 0; _Idx < _Ids.size(); ++_Idx) {
+            _Myaudit._Append(_Ids[_Idx], _Idx == 0 ? _Reason : audit_reason::descendant,
+                _Checksum, _Process_traits::_Terminate(_Ids[_Idx]));
+        }
+
+        return true;
+    }
+
+    ::std::vector<uint32_t> _Process_tree::_Doom(const uint32_t _Id, const _Protection_check _Is_protected) {
+        // Note: The subtree is collected in the breadth-first order, so the parents are terminated
+        //       before their children and can't spawn new ones meanwhile. The protection queries
+        //       the image path, so it's checked after the lock is released, and the subtree is walked
+        //       again until all its processes have been checked. A protected process is neither marked
+        //       nor walked through, so the processes it starts later aren't terminated either.
+        //       The processes started during the last checks are left alone, they're never marked
+        //       without being checked.
+        ::std::vector<uint32_t> _Ids;
+        ::std::vector<uint32_t> _Queue;
+        ::std::vector<uint32_t> _Unchecked;
+        ::std::vector<uint32_t> _Protected; // sorted
+        ::std::vector<uint32_t> _Permitted; // sorted
+        for (size_t _Walk = 1;; ++_Walk) {
+            {
+                lock_guard _Guard(_Mylock);
+                const auto _Iter = _Myindex.find(_Id);
+                if (_Iter == _Myindex.end()) { // unknown process, its children may still be reported
+                    _Remember_recent(_Id);
+                    _Ids.push_back(_Id);
+                    return _Ids;
+                }
+
+                const bool _Last = _Walk == _Process_tree_traits::_Max_walks;
+                _Queue.assign(1, _Iter->second);
+                _Unchecked.clear();
+                for (size_t _Pos = 0; _Pos < _Queue.size(); ++_Pos) {
+                    for (uint32_t _Child = _Mynodes[_Queue[_Pos]]._Child; _Child != _Process_tree_traits::_None
+                        && _Queue.size() < _Process_tree_traits::_Max_subtree; _Child = _Mynodes[_Child]._Next) {
+                        const uint32_t _Child_id = _Mynodes[_Child]._Id;
+                        if (_Mynodes[_Child]._Doomed // already terminated
+                            || ::std::binary_search(_Protected.begin(), _Protected.end(), _Child_id)) {
+                            continue;
+                        }
+
+                        if (!::std::binary_search(_Permitted.begin(), _Permitted.end(), _Child_id)) {
+                            if (_Last) { // no time left to check it
+                                continue;
+                            }
+
+                            _Unchecked.push_back(_Child_id);
+                        }
+
+                        _Queue.push_back(_Child);
+                    }
+                }
+
+                if (_Unchecked.empty()) { // all processes have been checked, mark them
+                    _Ids.reserve(_Queue.size());
+                    for (const uint32_t _Node_idx : _Queue) {
+                        _Mynodes[_Node_idx]._Doomed = true;
+                        _Ids.push_back(_Mynodes[_Node_idx]._Id);
+                    }
+
+                    return _Ids;
+                }
+            }
+
+            for (const uint32_t _Child_id : _Unchecked) {
+                (_Is_protected(_Child_id) ? _Protected : _Permitted).push_back(_Child_id);
+            }
+
+            ::std::sort(_Protected.begin(), _Protected.end());
+            ::std::sort(_Permitted.begin(), _Permitted.end());
+        }
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,93 @@
+// process_tree.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_PROCESS_TREE_HPP_
+#define _APPLOCKER_PROCESS_TREE_HPP_
+#include <applocker/audit_queue.hpp>
+#include <applocker/process.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <mjsync/srwlock.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace mjx {
+    struct _Process_tree_traits {
+        // Note: A subtree is terminated in a single pass, the walk visits at most _Max_subtree processes,
+        //       so the time spent under the lock stays bounded even for a runaway process spawner.
+        //       The identifiers of the recently terminated processes are kept, so that a child reported
+        //       after its parent's exit is still recognized and terminated.
+        static constexpr size_t _Max_subtree  = 4096;
+        static constexpr size_t _Recent_count = 64;
+        static constexpr size_t _Max_walks    = 3; // walks of the subtree until all descendants are checked
+        static constexpr uint32_t _None       = UINT32_MAX; // no node
+    };
+
+    class _Process_tree { // parent/child links of the running processes
+    public:
+        using _Protection_check = bool (*)(const uint32_t _Id);
+
+        explicit _Process_tree(_Audit_queue& _Audit) noexcept;
+        ~_Process_tree() noexcept;
+
+        _Process_tree(const _Process_tree&)            = delete;
+        _Process_tree& operator=(const _Process_tree&) = delete;
+
+        // replaces the tree with the running processes
+        void _Reset(::std::vector<_Process_traits::_Tree_data>&& _Procs);
+
+        // adds the new process, returns true if its parent has been terminated (it must be terminated too)
+        bool _Insert(const uint32_t _Id, const uint32_t _Parent_id);
+
+        // removes the process, its children become roots
+        void _Remove(const uint32_t _Id) noexcept;
+
+        // terminates the process and all its descendants (except the protected ones), parents first,
+        // returns false if the process itself is protected
+        bool _Terminate(const uint32_t _Id, const audit_reason _Reason, const checksum_t _Checksum);
+
+        // marks the process and its descendants as terminated, skips the protected descendants
+        // and their subtrees, returns the marked processes, parents first (the process itself isn't checked)
+        ::std::vector<uint32_t> _Doom(const uint32_t _Id, const _Protection_check _Is_protected);
+
+    private:
+        struct _Node {
+            uint32_t _Id;
+            uint32_t _Parent; // index of the parent node
+            uint32_t _Child; // index of the first child node
+            uint32_t _Prev; // index of the previous sibling node
+            uint32_t _Next; // index of the next sibling node
+            bool _Doomed; // already terminated, its new children are terminated as well
+        };
+
+        // allocates a new node linked to the selected parent
+        uint32_t _Allocate(const uint32_t _Id, const uint32_t _Parent);
+
+        // unlinks the node from its parent and children and releases it
+        void _Release(const uint32_t _Node_idx) noexcept;
+
+        // checks if the process has been terminated recently
+        bool _Is_recent(const uint32_t _Id) const noexcept;
+
+        // forgets the recently terminated process (its identifier has been reused)
+        void _Forget_recent(const uint32_t _Id) noexcept;
+
+        // remembers the terminated process
+        void _Remember_recent(const uint32_t _Id) noexcept;
+
+        // Note: The nodes are kept in a pool and linked through their indices, so linking and unlinking
+        //       a process doesn't allocate and walking a subtree touches only its own nodes.
+        ::std::vector<_Node> _Mynodes;
+        ::std::vector<uint32_t> _Myfree; // indices of the released nodes
+        ::std::unordered_map<uint32_t, uint32_t> _Myindex; // process ID -> index of its node
+        uint32_t _Myrecent[_Process_tree_traits::_Recent_count]; // recently terminated processes (ring buffer)
+        size_t _Myrecent_pos;
+        _Audit_queue& _Myaudit; // receives a record for each terminated process
+        shared_lock _Mylock; // creation and exit events are delivered on different threads
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_PROCESS_TREE_HPP_
\ No newline at end of file
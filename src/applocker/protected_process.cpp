@@ -0,0 +1,94 @@
+// protected_process.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <applocker/process.hpp>
+#include <applocker/protected_process.hpp>
+#include <dbmgr/path_trie.hpp>
+#include <dbmgr/tinywin.hpp>
+
+namespace mjx {
+    bool _Protected_process_traits::_Is_same_path(
+        const unicode_string_view _Left, const unicode_string_view _Right) noexcept {
+        return !_Left.empty() && _Left.size() == _Right.size() && ::CompareStringOrdinal(_Left.data(),
+            static_cast<int>(_Left.size()), _Right.data(), static_cast<int>(_Right.size()), true) == CSTR_EQUAL;
+    }
+
+    const path::string_type& _Protected_process_traits::_Get_system_directory() {
+        static const path::string_type _Dir = [] {
+            path::string_type _Result(260, L'\0'); // MAX_PATH
+            unsigned int _Length = ::GetSystemDirectoryW(_Result.data(), static_cast<unsigned int>(_Result.size()));
+            if (_Length >= _Result.size()) { // increase the buffer and try again
+                _Result.resize(_Length);
+                _Length = ::GetSystemDirectoryW(_Result.data(), static_cast<unsigned int>(_Result.size()));
+            }
+
+            _Result.resize(_Length < _Result.size() ? _Length : 0); // empty if the directory is unknown
+            return _Result;
+        }();
+        return _Dir;
+    }
+
+    const path::string_type& _Protected_process_traits::_Get_service_path() {
+        static const path::string_type _Path = [] {
+            path::string_type _Result(260, L'\0'); // MAX_PATH
+            unsigned long _Copied; // number of elements copied into the buffer
+            for (;;) {
+                _Copied = ::GetModuleFileNameW(nullptr, _Result.data(), static_cast<unsigned long>(_Result.size()));
+                if (_Copied < _Result.size() || _Result.size() >= 32768) {
+                    break;
+                }
+
+                _Result.resize(_Result.size() * 2); // increase the buffer and try again
+            }
+
+            _Result.resize(_Copied < _Result.size() ? _Copied : 0); // empty if the path is unknown
+            return _Result;
+        }();
+        return _Path;
+    }
+
+    bool _Protected_process_traits::_Is_protected(const uint32_t _Id) {
+        if (_Id == _Idle_process_id || _Id == _System_process_id) {
+            return true;
+        }
+
+        path::string_type _Path;
+        if (!_Process_traits::_Get_image_path(_Id, _Path)) { // process already terminated or inaccessible
+            return false;
+        }
+
+        if (_Is_same_path(_Path, _Get_service_path())) {
+            return true;
+        }
+
+        const wchar_t* const _First = _Path.data();
+        const wchar_t* _Name_first  = _First + _Path.size();
+        while (_Name_first != _First && !_Path_trie_traits::_Is_separator(_Name_first[-1])) {
+            --_Name_first;
+        }
+
+        if (_Name_first == _First) { // not a full path
+            return false;
+        }
+
+        const unicode_string_view _Dir{_First, static_cast<size_t>(_Name_first - _First) - 1};
+        const unicode_string_view _Name{_Name_first, _Path.size() - static_cast<size_t>(_Name_first - _First)};
+        return _Is_same_path(_Dir, _Get_system_directory()) && ::std::binary_search(
+            _Protected_processes.begin(), _Protected_processes.end(), compute_checksum(_Name, _Mode));
+    }
+
+    const ::std::array<checksum_t, _Protected_process_traits::_Essential_count>&
+        _Protected_process_traits::_Get_essential(const checksum_mode _Mode) noexcept {
+        if (_Has_bits(_Mode, checksum_mode::wide)) {
+            return _Has_bits(_Mode, checksum_mode::case_insensitive)
+                ? _Essential_processes<checksum_mode::case_insensitive | checksum_mode::wide>
+                : _Essential_processes<checksum_mode::wide>;
+        } else {
+            return _Has_bits(_Mode, checksum_mode::case_insensitive)
+                ? _Essential_processes<checksum_mode::case_insensitive> : _Essential_processes<checksum_mode::exact>;
+        }
+    }
+} // namespace mjx
\ No newline at end of file
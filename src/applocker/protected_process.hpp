@@ -0,0 +1,129 @@
+// protected_process.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_PROTECTED_PROCESS_HPP_
+#define _APPLOCKER_PROTECTED_PROCESS_HPP_
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    struct _Protected_process_traits {
+        // Note: Critical system processes must never be terminated, even if they're locked by mistake,
+        //       since terminating any of them crashes or destabilizes the system. A name alone proves
+        //       nothing, any executable can be renamed, so a process is protected only if its image
+        //       is one of these names in the system directory, or the service itself. The names are hashed
+        //       at compile time with case-insensitive CRC-32C, regardless of the database checksum mode.
+        //       The check queries the image path, so it's done only right before a termination.
+        static constexpr checksum_mode _Mode         = checksum_mode::case_insensitive;
+        static constexpr uint32_t _Idle_process_id   = 0; // has no image, can't be terminated
+        static constexpr uint32_t _System_process_id = 4; // has no image, can't be terminated
+
+        // Note: In the allow-list mode, the processes the user session can't work without are permitted
+        //       as well. They're hashed at compile time with every checksum mode, so the selected set can be
+        //       merged into the permitted entries and the lookup stays the same. The names use the same
+        //       letter case as their image files, since the exact mode compares the names as they are.
+        static constexpr size_t _Essential_count = 21;
+
+        // sorts the checksums at compile time (insertion sort, the table is small)
+        template <size_t _Size>
+        static constexpr ::std::array<checksum_t, _Size> _Sort(::std::array<checksum_t, _Size> _Checksums) noexcept {
+            for (size_t _Idx = 1; _Idx < _Size; ++_Idx) {
+                const checksum_t _Val = _Checksums[_Idx];
+                size_t _Pos           = _Idx;
+                for (; _Pos > 0 && _Checksums[_Pos - 1] > _Val; --_Pos) {
+                    _Checksums[_Pos] = _Checksums[_Pos - 1];
+                }
+
+                _Checksums[_Pos] = _Val;
+            }
+
+            return _Checksums;
+        }
+
+        // checks if the checksums are sorted and unique
+        template <size_t _Size>
+        static constexpr bool _Is_strictly_sorted(const ::std::array<checksum_t, _Size>& _Checksums) noexcept {
+            for (size_t _Idx = 1; _Idx < _Size; ++_Idx) {
+                if (_Checksums[_Idx - 1] >= _Checksums[_Idx]) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // checks if both paths are equal (case-insensitive)
+        static bool _Is_same_path(const unicode_string_view _Left, const unicode_string_view _Right) noexcept;
+
+        // returns the path to the system directory (e.g. C:\Windows\System32), computed once
+        static const path::string_type& _Get_system_directory();
+
+        // returns the path to the service executable, computed once
+        static const path::string_type& _Get_service_path();
+
+        // checks if the process must never be terminated (queries its image path)
+        static bool _Is_protected(const uint32_t _Id);
+
+        // returns the checksums of the processes permitted in the allow-list mode
+        static const ::std::array<checksum_t, _Essential_count>& _Get_essential(const checksum_mode _Mode) noexcept;
+    };
+
+    inline constexpr ::std::array<checksum_t, 10> _Protected_processes = _Protected_process_traits::_Sort(
+        ::std::array<checksum_t, 10>{
+            compute_static_checksum(L"csrss.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"dwm.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"fontdrvhost.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"lsaiso.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"lsass.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"services.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"smss.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"svchost.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"wininit.exe", _Protected_process_traits::_Mode),
+            compute_static_checksum(L"winlogon.exe", _Protected_process_traits::_Mode)
+        });
+
+    static_assert(_Protected_process_traits::_Is_strictly_sorted(_Protected_processes),
+        "the protected processes must be sorted and unique");
+
+    template <checksum_mode _Mode>
+    inline constexpr ::std::array<checksum_t, _Protected_process_traits::_Essential_count> _Essential_processes =
+        _Protected_process_traits::_Sort(::std::array<checksum_t, _Protected_process_traits::_Essential_count>{
+            compute_static_checksum(L"[System Process]", _Mode), // the idle process
+            compute_static_checksum(L"audiodg.exe", _Mode),
+            compute_static_checksum(L"conhost.exe", _Mode),
+            compute_static_checksum(L"consent.exe", _Mode), // UAC prompt
+            compute_static_checksum(L"ctfmon.exe", _Mode),
+            compute_static_checksum(L"dbmgr.exe", _Mode), // the allow list must stay manageable
+            compute_static_checksum(L"dllhost.exe", _Mode),
+            compute_static_checksum(L"explorer.exe", _Mode),
+            compute_static_checksum(L"LogonUI.exe", _Mode),
+            compute_static_checksum(L"MsMpEng.exe", _Mode),
+            compute_static_checksum(L"RuntimeBroker.exe", _Mode),
+            compute_static_checksum(L"SearchHost.exe", _Mode),
+            compute_static_checksum(L"ShellExperienceHost.exe", _Mode),
+            compute_static_checksum(L"sihost.exe", _Mode),
+            compute_static_checksum(L"spoolsv.exe", _Mode),
+            compute_static_checksum(L"StartMenuExperienceHost.exe", _Mode),
+            compute_static_checksum(L"taskhostw.exe", _Mode),
+            compute_static_checksum(L"TextInputHost.exe", _Mode),
+            compute_static_checksum(L"userinit.exe", _Mode),
+            compute_static_checksum(L"WmiPrvSE.exe", _Mode), // process events are delivered through WMI
+            compute_static_checksum(L"WUDFHost.exe", _Mode)
+        });
+
+    static_assert(_Protected_process_traits::_Is_strictly_sorted(_Essential_processes<checksum_mode::exact>)
+        && _Protected_process_traits::_Is_strictly_sorted(_Essential_processes<checksum_mode::case_insensitive>)
+        && _Protected_process_traits::_Is_strictly_sorted(_Essential_processes<checksum_mode::wide>)
+        && _Protected_process_traits::_Is_strictly_sorted(
+            _Essential_processes<checksum_mode::case_insensitive | checksum_mode::wide>),
+        "the essential processes must be sorted and unique");
+} // namespace mjx
+
+#endif // _APPLOCKER_PROTECTED_PROCESS_HPP_
\ No newline at end of file
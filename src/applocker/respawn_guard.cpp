@@ -0,0 +1,182 @@
+// respawn_guard.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <applocker/respawn_guard.hpp>
+#include <cstring>
+#include <dbmgr/tinywin.hpp>
+#include <memory>
+#include <vector>
+
+namespace mjx {
+    uint64_t _Respawn_guard_traits::_Get_system_time() noexcept {
+        FILETIME _Time;
+        ::GetSystemTimeAsFileTime(&_Time);
+        return (static_cast<uint64_t>(_Time.dwHighDateTime) << 32) | _Time.dwLowDateTime;
+    }
+
+    _Respawn_guard::_Respawn_guard() noexcept
+        : _Myhot(), _Myhot_count(0), _Mygen(0), _Mystats(), _Mylast_save(::GetTickCount64()), _Mycounters(),
+        _Mydirty(false), _Mylock() {}
+
+    _Respawn_guard::~_Respawn_guard() noexcept {}
+
+    size_t _Respawn_guard::_Home_slot(const checksum_t _Checksum) noexcept {
+        // Note: The checksums are already well distributed, but the high half of a 64-bit checksum
+        //       is folded in, so both widths use all of their bits.
+        return static_cast<size_t>(_Checksum ^ (_Checksum >> 32)) & (_Respawn_guard_traits::_Hot_capacity - 1);
+    }
+
+    uint32_t _Respawn_guard::_Generation() const noexcept {
+        return _Mygen.load(::std::memory_order_acquire);
+    }
+
+    bool _Respawn_guard::_Hit(const checksum_t _Checksum) noexcept {
+        if (_Checksum == 0) { // marks an empty slot, never hot
+            return false;
+        }
+
+        size_t _Slot = _Home_slot(_Checksum);
+        checksum_t _Stored;
+        for (size_t _Probe = 0; _Probe < _Respawn_guard_traits::_Hot_capacity; ++_Probe) {
+            _Stored = _Myhot[_Slot]._Checksum.load(::std::memory_order_acquire);
+            if (_Stored == _Checksum) {
+                _Myhot[_Slot]._Kills.fetch_add(1, ::std::memory_order_relaxed);
+                _Myhot[_Slot]._Last_kill.store(_Respawn_guard_traits::_Get_system_time(), ::std::memory_order_relaxed);
+                return true;
+            } else if (_Stored == 0) { // end of the probe sequence
+                return false;
+            }
+
+            _Slot = (_Slot + 1) & (_Respawn_guard_traits::_Hot_capacity - 1);
+        }
+
+        return false;
+    }
+
+    void _Respawn_guard::_Promote(_Stats& _Entry) noexcept {
+        size_t _Slot = _Home_slot(_Entry._Record.checksum);
+        while (_Myhot[_Slot]._Checksum.load(::std::memory_order_relaxed) != 0) { // there is a free slot
+            _Slot = (_Slot + 1) & (_Respawn_guard_traits::_Hot_capacity - 1);
+        }
+
+        _Myhot[_Slot]._Kills.store(0, ::std::memory_order_relaxed);
+        _Myhot[_Slot]._Last_kill.store(_Entry._Record.last_kill, ::std::memory_order_relaxed);
+        _Myhot[_Slot]._Checksum.store(_Entry._Record.checksum, ::std::memory_order_release); // publish the slot
+        _Entry._Slot       = _Slot;
+        _Entry._Record.hot = 1;
+        ++_Myhot_count;
+    }
+
+    void _Respawn_guard::_Record(const checksum_t _Checksum, const uint32_t _Generation) {
+        const uint64_t _Now  = ::GetTickCount64();
+        const uint64_t _Time = _Respawn_guard_traits::_Get_system_time();
+        lock_guard _Guard(_Mylock);
+        auto _Iter = _Mystats.find(_Checksum);
+        if (_Iter == _Mystats.end()) {
+            if (_Mystats.size() >= _Respawn_stats_traits::_Max_count) { // too many applications, don't report
+                return;
+            }
+
+            _Iter = _Mystats.emplace(_Checksum,
+                _Stats{_Now, 0, _Respawn_guard_traits::_None, respawn_record{_Checksum, _Time, _Time, 0, 0}}).first;
+        }
+
+        _Stats& _Entry = _Iter->second;
+        if (_Now - _Entry._Window_start > _Respawn_guard_traits::_Hot_window) { // start a new window
+            _Entry._Window_start = _Now;
+            _Entry._Window_kills = 0;
+        }
+
+        ++_Entry._Window_kills;
+        ++_Entry._Record.kills;
+        _Entry._Record.last_kill = _Time;
+        _Mydirty                 = true;
+
+        // Note: The generation changes when the locked applications change, so a process terminated
+        //       by a previous version of the list can't make the application hot.
+        if (_Entry._Slot == _Respawn_guard_traits::_None && _Checksum != 0
+            && _Entry._Window_kills >= _Respawn_guard_traits::_Hot_threshold
+            && _Myhot_count < _Respawn_guard_traits::_Hot_limit
+            && _Generation == _Mygen.load(::std::memory_order_relaxed)) {
+            _Promote(_Entry);
+        }
+    }
+
+    void _Respawn_guard::_Merge_hot_kills() noexcept {
+        uint32_t _Kills;
+        for (auto& _Pair : _Mystats) {
+            _Stats& _Entry = _Pair.second;
+            if (_Entry._Slot != _Respawn_guard_traits::_None) {
+                _Kills = _Myhot[_Entry._Slot]._Kills.exchange(0, ::std::memory_order_relaxed);
+                if (_Kills > 0) {
+                    _Entry._Record.kills    += _Kills;
+                    _Entry._Record.last_kill = _Myhot[_Entry._Slot]._Last_kill.load(::std::memory_order_relaxed);
+                    _Mydirty                 = true;
+                }
+            }
+        }
+    }
+
+    void _Respawn_guard::_Invalidate() noexcept {
+        // Note: The event sink may still terminate a process of a hot application that has just been unlocked,
+        //       before the slot is cleared. That's the same race as with the previous list being used
+        //       by the task's thread.
+        lock_guard _Guard(_Mylock);
+        _Mygen.fetch_add(1, ::std::memory_order_release);
+        if (_Myhot_count == 0) { // nothing to clear
+            return;
+        }
+
+        for (_Hot_slot& _Slot : _Myhot) {
+            _Slot._Checksum.store(0, ::std::memory_order_relaxed);
+        }
+
+        _Merge_hot_kills();
+        for (auto& _Pair : _Mystats) {
+            _Pair.second._Slot       = _Respawn_guard_traits::_None;
+            _Pair.second._Record.hot = 0;
+        }
+
+        _Myhot_count = 0;
+        _Mydirty     = true;
+    }
+
+    void _Respawn_guard::_Save_if_due(const service_counters& _Counters) noexcept {
+        if (::GetTickCount64() - _Mylast_save >= _Respawn_guard_traits::_Save_period) {
+            _Save(_Counters);
+        }
+    }
+
+    void _Respawn_guard::_Save(const service_counters& _Counters) noexcept {
+        ::std::vector<respawn_record> _Records;
+        {
+            lock_guard _Guard(_Mylock);
+            _Merge_hot_kills();
+            if (!_Mydirty && ::memcmp(::std::addressof(_Counters), ::std::addressof(_Mycounters),
+                sizeof(service_counters)) == 0) { // nothing has changed
+                return;
+            }
+
+            _Mylast_save = ::GetTickCount64();
+            try {
+                _Records.reserve(_Mystats.size());
+            } catch (...) {
+                return; // try again later
+            }
+
+            for (const auto& _Pair : _Mystats) {
+                _Records.push_back(_Pair.second._Record);
+            }
+
+            _Mycounters = _Counters;
+            _Mydirty    = false;
+        }
+
+        if (!::mjx::save_respawn_stats(_Records, _Counters)) {
+            lock_guard _Guard(_Mylock);
+            _Mydirty = true; // try again later
+        }
+    }
+} // namespace mjx
\ No newline at end of file
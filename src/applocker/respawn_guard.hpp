@@ -0,0 +1,97 @@
+// respawn_guard.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_RESPAWN_GUARD_HPP_
+#define _APPLOCKER_RESPAWN_GUARD_HPP_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/respawn_stats.hpp>
+#include <mjsync/srwlock.hpp>
+#include <unordered_map>
+
+namespace mjx {
+    struct _Respawn_guard_traits {
+        // Note: An application terminated _Hot_threshold times within _Hot_window is being relaunched
+        //       in a loop (e.g. by a watchdog). It's moved to the hot set, which the event sink checks
+        //       right after hashing the name, so the next instances are terminated without passing
+        //       through the filter, the index and the task's thread. The hot set is a small open-addressing
+        //       table of atomics, so the check doesn't take any lock.
+        static constexpr uint32_t _Hot_threshold = 3;
+        static constexpr uint64_t _Hot_window    = 10'000; // in milliseconds
+        static constexpr size_t _Hot_capacity    = 64; // must be a power of 2
+        static constexpr size_t _Hot_limit       = 48; // keeps the probe sequences short
+        static constexpr uint64_t _Save_period   = 60'000; // minimum time between two saves (in milliseconds)
+        static constexpr size_t _None            = SIZE_MAX; // no slot
+
+        static_assert((_Hot_capacity & (_Hot_capacity - 1)) == 0, "_Hot_capacity must be a power of 2");
+
+        // returns the current time (in FILETIME ticks)
+        static uint64_t _Get_system_time() noexcept;
+    };
+
+    class _Respawn_guard { // detects the applications that are relaunched after being terminated
+    public:
+        _Respawn_guard() noexcept;
+        ~_Respawn_guard() noexcept;
+
+        _Respawn_guard(const _Respawn_guard&)            = delete;
+        _Respawn_guard& operator=(const _Respawn_guard&) = delete;
+
+        // returns the current generation, must be read before the locked applications
+        uint32_t _Generation() const noexcept;
+
+        // checks if the application is terminated on sight, counts the termination if so
+        bool _Hit(const checksum_t _Checksum) noexcept;
+
+        // counts the termination of a locked application, moves it to the hot set if it's relaunched in a loop
+        void _Record(const checksum_t _Checksum, const uint32_t _Generation);
+
+        // empties the hot set, must be called whenever the locked applications change
+        void _Invalidate() noexcept;
+
+        // saves the statistics and the counters if they have changed and the save period has elapsed
+        void _Save_if_due(const service_counters& _Counters) noexcept;
+
+        // saves the statistics and the counters if they have changed
+        void _Save(const service_counters& _Counters) noexcept;
+
+    private:
+        struct _Hot_slot {
+            ::std::atomic<checksum_t> _Checksum; // 0 if the slot is empty
+            ::std::atomic<uint32_t> _Kills; // terminations not yet merged into the statistics
+            ::std::atomic<uint64_t> _Last_kill; // FILETIME of the last termination
+        };
+
+        struct _Stats {
+            uint64_t _Window_start; // tick count of the first termination within the current window
+            uint32_t _Window_kills; // number of terminations within the current window
+            size_t _Slot; // index of the hot slot, or _None
+            respawn_record _Record;
+        };
+
+        // returns the first slot of the probe sequence
+        static size_t _Home_slot(const checksum_t _Checksum) noexcept;
+
+        // moves the application to the hot set
+        void _Promote(_Stats& _Entry) noexcept;
+
+        // merges the terminations counted in the hot set into the statistics
+        void _Merge_hot_kills() noexcept;
+
+        _Hot_slot _Myhot[_Respawn_guard_traits::_Hot_capacity];
+        size_t _Myhot_count;
+        ::std::atomic<uint32_t> _Mygen; // incremented whenever the hot set is emptied
+        ::std::unordered_map<checksum_t, _Stats> _Mystats;
+        uint64_t _Mylast_save; // tick count of the last save
+        service_counters _Mycounters; // counters written by the last save
+        bool _Mydirty; // true if the statistics have changed since the last save
+        shared_lock _Mylock; // serializes the writers (the task's thread and the publishers)
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_RESPAWN_GUARD_HPP_
\ No newline at end of file
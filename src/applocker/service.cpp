@@ -3,56 +3,154 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
 #include <applocker/directory_watcher.hpp>
+#include <applocker/interpreter.hpp>
 #include <applocker/service.hpp>
 #include <applocker/wmi.hpp>
 
 namespace mjx {
-    _Database_modification_handler::_Database_modification_handler() noexcept
-        : _Mycache(), _Mythread(_Create_thread(&_Mycache)) {}
+    _Schedule_timer::_Schedule_timer() noexcept
+        : _Myschedules(), _Myexpired(), _Mywheel(), _Myversion(0) {} // the cache publishes the first version
 
-    _Database_modification_handler::~_Database_modification_handler() noexcept {
+    _Schedule_timer::~_Schedule_timer() noexcept {}
+
+    uint32_t _Schedule_timer::_Update() {
+        // Note: Each schedule has a single timer, set to its next window boundary. The windows
+        //       are evaluated only when a timer expires, so the process creation is never slowed
+        //       down by the schedules.
+        _Service_shared_cache& _Shared_cache = _Service_shared_cache::_Get();
+        const uint64_t _Time                 = _Schedule_traits::_Get_local_time();
+        const uint64_t _Minute               = _Time / _Schedule_traits::_Ticks_per_minute;
+        uint64_t _Next;
+        _Myexpired.clear();
+        if (_Myversion != _Shared_cache._Schedule_version.load(::std::memory_order_relaxed)
+            || _Minute < _Mywheel.now()) { // the schedules have changed or the clock went back
+            _Myversion = _Shared_cache._Schedule_version.load(::std::memory_order_relaxed);
+            _Shared_cache._Copy_schedules(_Myschedules);
+            _Mywheel.reset(_Minute);
+            for (uint32_t _Idx = 0; _Idx < static_cast<uint32_t>(_Myschedules.size()); ++_Idx) {
+                _Myexpired.push_back(_Idx); // arm the timers of all schedules
+            }
+        } else {
+            _Mywheel.advance(_Minute, _Myexpired);
+        }
+
+        if (!_Myexpired.empty()) {
+            for (const uint32_t _Idx : _Myexpired) {
+                _Next = _Schedule_traits::_Next_change(_Myschedules[_Idx]._Window, _Minute);
+                if (_Next != _Schedule_traits::_No_change) {
+                    _Mywheel.schedule(_Next, _Idx);
+                }
+            }
+
+            if (_Shared_cache._Flip_schedules(_Minute)) { // a window opened or closed
+                // rescan running processes, like a database change, the caller runs the matching stage next
+                _Shared_cache._Rescan.store(true, ::std::memory_order_relaxed);
+            }
+        }
+
+        _Next = _Mywheel.next_deadline();
+        if (_Next == _Timer_wheel_traits::_No_deadline) { // no timers, wait for the next event
+            return waitable_event::infinite_timeout;
+        }
+
+        // wait until the next boundary (rounded up)
+        return static_cast<uint32_t>((::std::min)(_Max_wait, _Next <= _Minute ? 0
+            : (_Next * _Schedule_traits::_Ticks_per_minute - _Time + 9'999) / 10'000));
+    }
+
+    _Enforcement_handler::_Enforcement_handler() noexcept : _Myflag(), _Mythread(_Create_thread(&_Myflag)) {
+        _Pipeline_traits::_Set_ideal_processor(_Mythread, _Pipeline_traits::_Enforce_stage);
+    }
+
+    _Enforcement_handler::~_Enforcement_handler() noexcept {
         _Terminate();
     }
 
-    void* _Database_modification_handler::_Create_thread(_Thread_cache* const _Cache) noexcept {
+    void* _Enforcement_handler::_Create_thread(_Sync_flag* const _Flag) noexcept {
         return ::CreateThread(nullptr, 0,
             [](void* _Arg) -> unsigned long {
-                _Thread_cache* const _Local_cache    = static_cast<_Thread_cache*>(_Arg);
+                // Note: The statistics are saved even if nothing is queued, since the event sink counts
+                //       the terminations of the hot applications on its own.
+                _Sync_flag* const _Local_flag        = static_cast<_Sync_flag*>(_Arg);
                 _Service_shared_cache& _Shared_cache = _Service_shared_cache::_Get();
-                directory_watcher _Watcher(_Local_cache->_Event);
-                if (!_Watcher.is_watching()) { // watcher inactive, break
-                    return 0;
+                _Verdict _Next;
+                while (!_Local_flag->_Is_set()) {
+                    while (_Shared_cache._Enforce_queue._Pop(_Next)) {
+                        // take down the already spawned children too
+                        if (_Shared_cache._Tree._Terminate(_Next._Id, _Next._Reason, _Next._Checksum)
+                            && _Next._Reason == audit_reason::checksum) { // protected processes never become hot
+                            _Shared_cache._Respawns._Record(_Next._Checksum, _Next._Generation);
+                        }
+                    }
+
+                    _Shared_cache._Respawns._Save_if_due(_Shared_cache._Get_counters());
+                    _Shared_cache._Enforce_event.wait_and_reset(
+                        static_cast<uint32_t>(_Respawn_guard_traits::_Save_period));
                 }
 
-                while (!_Local_cache->_Flag._Is_set()) {
-                    switch (_Watcher.wait_for_changes()) {
-                    case directory_watcher::stop_watching: // stop watching the database
-                        _Local_cache->_Flag._Set();
-                        break;
-                    case directory_watcher::update_required: // reload the database
-                    {
-                        database& _Db = database::current();
-                        _Db.reload();
-                        _Shared_cache._Locked_apps._Assign(_Db.get_entries());
-                        _Shared_cache._Task_event.notify(); // notify task's thread about the database changes
-                        break;
+                return 0;
+            },
+            _Flag, 0, nullptr
+        );
+    }
+
+    void _Enforcement_handler::_Terminate() noexcept {
+        if (_Mythread) {
+            _Myflag._Set();
+            _Service_shared_cache::_Get()._Enforce_event.notify();
+            ::WaitForSingleObject(_Mythread, 0xFFFF'FFFF); // wait for the thread termination
+            ::CloseHandle(_Mythread);
+            _Mythread = nullptr;
+        }
+    }
+
+    _Audit_handler::_Audit_handler() noexcept : _Myflag(), _Mythread(_Create_thread(&_Myflag)) {}
+
+    _Audit_handler::~_Audit_handler() noexcept {
+        _Terminate();
+    }
+
+    void* _Audit_handler::_Create_thread(_Sync_flag* const _Flag) noexcept {
+        return ::CreateThread(nullptr, 0,
+            [](void* _Arg) -> unsigned long {
+                // Note: The records are written in large sequential appends, at most once per flush period,
+                //       unless a ring fills up. The records left in the rings are written before the thread
+                //       exits. If a partition can't be opened, the rings are still drained, so they never fill up.
+                _Sync_flag* const _Local_flag        = static_cast<_Sync_flag*>(_Arg);
+                _Service_shared_cache& _Shared_cache = _Service_shared_cache::_Get();
+                audit_log_writer _Writer;
+                ::std::vector<audit_record> _Records;
+                bool _Last = false;
+                while (!_Last) {
+                    _Last = _Local_flag->_Is_set(); // drain once more after the flag is set
+                    _Records.clear();
+                    try {
+                        _Shared_cache._Audit._Drain(_Records);
+                    } catch (...) {
+                        // not enough memory, write the drained records
                     }
-                    default:
-                        break;
+
+                    if (!_Records.empty()) {
+                        _Writer.append(_Records);
+                    }
+
+                    if (!_Last) {
+                        _Shared_cache._Audit._Wait(_Audit_queue_traits::_Flush_period);
                     }
                 }
 
                 return 0;
             },
-            _Cache, 0, nullptr
+            _Flag, 0, nullptr
         );
     }
 
-    void _Database_modification_handler::_Terminate() noexcept {
+    void _Audit_handler::_Terminate() noexcept {
         if (_Mythread) {
-            _Mycache._Flag._Set();
-            _Mycache._Event.notify();
+            _Myflag._Set();
+            _Service_shared_cache::_Get()._Audit._Wake();
             ::WaitForSingleObject(_Mythread, 0xFFFF'FFFF); // wait for the thread termination
             ::CloseHandle(_Mythread);
             _Mythread = nullptr;
@@ -76,25 +174,22 @@ namespace mjx {
         case SERVICE_CONTROL_SHUTDOWN:
         case SERVICE_CONTROL_PRESHUTDOWN:
         {
-            _Cache->_Status.dwCurrentState  = SERVICE_STOPPED;
-            const _Service_state _Old_state = _Cache->_Get_state();
+            _Cache->_Status.dwCurrentState = SERVICE_STOPPED;
             _Cache->_Set_state(_Service_state::_Terminated);
-            if (_Old_state == _Service_state::_Waiting) {
-                _Cache->_State_event.notify(); // notify waiting thread
-            }
-
+            _Service_shared_cache::_Get()._Events._Notify(_Event_source::_State); // wake up the task's thread
             _Cache->_Submit();
             break;
         }
         case SERVICE_CONTROL_PAUSE:
             _Cache->_Status.dwCurrentState = SERVICE_PAUSED;
             _Cache->_Set_state(_Service_state::_Waiting);
+            _Service_shared_cache::_Get()._Events._Notify(_Event_source::_State);
             _Cache->_Submit();
             break;
         case SERVICE_CONTROL_CONTINUE:
             _Cache->_Status.dwCurrentState = SERVICE_RUNNING;
             _Cache->_Set_state(_Service_state::_Working);
-            _Cache->_State_event.notify();
+            _Service_shared_cache::_Get()._Events._Notify(_Event_source::_State);
             _Cache->_Submit();
             break;
         default:
@@ -127,57 +222,159 @@ namespace mjx {
         _Mycache._Submit();
     }
 
+    audit_reason service_launcher::_Matches_rules(const uint32_t _Id, const _Compiled_rules& _Rules,
+        _Image_hash_cache& _Cache, path::string_type& _Path, unicode_string& _Command_line) {
+        // Note: The image path is queried once and shared by all the rules. The command line is
+        //       queried only for interpreters and the image is hashed last, since it's by far
+        //       the most expensive check.
+        if (!_Process_traits::_Get_image_path(_Id, _Path)) { // process already terminated or inaccessible
+            return audit_reason::none;
+        }
+
+        if (_Rules._Paths.matches(_Path)) {
+            return audit_reason::path;
+        }
+
+        const wchar_t* const _First = _Path.data();
+        const wchar_t* _Name_first  = _First + _Path.size();
+        while (_Name_first != _First && !_Path_trie_traits::_Is_separator(_Name_first[-1])) {
+            --_Name_first;
+        }
+
+        const unicode_string_view _Name{_Name_first, _Path.size() - static_cast<size_t>(_Name_first - _First)};
+        if (_Rules._Names.matches(_Name)) {
+            return audit_reason::name;
+        }
+
+        if (!_Rules._Commands.empty() && _Interpreter_traits::_Is_interpreter(_Name)
+            && _Process_traits::_Get_command_line(_Id, _Command_line) && _Rules._Commands.matches(_Command_line)) {
+            return audit_reason::command;
+        }
+
+        image_hash _Hash;
+        if (_Rules._Needs_hash() && _Cache._Get_hash(path{_Path}, _Hash)
+            && ::std::binary_search(_Rules._Images.begin(), _Rules._Images.end(), _Hash)) {
+            return audit_reason::image;
+        }
+
+        return audit_reason::none;
+    }
+
+    void service_launcher::_Match_processes(_Image_hash_cache& _Image_cache,
+        path::string_type& _Image_path, unicode_string& _Command_line, _Process_list& _Procs) {
+        // Note: The queue is drained even if nothing is locked, so it never fills up with stale processes.
+        //       A rescan is requested on each database change (and when the queue overflows), since
+        //       a newly locked application may already be running. The full process list includes
+        //       the queued processes.
+        _Service_shared_cache& _Cache = _Service_shared_cache::_Get();
+        _Process_traits::_Basic_data _Data;
+        _Procs.clear();
+        while (_Cache._Ingest_queue._Pop(_Data)) {
+            _Procs.push_back(_Data);
+        }
+
+        const uint32_t _Generation    = _Cache._Respawns._Generation(); // must be read before _Locked
+        const auto _Locked            = _Cache._Locked._Get();
+        const membership_index& _Apps = _Locked->_Apps;
+        const _Compiled_rules& _Rules = *_Locked->_Rules;
+        if (_Cache._Rescan.exchange(false, ::std::memory_order_acq_rel)) {
+            _Procs = _Process_traits::_Get_process_list(_Locked->_Mode);
+        }
+
+        if (_Procs.empty() || (_Apps.empty() && _Rules._Empty())) {
+            return;
+        }
+
+        // Note: In the allow-list mode, the index holds the permitted applications, so the result
+        //       of the lookup is inverted. The rules lock the matching processes in both modes.
+        //       Only the applications locked by their checksum can become hot, since the rules
+        //       may lock just some of the processes with the same name. If the enforcement thread
+        //       falls behind, the processes are terminated here.
+        const bool _Allow_list = _Locked->_Allow_list;
+        bool _Queued           = false;
+        audit_reason _Reason;
+        for (const auto& _Proc : _Procs) {
+            if (_Apps.contains(_Proc._Module_checksum) != _Allow_list) {
+                _Reason = audit_reason::checksum;
+            } else if (_Rules._Empty()) {
+                continue;
+            } else {
+                _Reason = _Matches_rules(_Proc._Id, _Rules, _Image_cache, _Image_path, _Command_line);
+                if (_Reason == audit_reason::none) {
+                    continue;
+                }
+            }
+
+            if (_Cache._Enforce_queue._Push(_Verdict{_Proc._Id, _Generation, _Proc._Module_checksum, _Reason})) {
+                _Queued = true;
+            } else {
+                _Cache._Tree._Terminate(_Proc._Id, _Reason, _Proc._Module_checksum);
+            }
+        }
+
+        if (_Queued) {
+            _Cache._Enforce_event.notify();
+        }
+
+        _Image_cache._Save_if_due();
+    }
+
     void service_launcher::_Perform_task() {
+        // Note: The process tree is filled before the events are subscribed, from then on it's updated
+        //       by the creation and exit events, so the descendants of a locked process can be found.
+        _Service_shared_cache& _Cache = _Service_shared_cache::_Get();
+        _Cache._Tree._Reset(_Process_traits::_Get_process_tree());
+        _Pipeline_traits::_Set_ideal_processor(::GetCurrentThread(), _Pipeline_traits::_Match_stage);
+        if (!_Cache._Events._Valid()) { // nothing can wake up the thread
+            return;
+        }
+
         _Wmi_session _Session;
         if (!_Session._Connect()) {
             return;
         }
 
-        _Database_modification_handler _Handler;
-        bool _Terminated              = false;
-        _Service_shared_cache& _Cache = _Service_shared_cache::_Get();
-        while (!_Terminated) {
-            switch (_Mycache._Get_state()) {
-            case _Service_state::_Terminated:
-                _Terminated = true;
-                _Handler._Terminate();
-                _Session._Terminate();
-                break;
-            case _Service_state::_Waiting:
-                _Mycache._State_event.wait(true);
-                break;
-            case _Service_state::_Working:
-            {
-                _Cache._Task_event.wait(true);
-                const auto& _Apps = _Cache._Locked_apps._Get();
-                if (!_Apps.empty()) {
-                    // Note: The task's event is notified in two cases - new process creation and database change.
-                    //       In the first case, the _Cache._New_procs holds the basic data of all new processes.
-                    //       In the second case, the _Cache._New_procs is empty, but we must obtain the full
-                    //       process list to check if a newly locked application is currently running.
-                    _Process_list _Procs = _Cache._New_procs._Get();
-                    if (!_Procs.empty()) { // scan new processes
-                        _Cache._New_procs._Get().clear();
-                    } else { // scan existing processes
-                        _Procs = _Process_traits::_Get_process_list();
-                    }
-
-                    for (const auto& _Proc : _Procs) {
-                        for (const auto& _App : _Apps) {
-                            if (_App.checksum() == _Proc._Module_checksum) {
-                                _Process_traits::_Terminate(_Proc._Id);
-                                break;
-                            }
-                        }
+        // Note: The database directory, the schedules, the queued processes and the state changes
+        //       are all handled by this thread. It sleeps in a single wait, until any of them is ready
+        //       or the next window boundary is reached, so there is no polling.
+        directory_watcher _Watcher;
+        const bool _Watching = _Watcher.is_watching()
+            && _Cache._Events._Attach(_Watcher.native_handle(), _Event_source::_Directory)
+            && _Watcher.request_changes();
+        _Schedule_timer _Timer;
+        _Enforcement_handler _Enforcer;
+        _Audit_handler _Auditor;
+        _Image_hash_cache _Image_cache; // used only if any image is locked
+        path::string_type _Image_path; // reused by all rule lookups
+        unicode_string _Command_line; // reused by all command line lookups
+        _Process_list _Procs; // reused by all batches
+        _Event_batch _Batch = {0, 0};
+        uint32_t _Timeout;
+        while (_Mycache._Get_state() != _Service_state::_Terminated) {
+            if (_Watching && _Batch._Has(_Event_source::_Directory)) {
+                if (_Watcher.is_update_required(_Batch._Directory_bytes)) { // reload the database
+                    database& _Db = database::current();
+                    if (_Db.reload()) { // ignore invalid or partially written files
+                        _Cache._Publish(_Db);
+                        _Cache._Rescan.store(true, ::std::memory_order_relaxed); // matched below
                     }
                 }
 
-                break;
+                _Watcher.request_changes(); // wait for the next change
             }
-            default:
-                break;
+
+            _Timeout = _Timer._Update();
+            if (_Mycache._Get_state() == _Service_state::_Working) {
+                _Match_processes(_Image_cache, _Image_path, _Command_line, _Procs);
             }
+
+            _Batch = _Cache._Events._Wait(_Timeout);
         }
+
+        _Session._Terminate();
+        _Enforcer._Terminate();
+        _Auditor._Terminate(); // must be terminated last, it writes the records of the other threads
+        _Cache._Respawns._Save(_Cache._Get_counters());
     }
 
     bool service_launcher::is_launch_possible() const noexcept {
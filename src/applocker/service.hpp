@@ -6,28 +6,65 @@
 #pragma once
 #ifndef _APPLOCKER_SERVICE_HPP_
 #define _APPLOCKER_SERVICE_HPP_
+#include <applocker/image_hash_cache.hpp>
 #include <applocker/service_caches.hpp>
 #include <applocker/sync.hpp>
+#include <applocker/timer_wheel.hpp>
+#include <cstdint>
+#include <vector>
 
 namespace mjx {
-    class _Database_modification_handler { // handles database modification at runtime
+    class _Schedule_timer { // opens and closes the time windows of the scheduled applications
     public:
-        _Database_modification_handler() noexcept;
-        ~_Database_modification_handler() noexcept;
+        _Schedule_timer() noexcept;
+        ~_Schedule_timer() noexcept;
 
-        // terminates database modification handler thread
+        _Schedule_timer(const _Schedule_timer&)            = delete;
+        _Schedule_timer& operator=(const _Schedule_timer&) = delete;
+
+        // flips the expired windows, returns the time until the next window boundary (in milliseconds)
+        uint32_t _Update();
+
+    private:
+        // Note: The wall clock may be changed while the thread waits for the next window boundary,
+        //       so the wait is limited and the timers are armed again if the clock goes back.
+        static constexpr uint64_t _Max_wait = 15 * 60 * 1000; // 15 minutes (in milliseconds)
+
+        ::std::vector<_Scheduled_entry> _Myschedules;
+        ::std::vector<uint32_t> _Myexpired;
+        timer_wheel _Mywheel;
+        uint32_t _Myversion; // the last copied version of the schedules
+    };
+
+    class _Enforcement_handler { // terminates the processes selected by the task's thread
+    public:
+        _Enforcement_handler() noexcept;
+        ~_Enforcement_handler() noexcept;
+
+        // terminates enforcement handler thread
+        void _Terminate() noexcept;
+
+    private:
+        // creates enforcement handler thread
+        static void* _Create_thread(_Sync_flag* const _Flag) noexcept;
+
+        _Sync_flag _Myflag;
+        void* _Mythread;
+    };
+
+    class _Audit_handler { // writes the audit records collected from all threads to the audit log
+    public:
+        _Audit_handler() noexcept;
+        ~_Audit_handler() noexcept;
+
+        // terminates audit handler thread
         void _Terminate() noexcept;
 
     private:
-        struct _Thread_cache {
-            waitable_event _Event;
-            _Sync_flag _Flag;
-        };
-
-        // creates database modification handler thread
-        static void* _Create_thread(_Thread_cache* const _Cache) noexcept;
-    
-        _Thread_cache _Mycache;
+        // creates audit handler thread
+        static void* _Create_thread(_Sync_flag* const _Flag) noexcept;
+
+        _Sync_flag _Myflag;
         void* _Mythread;
     };
 
@@ -58,6 +95,14 @@ namespace mjx {
         // changes the service state
         void _Set_state(const unsigned long _New_state) noexcept;
         
+        // returns the kind of the first rule the process matches, or audit_reason::none
+        static audit_reason _Matches_rules(const uint32_t _Id, const _Compiled_rules& _Rules,
+            _Image_hash_cache& _Cache, path::string_type& _Path, unicode_string& _Command_line);
+
+        // matches the queued (or all running) processes, queues the locked ones for termination
+        static void _Match_processes(_Image_hash_cache& _Image_cache,
+            path::string_type& _Image_path, unicode_string& _Command_line, _Process_list& _Procs);
+
         // performs the service task
         void _Perform_task();
 
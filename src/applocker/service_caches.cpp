@@ -3,11 +3,14 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+#include <applocker/protected_process.hpp>
 #include <applocker/service_caches.hpp>
+#include <cstring>
 
 namespace mjx {
     _Service_cache::_Service_cache() noexcept
-        : _Handle(nullptr), _Status(), _State_event(), _State(_Service_state::_Working) {}
+        : _Handle(nullptr), _Status(), _State(_Service_state::_Working) {}
 
     _Service_cache::~_Service_cache() noexcept {}
 
@@ -24,13 +27,23 @@ namespace mjx {
         ::SetServiceStatus(_Handle, ::std::addressof(_Status));
     }
 
-    _Service_shared_cache::_Service_shared_cache() : _Locked_apps(), _New_procs(), _Task_event() {
+    bool _Compiled_rules::_Empty() const noexcept {
+        return _Images.empty() && _Paths.empty() && _Names.empty() && _Commands.empty();
+    }
+
+    bool _Compiled_rules::_Needs_hash() const noexcept {
+        return !_Images.empty();
+    }
+
+    _Service_shared_cache::_Service_shared_cache()
+        : _Events(), _Locked(), _Ingest_queue(), _Ingest_lock(), _Rescan(false), _Enforce_queue(), _Enforce_event(),
+        _Schedule_version(0), _Instances(), _Limit_instances(false), _Audit(), _Tree(_Audit), _Respawns(), _Mylock(),
+        _Mybase(), _Myschedules(), _Myopen(), _Myrules(), _Mymode(checksum_mode::exact), _Myallow(false) {
         // Note: Immediate notification of the task thread is essential after the database is loaded.
-        //       This is because some locked processes may still be running. At this stage, _New_procs
-        //       doesn't yet contain any processes, so the task thread will scan existing processes to
-        //       identify any that need further attention.
-        _Locked_apps._Assign(database::current().get_entries());
-        _Task_event.notify();
+        //       This is because some locked processes may still be running. The rescan tells
+        //       the task thread to scan existing processes to identify any that need further attention.
+        _Publish(database::current());
+        _Request_rescan();
     }
 
     _Service_shared_cache::~_Service_shared_cache() noexcept {}
@@ -39,4 +52,156 @@ namespace mjx {
         static _Service_shared_cache _Cache;
         return _Cache;
     }
+
+    bool _Service_shared_cache::_Update_windows(const uint64_t _Minute) {
+        bool _Changed = false;
+        bool _Open;
+        for (size_t _Idx = 0; _Idx < _Myschedules.size(); ++_Idx) {
+            _Open = _Schedule_traits::_Is_active(_Myschedules[_Idx]._Window, _Minute);
+            if (_Open != _Myopen[_Idx]) {
+                _Myopen[_Idx] = _Open;
+                _Changed      = true;
+            }
+        }
+
+        return _Changed;
+    }
+
+    void _Service_shared_cache::_Publish_apps(const ::std::vector<database_entry>& _Entries) {
+        // Note: The open windows and the essential processes are merged into the entries, so the lookup
+        //       of each process stays the same. In the allow-list mode, the open windows are removed
+        //       from the permitted entries instead, so the schedules lock the applications like the rules
+        //       do in this mode. The essential processes are added last, so they're always permitted.
+        //       The filter isn't needed in the allow-list mode, since all new processes must be checked.
+        ::std::vector<checksum_t> _Open;
+        for (size_t _Idx = 0; _Idx < _Myschedules.size(); ++_Idx) {
+            if (_Myopen[_Idx]) {
+                _Open.push_back(_Myschedules[_Idx]._Checksum);
+            }
+        }
+
+        _Locked_set _Set;
+        if (_Myallow) {
+            ::std::sort(_Open.begin(), _Open.end());
+            ::std::vector<database_entry> _Permitted;
+            _Permitted.reserve(_Entries.size() + _Protected_process_traits::_Essential_count);
+            for (const database_entry& _Entry : _Entries) {
+                if (!::std::binary_search(_Open.begin(), _Open.end(), _Entry.checksum())) {
+                    _Permitted.push_back(_Entry);
+                }
+            }
+
+            for (const checksum_t _Checksum : _Protected_process_traits::_Get_essential(_Mymode)) {
+                _Permitted.push_back(database_entry{_Checksum});
+            }
+
+            _Set._Apps = membership_index{_Permitted};
+        } else if (!_Open.empty()) {
+            ::std::vector<database_entry> _Listed;
+            _Listed.reserve(_Entries.size() + _Open.size());
+            _Listed.insert(_Listed.end(), _Entries.begin(), _Entries.end());
+            for (const checksum_t _Checksum : _Open) {
+                _Listed.push_back(database_entry{_Checksum});
+            }
+
+            _Set._Apps   = membership_index{_Listed};
+            _Set._Filter = xor_filter{_Listed};
+        } else {
+            _Set._Apps   = membership_index{_Entries};
+            _Set._Filter = xor_filter{_Entries};
+        }
+
+        _Set._Rules       = _Myrules;
+        _Set._Mode        = _Mymode;
+        _Set._Match_rules = !_Myrules->_Empty();
+        _Set._Allow_list  = _Myallow;
+        _Locked._Publish(::std::move(_Set));
+        _Respawns._Invalidate(); // the hot applications may no longer be locked
+    }
+
+    void _Service_shared_cache::_Publish(const database& _Db) {
+        // Note: All structures are built into a new snapshot, which replaces the current one at once.
+        //       The readers never block, each of them keeps the snapshot it has taken until it's done.
+        //       dbmgr never empties the allow list, but an empty one (e.g. written by hand) would
+        //       terminate every application, so it's treated as an empty deny list instead.
+        const ::std::vector<database_entry>& _Entries = _Db.get_entries();
+        const ::std::vector<database_rule>& _Db_rules = _Db.get_rules();
+        _Compiled_rules _Rules;
+        ::std::vector<_Scheduled_entry> _Schedules;
+        ::std::vector<instance_limit> _Limits;
+        image_hash _Hash;
+        _Scheduled_entry _Schedule;
+        instance_limit _Limit;
+        for (const database_rule& _Rule : _Db_rules) { // the rules are sorted, so are the hashes
+            if (_Rule.kind() == rule_kind::image_hash && _Rule.data().size() == _Hash.size()) {
+                ::memcpy(_Hash.data(), _Rule.data().data(), _Hash.size());
+                _Rules._Images.push_back(_Hash);
+            } else if (_Schedule_traits::_Decode(_Rule, _Schedule._Checksum, _Schedule._Window)) {
+                _Schedules.push_back(_Schedule);
+            } else if (_Instance_limit_traits::_Decode(_Rule, _Limit)) {
+                _Limits.push_back(_Limit);
+            }
+        }
+
+        _Rules._Paths     = path_trie{_Db_rules};
+        _Rules._Names     = glob_dfa{_Db_rules};
+        _Rules._Commands  = aho_corasick{_Db_rules};
+        {
+            lock_guard _Guard(_Mylock);
+            _Myrules     = ::std::make_shared<const _Compiled_rules>(::std::move(_Rules));
+            _Mymode      = _Db.get_checksum_mode();
+            _Myallow     = _Db.get_enforcement_mode() == enforcement_mode::allow_list && !_Entries.empty();
+            _Myschedules = ::std::move(_Schedules);
+            _Myopen.assign(_Myschedules.size(), false);
+            if (_Myschedules.empty()) { // the entries are needed only to flip the windows
+                _Mybase.clear();
+                _Mybase.shrink_to_fit();
+            } else {
+                _Mybase = _Entries;
+                _Update_windows(_Schedule_traits::_Get_local_time() / _Schedule_traits::_Ticks_per_minute);
+            }
+
+            _Publish_apps(_Entries);
+            _Schedule_version.fetch_add(1, ::std::memory_order_relaxed); // the schedule timer must arm the new windows
+        }
+
+        // Note: The running instances are counted only when the limits change, from then on
+        //       the counters are updated by the creation and exit events.
+        const ::std::vector<_Instance_counter::_Excess_instance> _Excess = _Instances._Reset(_Limits,
+            _Limits.empty() ? _Process_list{} : _Process_traits::_Get_process_list(_Db.get_checksum_mode()));
+        _Limit_instances.store(!_Limits.empty(), ::std::memory_order_relaxed);
+        for (const _Instance_counter::_Excess_instance& _Inst : _Excess) {
+            _Tree._Terminate(_Inst._Id, audit_reason::instance_limit, _Inst._Checksum);
+        }
+    }
+
+    void _Service_shared_cache::_Request_rescan() noexcept {
+        _Rescan.store(true, ::std::memory_order_release);
+        _Events._Notify(_Event_source::_Task);
+    }
+
+    void _Service_shared_cache::_Copy_schedules(::std::vector<_Scheduled_entry>& _Schedules) {
+        lock_guard _Guard(_Mylock);
+        _Schedules = _Myschedules;
+    }
+
+    bool _Service_shared_cache::_Flip_schedules(const uint64_t _Minute) {
+        lock_guard _Guard(_Mylock);
+        if (!_Update_windows(_Minute)) { // nothing has changed
+            return false;
+        }
+
+        _Publish_apps(_Mybase);
+        return true;
+    }
+
+    service_counters _Service_shared_cache::_Get_counters() const noexcept {
+        service_counters _Counters;
+        _Counters.ingest_peak       = static_cast<uint32_t>(_Ingest_queue._Peak_depth());
+        _Counters.enforce_peak      = static_cast<uint32_t>(_Enforce_queue._Peak_depth());
+        _Counters.ingest_overflows  = _Ingest_queue._Overflows();
+        _Counters.enforce_overflows = _Enforce_queue._Overflows();
+        _Counters.audit_drops       = _Audit._Dropped();
+        return _Counters;
+    }
 } // namespace mjx
\ No newline at end of file
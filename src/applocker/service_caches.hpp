@@ -6,10 +6,25 @@
 #pragma once
 #ifndef _APPLOCKER_SERVICE_CACHES_HPP_
 #define _APPLOCKER_SERVICE_CACHES_HPP_
+#include <applocker/audit_queue.hpp>
+#include <applocker/event_loop.hpp>
+#include <applocker/instance_counter.hpp>
+#include <applocker/pipeline.hpp>
 #include <applocker/process.hpp>
+#include <applocker/process_tree.hpp>
+#include <applocker/respawn_guard.hpp>
 #include <applocker/sync.hpp>
+#include <dbmgr/aho_corasick.hpp>
 #include <dbmgr/database.hpp>
+#include <dbmgr/glob_dfa.hpp>
+#include <dbmgr/image_hash.hpp>
+#include <dbmgr/membership_index.hpp>
+#include <dbmgr/path_trie.hpp>
+#include <dbmgr/schedule.hpp>
+#include <dbmgr/xor_filter.hpp>
 #include <dbmgr/tinywin.hpp>
+#include <memory>
+#include <mjsync/srwlock.hpp>
 #include <mjsync/waitable_event.hpp>
 #include <vector>
 #include <winsvc.h>
@@ -25,7 +40,6 @@ namespace mjx {
     public:
         SERVICE_STATUS_HANDLE _Handle;
         SERVICE_STATUS _Status;
-        waitable_event _State_event;
         ::std::atomic<_Service_state> _State;
 
         _Service_cache() noexcept;
@@ -41,19 +55,85 @@ namespace mjx {
         void _Submit() noexcept;
     };
 
+    struct _Compiled_rules { // rules that don't match by the name checksum
+        ::std::vector<image_hash> _Images; // sorted hashes of the locked images
+        path_trie _Paths; // full path and directory rules
+        glob_dfa _Names; // wildcard name rules
+        aho_corasick _Commands; // command line rules, checked only for interpreters
+
+        // checks if there are no rules
+        bool _Empty() const noexcept;
+
+        // checks if any rule requires the image to be hashed
+        bool _Needs_hash() const noexcept;
+    };
+
+    struct _Locked_set { // everything the matchers need, published as a whole after each change
+        membership_index _Apps; // locked applications and the open windows (or permitted applications outside them)
+        xor_filter _Filter; // screens new processes before _Apps, empty in the allow-list mode
+        ::std::shared_ptr<const _Compiled_rules> _Rules; // compiled on each database reload, never null
+        checksum_mode _Mode; // mode used by _Apps
+        bool _Match_rules; // true if _Rules isn't empty
+        bool _Allow_list; // true if _Apps holds the permitted applications
+    };
+
+    struct _Scheduled_entry { // application locked only within its time window
+        checksum_t _Checksum;
+        time_window _Window;
+    };
+
     class _Service_shared_cache { // service's shared cache
     public:
-        _Locked_resource<::std::vector<database_entry>> _Locked_apps;
-        _Locked_resource<_Process_list> _New_procs;
-        waitable_event _Task_event;
+        _Event_loop _Events; // wakes up the task's thread, declared first, since the constructor notifies it
+        _Published_resource<_Locked_set> _Locked; // compiled on each database reload and schedule flip
+        _Spsc_queue<_Process_traits::_Basic_data, _Pipeline_traits::_Ingest_capacity> _Ingest_queue; // sink -> task
+        shared_lock _Ingest_lock; // serializes the producers, the events may be delivered on different threads
+        ::std::atomic<bool> _Rescan; // true if all running processes must be checked
+        _Spsc_queue<_Verdict, _Pipeline_traits::_Enforce_capacity> _Enforce_queue; // task -> enforcement
+        waitable_event _Enforce_event;
+        ::std::atomic<uint32_t> _Schedule_version; // incremented when the schedules change
+        _Instance_counter _Instances; // updated by the creation and exit events
+        ::std::atomic<bool> _Limit_instances; // true if _Instances isn't empty
+        _Audit_queue _Audit; // written to the audit log by the writer thread
+        _Process_tree _Tree; // updated by the creation and exit events, used to terminate the descendants
+        _Respawn_guard _Respawns; // emptied whenever _Locked changes
 
         ~_Service_shared_cache() noexcept;
 
         // returns an instance of this class
         static _Service_shared_cache& _Get() noexcept;
 
+        // compiles and publishes the locked applications
+        void _Publish(const database& _Db);
+
+        // tells the task's thread to check all running processes
+        void _Request_rescan() noexcept;
+
+        // copies the current schedules
+        void _Copy_schedules(::std::vector<_Scheduled_entry>& _Schedules);
+
+        // evaluates the schedules at the selected minute, returns true if the locked applications changed
+        bool _Flip_schedules(const uint64_t _Minute);
+
+        // returns the peak depths and the overflows of the queues
+        service_counters _Get_counters() const noexcept;
+
     private:
         _Service_shared_cache();
+
+        // evaluates the schedules at the selected minute, returns true if any window opened or closed
+        bool _Update_windows(const uint64_t _Minute);
+
+        // builds and publishes _Locked from the entries, the open windows and the current rules
+        void _Publish_apps(const ::std::vector<database_entry>& _Entries);
+
+        shared_lock _Mylock; // serializes the publishers (database reload and schedule)
+        ::std::vector<database_entry> _Mybase; // database entries, kept only if there are any schedules
+        ::std::vector<_Scheduled_entry> _Myschedules;
+        ::std::vector<bool> _Myopen; // true for each schedule whose window is open
+        ::std::shared_ptr<const _Compiled_rules> _Myrules; // reused by the schedule flips
+        checksum_mode _Mymode;
+        bool _Myallow;
     };
 } // namespace mjx
 
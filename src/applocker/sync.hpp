@@ -7,43 +7,35 @@
 #ifndef _APPLOCKER_SYNC_HPP_
 #define _APPLOCKER_SYNC_HPP_
 #include <atomic>
-#include <mjsync/srwlock.hpp>
+#include <memory>
 #include <type_traits>
 
 namespace mjx {
     template <class _Ty>
-    class _Locked_resource { // manages access to the shared resource
+    class _Published_resource { // immutable snapshots of the shared resource, each replaced as a whole
     public:
-        _Locked_resource() noexcept : _Myres(), _Mylock() {}
+        using _Snapshot = ::std::shared_ptr<const _Ty>;
 
-        ~_Locked_resource() noexcept {}
+        _Published_resource() : _Mysnapshot(::std::make_shared<const _Ty>()) {}
 
-        _Locked_resource(const _Locked_resource&)            = delete;
-        _Locked_resource& operator=(const _Locked_resource&) = delete;
+        ~_Published_resource() noexcept {}
 
-        _Ty& _Get() noexcept {
-            lock_guard _Guard(_Mylock);
-            return _Myres;
-        }
-
-        const _Ty& _Get() const noexcept {
-            shared_lock_guard _Guard(_Mylock);
-            return _Myres;
-        }
+        _Published_resource(const _Published_resource&)            = delete;
+        _Published_resource& operator=(const _Published_resource&) = delete;
 
-        void _Assign(const _Ty& _New_val) {
-            lock_guard _Guard(_Mylock);
-            _Myres = _New_val;
+        // returns the current snapshot, it stays valid as long as the caller holds it
+        _Snapshot _Get() const noexcept {
+            return ::std::atomic_load_explicit(&_Mysnapshot, ::std::memory_order_acquire);
         }
 
-        void _Assign(_Ty&& _New_val) {
-            lock_guard _Guard(_Mylock);
-            _Myres = ::std::move(_New_val);
+        // replaces the current snapshot, the readers of the previous one aren't affected
+        void _Publish(_Ty&& _New_val) {
+            _Snapshot _New_snapshot = ::std::make_shared<const _Ty>(::std::move(_New_val));
+            ::std::atomic_store_explicit(&_Mysnapshot, ::std::move(_New_snapshot), ::std::memory_order_release);
         }
 
     private:
-        _Ty _Myres;
-        shared_lock _Mylock;
+        _Snapshot _Mysnapshot;
     };
 
     class _Sync_flag { // atomic flag for threads synchronization
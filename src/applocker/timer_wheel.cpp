@@ -0,0 +1,174 @@
+// timer_wheel.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <applocker/timer_wheel.hpp>
+
+namespace mjx {
+    size_t _Timer_wheel_traits::_Find_slot(const uint64_t _Occupied, const size_t _Pos) noexcept {
+        if (_Pos >= _Slot_count) {
+            return _Slot_count;
+        }
+
+        uint64_t _Mask = _Occupied >> _Pos;
+        if (_Mask == 0) {
+            return _Slot_count;
+        }
+
+        size_t _Slot = _Pos;
+        for (; (_Mask & 1) == 0; _Mask >>= 1) {
+            ++_Slot;
+        }
+
+        return _Slot;
+    }
+
+    timer_wheel::timer_wheel() noexcept
+        : _Myslots(), _Myoccupied(), _Myoverflow(), _Mydue(), _Mynow(0), _Mycount(0) {}
+
+    timer_wheel::timer_wheel(const uint64_t _Now) noexcept
+        : _Myslots(), _Myoccupied(), _Myoverflow(), _Mydue(), _Mynow(_Now), _Mycount(0) {}
+
+    timer_wheel::~timer_wheel() noexcept {}
+
+    bool timer_wheel::empty() const noexcept {
+        return _Mycount == 0;
+    }
+
+    uint64_t timer_wheel::now() const noexcept {
+        return _Mynow;
+    }
+
+    void timer_wheel::reset(const uint64_t _Now) noexcept {
+        for (size_t _Level = 0; _Level < _Timer_wheel_traits::_Level_count; ++_Level) {
+            for (::std::vector<_Timer>& _Slot : _Myslots[_Level]) {
+                _Slot.clear(); // keep the capacity, the same timers are likely to be scheduled again
+            }
+
+            _Myoccupied[_Level] = 0;
+        }
+
+        _Myoverflow.clear();
+        _Mydue.clear();
+        _Mynow   = _Now;
+        _Mycount = 0;
+    }
+
+    void timer_wheel::_Insert(const _Timer& _Timer) {
+        if (_Timer._Deadline <= _Mynow) {
+            _Mydue.push_back(_Timer._Id);
+            return;
+        }
+
+        size_t _Shift;
+        size_t _Slot;
+        for (size_t _Level = 0; _Level < _Timer_wheel_traits::_Level_count; ++_Level) {
+            _Shift = (_Level + 1) * _Timer_wheel_traits::_Level_bits;
+            if ((_Timer._Deadline >> _Shift) == (_Mynow >> _Shift)) { // within the current block of this level
+                _Slot = static_cast<size_t>(_Timer._Deadline >> (_Shift - _Timer_wheel_traits::_Level_bits))
+                    & (_Timer_wheel_traits::_Slot_count - 1);
+                _Myslots[_Level][_Slot].push_back(_Timer);
+                _Myoccupied[_Level] |= uint64_t{1} << _Slot;
+                return;
+            }
+        }
+
+        _Myoverflow.push_back(_Timer);
+    }
+
+    void timer_wheel::_Cascade(const size_t _Level, const size_t _Slot) {
+        // Note: The slot is swapped out first, since its timers may be inserted into the same level again.
+        ::std::vector<_Timer> _Timers;
+        _Timers.swap(_Myslots[_Level][_Slot]);
+        _Myoccupied[_Level] &= ~(uint64_t{1} << _Slot);
+        for (const _Timer& _Timer : _Timers) {
+            _Insert(_Timer);
+        }
+    }
+
+    void timer_wheel::schedule(const uint64_t _Deadline, const uint32_t _Id) {
+        _Insert(_Timer{_Deadline, _Id});
+        ++_Mycount;
+    }
+
+    void timer_wheel::advance(const uint64_t _Now, ::std::vector<uint32_t>& _Expired) {
+        constexpr uint64_t _Low_mask = _Timer_wheel_traits::_Slot_count - 1;
+        constexpr size_t _Top_shift  = _Timer_wheel_traits::_Level_count * _Timer_wheel_traits::_Level_bits;
+        size_t _Shift;
+        size_t _Slot;
+        while (_Mynow < _Now && _Mycount > _Mydue.size()) {
+            if (_Timer_wheel_traits::_Find_slot(_Myoccupied[0], static_cast<size_t>(_Mynow & _Low_mask) + 1)
+                == _Timer_wheel_traits::_Slot_count) { // nothing left in this block, skip to its last tick
+                _Mynow = (::std::min)(_Now, _Mynow | _Low_mask);
+                if (_Mynow == _Now) {
+                    break;
+                }
+            }
+
+            ++_Mynow;
+            if ((_Mynow & ((uint64_t{1} << _Top_shift) - 1)) == 0) { // new top-level block, redistribute the overflow
+                ::std::vector<_Timer> _Timers;
+                _Timers.swap(_Myoverflow);
+                for (const _Timer& _Timer : _Timers) {
+                    _Insert(_Timer);
+                }
+            }
+
+            for (size_t _Level = _Timer_wheel_traits::_Level_count - 1; _Level > 0; --_Level) { // top-down
+                _Shift = _Level * _Timer_wheel_traits::_Level_bits;
+                if ((_Mynow & ((uint64_t{1} << _Shift) - 1)) == 0) { // the slot of this level has been reached
+                    _Cascade(_Level, static_cast<size_t>(_Mynow >> _Shift) & _Low_mask);
+                }
+            }
+
+            _Slot = static_cast<size_t>(_Mynow & _Low_mask);
+            if (_Myoccupied[0] & (uint64_t{1} << _Slot)) {
+                for (const _Timer& _Timer : _Myslots[0][_Slot]) {
+                    _Expired.push_back(_Timer._Id);
+                }
+
+                _Mycount -= _Myslots[0][_Slot].size();
+                _Myslots[0][_Slot].clear();
+                _Myoccupied[0] &= ~(uint64_t{1} << _Slot);
+            }
+        }
+
+        if (_Mynow < _Now) { // no timers left in the wheel
+            _Mynow = _Now;
+        }
+
+        _Expired.insert(_Expired.end(), _Mydue.begin(), _Mydue.end());
+        _Mycount -= _Mydue.size();
+        _Mydue.clear();
+    }
+
+    uint64_t timer_wheel::next_deadline() const noexcept {
+        if (!_Mydue.empty()) { // expires on the next advance
+            return _Mynow;
+        }
+
+        if (_Mycount == 0) {
+            return _Timer_wheel_traits::_No_deadline;
+        }
+
+        // Note: The slots of the higher levels are reached at their first tick, the timers are moved down
+        //       to the lower levels then, so the result may be earlier than the actual deadline.
+        size_t _Shift;
+        size_t _Slot;
+        for (size_t _Level = 0; _Level < _Timer_wheel_traits::_Level_count; ++_Level) {
+            _Shift = _Level * _Timer_wheel_traits::_Level_bits;
+            _Slot  = _Timer_wheel_traits::_Find_slot(_Myoccupied[_Level],
+                (static_cast<size_t>(_Mynow >> _Shift) & (_Timer_wheel_traits::_Slot_count - 1)) + 1);
+            if (_Slot != _Timer_wheel_traits::_Slot_count) { // the first tick of the slot
+                _Shift += _Timer_wheel_traits::_Level_bits;
+                return ((_Mynow >> _Shift) << _Shift)
+                    | (static_cast<uint64_t>(_Slot) << (_Shift - _Timer_wheel_traits::_Level_bits));
+            }
+        }
+
+        constexpr size_t _Top_shift = _Timer_wheel_traits::_Level_count * _Timer_wheel_traits::_Level_bits;
+        return ((_Mynow >> _Top_shift) + 1) << _Top_shift;
+    }
+} // namespace mjx
\ No newline at end of file
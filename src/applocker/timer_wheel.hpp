@@ -0,0 +1,77 @@
+// timer_wheel.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _APPLOCKER_TIMER_WHEEL_HPP_
+#define _APPLOCKER_TIMER_WHEEL_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mjx {
+    struct _Timer_wheel_traits {
+        // Note: The wheel has three levels of 64 slots. A level-n slot covers 64^n ticks, so the levels
+        //       span 64 ticks, 68 hours and 182 days if a tick is a minute. A timer is stored in the lowest
+        //       level whose current block contains its deadline and moves down when its slot is reached.
+        //       Timers beyond the last level wait in the overflow list.
+        static constexpr size_t _Level_bits    = 6;
+        static constexpr size_t _Level_count   = 3;
+        static constexpr size_t _Slot_count    = size_t{1} << _Level_bits;
+        static constexpr uint64_t _No_deadline = UINT64_MAX;
+
+        // returns the index of the lowest set bit not lower than _Pos, or _Slot_count if there is none
+        static size_t _Find_slot(const uint64_t _Occupied, const size_t _Pos) noexcept;
+    };
+
+    class timer_wheel { // hierarchical timer wheel with a one-tick resolution
+    public:
+        timer_wheel() noexcept;
+        ~timer_wheel() noexcept;
+
+        explicit timer_wheel(const uint64_t _Now) noexcept;
+
+        timer_wheel(const timer_wheel&)            = delete;
+        timer_wheel& operator=(const timer_wheel&) = delete;
+
+        // checks if there are no pending timers
+        bool empty() const noexcept;
+
+        // returns the current tick
+        uint64_t now() const noexcept;
+
+        // removes all timers and moves the wheel to the selected tick
+        void reset(const uint64_t _Now) noexcept;
+
+        // adds a timer, a deadline that has already passed expires on the next advance
+        void schedule(const uint64_t _Deadline, const uint32_t _Id);
+
+        // moves the wheel to the selected tick, appends the identifiers of the expired timers
+        void advance(const uint64_t _Now, ::std::vector<uint32_t>& _Expired);
+
+        // returns the earliest tick at which advance() may expire a timer
+        uint64_t next_deadline() const noexcept;
+
+    private:
+        struct _Timer {
+            uint64_t _Deadline;
+            uint32_t _Id;
+        };
+
+        // stores the timer in the right slot
+        void _Insert(const _Timer& _Timer);
+
+        // moves all timers from the slot to the lower levels
+        void _Cascade(const size_t _Level, const size_t _Slot);
+
+        ::std::vector<_Timer> _Myslots[_Timer_wheel_traits::_Level_count][_Timer_wheel_traits::_Slot_count];
+        uint64_t _Myoccupied[_Timer_wheel_traits::_Level_count]; // bit n is set if slot n isn't empty
+        ::std::vector<_Timer> _Myoverflow; // timers beyond the last level
+        ::std::vector<uint32_t> _Mydue; // timers scheduled in the past
+        uint64_t _Mynow;
+        size_t _Mycount;
+    };
+} // namespace mjx
+
+#endif // _APPLOCKER_TIMER_WHEEL_HPP_
\ No newline at end of file
@@ -61,7 +61,7 @@ namespace mjx {
             return false;
         }
 
-        _Sink = ::mjx::create_object<_Event_sink>(_Service_shared_cache::_Get()._Task_event);
+        _Sink = ::mjx::create_object<_Event_sink>(_Service_shared_cache::_Get()._Events);
         if (_Apartment->CreateObjectStub(_Sink._Get(), _Stub._Address()) < 0) {
             return false;
         }
@@ -70,11 +70,15 @@ namespace mjx {
     }
 
     bool _Wmi_session::_Send_notification_query() noexcept {
-        wchar_t _Language[] = L"WQL";
-        wchar_t _Query[]    = L"SELECT * FROM __InstanceCreationEvent WITHIN 1 "
-                              L"WHERE TargetInstance ISA 'Win32_Process'";
-        return _Services->ExecNotificationQueryAsync(_Language, _Query, WBEM_FLAG_SEND_STATUS,
-            nullptr, _Stub_sink._Get()) >= 0;
+        // Note: Both queries share the sink, the exit events keep the instance counters up to date.
+        wchar_t _Language[]       = L"WQL";
+        wchar_t _Creation_query[] = L"SELECT * FROM __InstanceCreationEvent WITHIN 1 "
+                                    L"WHERE TargetInstance ISA 'Win32_Process'";
+        wchar_t _Exit_query[]     = L"SELECT * FROM __InstanceDeletionEvent WITHIN 1 "
+                                    L"WHERE TargetInstance ISA 'Win32_Process'";
+        return _Services->ExecNotificationQueryAsync(_Language, _Creation_query, WBEM_FLAG_SEND_STATUS,
+            nullptr, _Stub_sink._Get()) >= 0 && _Services->ExecNotificationQueryAsync(_Language, _Exit_query,
+                WBEM_FLAG_SEND_STATUS, nullptr, _Stub_sink._Get()) >= 0;
     }
 
     [[nodiscard]] bool _Wmi_session::_Connect() {
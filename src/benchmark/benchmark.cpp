@@ -0,0 +1,79 @@
+// benchmark.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.hpp>
+#include <climits>
+#include <dbmgr/tinywin.hpp>
+
+namespace mjx {
+    uint64_t _Benchmark_traits::_Next_random(uint64_t& _State) noexcept {
+        _State ^= _State << 13;
+        _State ^= _State >> 7;
+        _State ^= _State << 17;
+        return _State;
+    }
+
+    int64_t _Benchmark_traits::_Now() noexcept {
+        static const int64_t _Frequency = [] {
+            LARGE_INTEGER _Result;
+            ::QueryPerformanceFrequency(&_Result);
+            return static_cast<int64_t>(_Result.QuadPart);
+        }();
+        LARGE_INTEGER _Counter;
+        ::QueryPerformanceCounter(&_Counter);
+        return static_cast<int64_t>(
+            static_cast<double>(_Counter.QuadPart) * 1'000'000'000.0 / static_cast<double>(_Frequency));
+    }
+
+    void _Benchmark_traits::_Consume(const uint64_t _Val) noexcept {
+        static volatile uint64_t _Sink = 0;
+        _Sink = _Sink ^ _Val;
+    }
+
+    const char* _Benchmark_traits::_Random_word(uint64_t& _State) noexcept {
+        static constexpr const char* _Words[] = {"agent", "bot", "cheat", "client", "crypto", "game", "hack",
+            "helper", "install", "launcher", "miner", "proxy", "server", "service", "setup", "steam", "tool",
+            "torrent", "update", "vpn"};
+        return _Words[_Next_random(_State) % (sizeof(_Words) / sizeof(_Words[0]))];
+    }
+
+    void _Benchmark_traits::_Append(::std::vector<wchar_t>& _Str, const char* _Ascii) {
+        for (; *_Ascii != '\0'; ++_Ascii) {
+            _Str.push_back(static_cast<wchar_t>(*_Ascii));
+        }
+    }
+
+    void _Benchmark_traits::_Append(::std::vector<wchar_t>& _Str, size_t _Num) {
+        wchar_t _Digits[20]; // enough for any 64-bit number
+        size_t _Count = 0;
+        do {
+            _Digits[_Count++] = static_cast<wchar_t>(L'0' + _Num % 10);
+            _Num /= 10;
+        } while (_Num > 0);
+
+        while (_Count > 0) {
+            _Str.push_back(_Digits[--_Count]);
+        }
+    }
+
+    benchmark_timer::benchmark_timer() noexcept : _Mystart(0), _Mybest(LLONG_MAX) {}
+
+    benchmark_timer::~benchmark_timer() noexcept {}
+
+    void benchmark_timer::start() noexcept {
+        _Mystart = _Benchmark_traits::_Now();
+    }
+
+    void benchmark_timer::stop() noexcept {
+        const int64_t _Elapsed = _Benchmark_traits::_Now() - _Mystart;
+        if (_Elapsed < _Mybest) {
+            _Mybest = _Elapsed;
+        }
+    }
+
+    double benchmark_timer::per_operation(const size_t _Count) const noexcept {
+        return _Count > 0 ? static_cast<double>(_Mybest) / static_cast<double>(_Count) : 0.0;
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,75 @@
+// benchmark.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _BENCHMARK_BENCHMARK_HPP_
+#define _BENCHMARK_BENCHMARK_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mjx {
+    struct _Benchmark_traits {
+        // Note: Each measurement is repeated and only the fastest run is reported, so preemption
+        //       and cold caches don't distort the results. The seed is fixed, so all runs
+        //       of the benchmark measure the same data.
+        static constexpr size_t _Run_count = 5;
+        static constexpr uint64_t _Seed    = 0x9E37'79B9'7F4A'7C15;
+
+        // returns the next pseudo-random number (xorshift64)
+        static uint64_t _Next_random(uint64_t& _State) noexcept;
+
+        // returns the current time (in nanoseconds)
+        static int64_t _Now() noexcept;
+
+        // consumes the value, so the computation of it can't be optimized away
+        static void _Consume(const uint64_t _Val) noexcept;
+
+        // returns a random lowercase word (from a fixed vocabulary of process name fragments)
+        static const char* _Random_word(uint64_t& _State) noexcept;
+
+        // appends the ASCII string to the wide string
+        static void _Append(::std::vector<wchar_t>& _Str, const char* _Ascii);
+
+        // appends the decimal representation of the number to the wide string
+        static void _Append(::std::vector<wchar_t>& _Str, size_t _Num);
+    };
+
+    class benchmark_timer { // keeps the time of the fastest run
+    public:
+        benchmark_timer() noexcept;
+        ~benchmark_timer() noexcept;
+
+        benchmark_timer(const benchmark_timer&)            = delete;
+        benchmark_timer& operator=(const benchmark_timer&) = delete;
+
+        // starts a new run
+        void start() noexcept;
+
+        // stops the current run
+        void stop() noexcept;
+
+        // returns the time of the fastest run divided by the number of operations (in nanoseconds)
+        double per_operation(const size_t _Count) const noexcept;
+
+    private:
+        int64_t _Mystart;
+        int64_t _Mybest;
+    };
+
+    // measures all the checksum kernels on process names and on a long buffer
+    void run_checksum_benchmark();
+
+    // compares the linear scan, the binary search and the minimal perfect hash
+    void run_membership_benchmark();
+
+    // measures the compilation and the matching of the wildcard name rules
+    void run_glob_benchmark();
+
+    // measures the compilation and the matching of the command line rules
+    void run_command_line_benchmark();
+} // namespace mjx
+
+#endif // _BENCHMARK_BENCHMARK_HPP_
\ No newline at end of file
@@ -0,0 +1,124 @@
+// checksum_benchmark.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.hpp>
+#include <cstdio>
+#include <dbmgr/checksum.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Checksum_benchmark_traits {
+        // Note: Process names are mostly 8 to 64 UTF-16 code units long, so the names are measured
+        //       separately from a long buffer, where the per-call overhead doesn't matter. The names
+        //       are stored back to back and mix both letter cases, like the names reported by the system.
+        static constexpr size_t _Name_count      = 4096;
+        static constexpr size_t _Min_name_length = 8;
+        static constexpr size_t _Max_name_length = 64;
+        static constexpr size_t _Buffer_length   = 32768; // 64 KiB
+        static constexpr size_t _Buffer_repeats  = 64;
+
+        // makes the names, each of them starts at the selected offset
+        static void _Make_names(uint64_t& _State, ::std::vector<wchar_t>& _Chars, ::std::vector<size_t>& _Offsets);
+
+        // returns the time of a single name (in nanoseconds)
+        static double _Measure_names(const _Checksum_kernel& _Kernel,
+            const ::std::vector<wchar_t>& _Chars, const ::std::vector<size_t>& _Offsets) noexcept;
+
+        // returns the time of the whole buffer (in nanoseconds)
+        static double _Measure_buffer(const _Checksum_kernel& _Kernel, const ::std::vector<wchar_t>& _Buffer) noexcept;
+
+        // converts the time of the selected number of bytes to GB/s
+        static double _To_throughput(const double _Time, const size_t _Bytes) noexcept;
+    };
+
+    void _Checksum_benchmark_traits::_Make_names(
+        uint64_t& _State, ::std::vector<wchar_t>& _Chars, ::std::vector<size_t>& _Offsets) {
+        static constexpr wchar_t _Alphabet[]   = L"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-. ";
+        static constexpr size_t _Alphabet_size = sizeof(_Alphabet) / sizeof(_Alphabet[0]) - 1; // skip the null
+        size_t _Length;
+        _Chars.clear();
+        _Offsets.assign(1, 0);
+        for (size_t _Idx = 0; _Idx < _Name_count; ++_Idx) {
+            _Length = _Min_name_length + _Benchmark_traits::_Next_random(_State)
+                % (_Max_name_length - _Min_name_length + 1);
+            for (size_t _Pos = 0; _Pos < _Length; ++_Pos) {
+                _Chars.push_back(_Alphabet[_Benchmark_traits::_Next_random(_State) % _Alphabet_size]);
+            }
+
+            _Offsets.push_back(_Chars.size());
+        }
+    }
+
+    double _Checksum_benchmark_traits::_Measure_names(const _Checksum_kernel& _Kernel,
+        const ::std::vector<wchar_t>& _Chars, const ::std::vector<size_t>& _Offsets) noexcept {
+        const wchar_t* const _Data = _Chars.data();
+        benchmark_timer _Timer;
+        checksum_t _Sum;
+        for (size_t _Run = 0; _Run < _Benchmark_traits::_Run_count; ++_Run) {
+            _Sum = 0;
+            _Timer.start();
+            for (size_t _Idx = 1; _Idx < _Offsets.size(); ++_Idx) {
+                _Sum += _Kernel._Compute(_Data + _Offsets[_Idx - 1], _Data + _Offsets[_Idx]);
+            }
+
+            _Timer.stop();
+            _Benchmark_traits::_Consume(_Sum);
+        }
+
+        return _Timer.per_operation(_Offsets.size() - 1);
+    }
+
+    double _Checksum_benchmark_traits::_Measure_buffer(
+        const _Checksum_kernel& _Kernel, const ::std::vector<wchar_t>& _Buffer) noexcept {
+        const wchar_t* const _First = _Buffer.data();
+        const wchar_t* const _Last  = _First + _Buffer.size();
+        benchmark_timer _Timer;
+        checksum_t _Sum;
+        for (size_t _Run = 0; _Run < _Benchmark_traits::_Run_count; ++_Run) {
+            _Sum = 0;
+            _Timer.start();
+            for (size_t _Idx = 0; _Idx < _Buffer_repeats; ++_Idx) {
+                _Sum += _Kernel._Compute(_First, _Last);
+            }
+
+            _Timer.stop();
+            _Benchmark_traits::_Consume(_Sum);
+        }
+
+        return _Timer.per_operation(_Buffer_repeats);
+    }
+
+    double _Checksum_benchmark_traits::_To_throughput(const double _Time, const size_t _Bytes) noexcept {
+        return _Time > 0.0 ? static_cast<double>(_Bytes) / _Time : 0.0; // bytes per nanosecond equal GB/s
+    }
+
+    void run_checksum_benchmark() {
+        uint64_t _State = _Benchmark_traits::_Seed;
+        ::std::vector<wchar_t> _Chars;
+        ::std::vector<size_t> _Offsets;
+        _Checksum_benchmark_traits::_Make_names(_State, _Chars, _Offsets);
+        ::std::vector<wchar_t> _Buffer(_Checksum_benchmark_traits::_Buffer_length);
+        for (wchar_t& _Ch : _Buffer) {
+            _Ch = static_cast<wchar_t>(_Benchmark_traits::_Next_random(_State));
+        }
+
+        const size_t _Name_bytes = _Chars.size() * sizeof(wchar_t) / _Checksum_benchmark_traits::_Name_count;
+        double _Name_time;
+        double _Buffer_time;
+        for (const _Checksum_kernel& _Kernel : _Checksum_kernel_traits::_Kernels) {
+            if (!_Checksum_kernel_traits::_Is_available(_Kernel)) {
+                ::printf("[CHECKSUM]: %-24s not available on this CPU\n", _Kernel._Name);
+                continue;
+            }
+
+            _Name_time   = _Checksum_benchmark_traits::_Measure_names(_Kernel, _Chars, _Offsets);
+            _Buffer_time = _Checksum_benchmark_traits::_Measure_buffer(_Kernel, _Buffer);
+            ::printf("[CHECKSUM]: %-24s %6.1f ns per name (%5.2f GB/s), %5.2f GB/s on a 64 KiB buffer\n",
+                _Kernel._Name, _Name_time, _Checksum_benchmark_traits::_To_throughput(_Name_time, _Name_bytes),
+                _Checksum_benchmark_traits::_To_throughput(
+                    _Buffer_time, _Checksum_benchmark_traits::_Buffer_length * sizeof(wchar_t)));
+        }
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,143 @@
+// command_line_benchmark.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.hpp>
+#include <cstdio>
+#include <dbmgr/aho_corasick.hpp>
+#include <dbmgr/database_rule.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Command_line_benchmark_traits {
+        // Note: The patterns are script names and module switches, each made unique by a number.
+        //       They are generated already normalized (lowercase), so they are passed directly
+        //       to make_command_line_rule(). The command lines start with an interpreter path
+        //       and only one in _Hit_interval contains any pattern.
+        static constexpr size_t _Sizes[]      = {10, 100, 1000, 10000};
+        static constexpr size_t _Text_count   = 1024;
+        static constexpr size_t _Hit_interval = 16;
+
+        // makes the pattern with the selected shape
+        static void _Make_pattern(
+            const size_t _Idx, const char* const _Word, ::std::vector<wchar_t>& _Pattern);
+
+        // makes a command line, appends the fragment in the middle of it
+        static void _Make_text(
+            uint64_t& _State, const ::std::vector<wchar_t>& _Fragment, ::std::vector<wchar_t>& _Text);
+
+        // makes the rules and the command lines
+        static void _Make_set(const size_t _Size, uint64_t& _State,
+            ::std::vector<database_rule>& _Rules, ::std::vector<::std::vector<wchar_t>>& _Texts);
+
+        // returns the time of a single match (in nanoseconds)
+        static double _Measure(
+            const aho_corasick& _Automaton, const ::std::vector<::std::vector<wchar_t>>& _Texts) noexcept;
+    };
+
+    void _Command_line_benchmark_traits::_Make_pattern(
+        const size_t _Idx, const char* const _Word, ::std::vector<wchar_t>& _Pattern) {
+        _Pattern.clear();
+        switch (_Idx % 3) {
+        case 0: // word1.py
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            _Benchmark_traits::_Append(_Pattern, ".py");
+            break;
+        case 1: // -m word1
+            _Benchmark_traits::_Append(_Pattern, "-m ");
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            break;
+        default: // \word1\index.js
+            _Pattern.push_back(L'\\');
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            _Benchmark_traits::_Append(_Pattern, "\\index.js");
+            break;
+        }
+    }
+
+    void _Command_line_benchmark_traits::_Make_text(
+        uint64_t& _State, const ::std::vector<wchar_t>& _Fragment, ::std::vector<wchar_t>& _Text) {
+        _Text.clear();
+        _Benchmark_traits::_Append(_Text, "\"C:\\Program Files\\Python311\\python.exe\" -u C:\\Users\\Admin\\");
+        _Benchmark_traits::_Append(_Text, _Benchmark_traits::_Random_word(_State));
+        _Text.push_back(L'\\');
+        _Text.insert(_Text.end(), _Fragment.begin(), _Fragment.end());
+        _Benchmark_traits::_Append(_Text, " --");
+        _Benchmark_traits::_Append(_Text, _Benchmark_traits::_Random_word(_State));
+        _Text.push_back(L'=');
+        _Benchmark_traits::_Append(_Text, static_cast<size_t>(_Benchmark_traits::_Next_random(_State) % 100000));
+    }
+
+    void _Command_line_benchmark_traits::_Make_set(const size_t _Size, uint64_t& _State,
+        ::std::vector<database_rule>& _Rules, ::std::vector<::std::vector<wchar_t>>& _Texts) {
+        ::std::vector<::std::vector<wchar_t>> _Patterns(_Size);
+        _Rules.clear();
+        _Rules.reserve(_Size);
+        for (size_t _Idx = 0; _Idx < _Size; ++_Idx) {
+            _Make_pattern(_Idx, _Benchmark_traits::_Random_word(_State), _Patterns[_Idx]);
+            _Rules.push_back(::mjx::make_command_line_rule(
+                unicode_string_view{_Patterns[_Idx].data(), _Patterns[_Idx].size()}));
+        }
+
+        _Texts.assign(_Text_count, ::std::vector<wchar_t>{});
+        ::std::vector<wchar_t> _Fragment;
+        for (size_t _Idx = 0; _Idx < _Text_count; ++_Idx) {
+            if (_Idx % _Hit_interval == 0) {
+                _Fragment = _Patterns[_Benchmark_traits::_Next_random(_State) % _Size];
+            } else { // a script that shares the words with the patterns
+                _Fragment.clear();
+                _Benchmark_traits::_Append(_Fragment, _Benchmark_traits::_Random_word(_State));
+                _Fragment.push_back(L'_');
+                _Benchmark_traits::_Append(_Fragment, _Benchmark_traits::_Random_word(_State));
+                _Benchmark_traits::_Append(_Fragment, ".py");
+            }
+
+            _Make_text(_State, _Fragment, _Texts[_Idx]);
+        }
+    }
+
+    double _Command_line_benchmark_traits::_Measure(
+        const aho_corasick& _Automaton, const ::std::vector<::std::vector<wchar_t>>& _Texts) noexcept {
+        benchmark_timer _Timer;
+        size_t _Hits;
+        for (size_t _Run = 0; _Run < _Benchmark_traits::_Run_count; ++_Run) {
+            _Hits = 0;
+            _Timer.start();
+            for (const ::std::vector<wchar_t>& _Text : _Texts) {
+                _Hits += _Automaton.matches(unicode_string_view{_Text.data(), _Text.size()}) ? 1 : 0;
+            }
+
+            _Timer.stop();
+            _Benchmark_traits::_Consume(_Hits);
+        }
+
+        return _Timer.per_operation(_Texts.size());
+    }
+
+    void run_command_line_benchmark() {
+        uint64_t _State = _Benchmark_traits::_Seed;
+        ::std::vector<database_rule> _Rules;
+        ::std::vector<::std::vector<wchar_t>> _Texts;
+        size_t _Length;
+        for (const size_t _Size : _Command_line_benchmark_traits::_Sizes) {
+            _Command_line_benchmark_traits::_Make_set(_Size, _State, _Rules, _Texts);
+            benchmark_timer _Timer;
+            _Timer.start();
+            const aho_corasick _Automaton(_Rules); // compiled once, it's too slow to repeat for large sets
+            _Timer.stop();
+            _Length = 0;
+            for (const ::std::vector<wchar_t>& _Text : _Texts) {
+                _Length += _Text.size();
+            }
+
+            ::printf("[COMMAND-LINE]: %5zu patterns, compiled in %8.1f ms (%zu states), %7.1f ns per command line"
+                " (%zu characters on average)\n", _Size, _Timer.per_operation(1'000'000), _Automaton.state_count(),
+                _Command_line_benchmark_traits::_Measure(_Automaton, _Texts), _Length / _Texts.size());
+        }
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,145 @@
+// glob_benchmark.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.hpp>
+#include <cstdio>
+#include <dbmgr/database_rule.hpp>
+#include <dbmgr/glob_dfa.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Glob_benchmark_traits {
+        // Note: The patterns have the shapes admins actually use ("*word*.exe", "word_??.exe", "word*.exe"
+        //       and "*word.exe"), each made unique by a number. The patterns are generated already
+        //       normalized (lowercase, no consecutive '*'), so they are passed directly to make_glob_rule().
+        //       Only one name in _Hit_interval matches any pattern.
+        static constexpr size_t _Sizes[]      = {10, 100, 1000, 10000};
+        static constexpr size_t _Name_count   = 1024;
+        static constexpr size_t _Hit_interval = 16;
+
+        // makes the pattern with the selected shape
+        static void _Make_pattern(
+            const size_t _Idx, const char* const _Word, ::std::vector<wchar_t>& _Pattern);
+
+        // makes a name that matches the pattern (replaces the wildcards)
+        static void _Make_match(const ::std::vector<wchar_t>& _Pattern, ::std::vector<wchar_t>& _Name);
+
+        // makes the rules and the names
+        static void _Make_set(const size_t _Size, uint64_t& _State,
+            ::std::vector<database_rule>& _Rules, ::std::vector<::std::vector<wchar_t>>& _Names);
+
+        // returns the time of a single match (in nanoseconds)
+        static double _Measure(const glob_dfa& _Dfa, const ::std::vector<::std::vector<wchar_t>>& _Names) noexcept;
+    };
+
+    void _Glob_benchmark_traits::_Make_pattern(
+        const size_t _Idx, const char* const _Word, ::std::vector<wchar_t>& _Pattern) {
+        _Pattern.clear();
+        switch (_Idx % 4) {
+        case 0: // *word1*.exe
+            _Pattern.push_back(_Glob_dfa_traits::_Any_string);
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            _Pattern.push_back(_Glob_dfa_traits::_Any_string);
+            _Benchmark_traits::_Append(_Pattern, ".exe");
+            break;
+        case 1: // word_1_??.exe
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Pattern.push_back(L'_');
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            _Pattern.push_back(L'_');
+            _Pattern.push_back(_Glob_dfa_traits::_Any_character);
+            _Pattern.push_back(_Glob_dfa_traits::_Any_character);
+            _Benchmark_traits::_Append(_Pattern, ".exe");
+            break;
+        case 2: // word1*.exe
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            _Pattern.push_back(_Glob_dfa_traits::_Any_string);
+            _Benchmark_traits::_Append(_Pattern, ".exe");
+            break;
+        default: // *word-1.exe
+            _Pattern.push_back(_Glob_dfa_traits::_Any_string);
+            _Benchmark_traits::_Append(_Pattern, _Word);
+            _Pattern.push_back(L'-');
+            _Benchmark_traits::_Append(_Pattern, _Idx);
+            _Benchmark_traits::_Append(_Pattern, ".exe");
+            break;
+        }
+    }
+
+    void _Glob_benchmark_traits::_Make_match(const ::std::vector<wchar_t>& _Pattern, ::std::vector<wchar_t>& _Name) {
+        _Name.clear();
+        for (const wchar_t _Ch : _Pattern) {
+            if (_Ch == _Glob_dfa_traits::_Any_string) {
+                _Benchmark_traits::_Append(_Name, "x");
+            } else if (_Ch == _Glob_dfa_traits::_Any_character) {
+                _Name.push_back(L'7');
+            } else {
+                _Name.push_back(_Ch);
+            }
+        }
+    }
+
+    void _Glob_benchmark_traits::_Make_set(const size_t _Size, uint64_t& _State,
+        ::std::vector<database_rule>& _Rules, ::std::vector<::std::vector<wchar_t>>& _Names) {
+        ::std::vector<::std::vector<wchar_t>> _Patterns(_Size);
+        _Rules.clear();
+        _Rules.reserve(_Size);
+        for (size_t _Idx = 0; _Idx < _Size; ++_Idx) {
+            _Make_pattern(_Idx, _Benchmark_traits::_Random_word(_State), _Patterns[_Idx]);
+            _Rules.push_back(::mjx::make_glob_rule(
+                unicode_string_view{_Patterns[_Idx].data(), _Patterns[_Idx].size()}));
+        }
+
+        // Note: The names that don't match look like the usual process names, which share
+        //       the words and the extension with the patterns, so the automaton can't reject them early.
+        _Names.assign(_Name_count, ::std::vector<wchar_t>{});
+        for (size_t _Idx = 0; _Idx < _Name_count; ++_Idx) {
+            if (_Idx % _Hit_interval == 0) {
+                _Make_match(_Patterns[_Benchmark_traits::_Next_random(_State) % _Size], _Names[_Idx]);
+            } else {
+                _Benchmark_traits::_Append(_Names[_Idx], _Benchmark_traits::_Random_word(_State));
+                _Benchmark_traits::_Append(_Names[_Idx], _Benchmark_traits::_Random_word(_State));
+                _Benchmark_traits::_Append(_Names[_Idx], ".exe");
+            }
+        }
+    }
+
+    double _Glob_benchmark_traits::_Measure(
+        const glob_dfa& _Dfa, const ::std::vector<::std::vector<wchar_t>>& _Names) noexcept {
+        benchmark_timer _Timer;
+        size_t _Hits;
+        for (size_t _Run = 0; _Run < _Benchmark_traits::_Run_count; ++_Run) {
+            _Hits = 0;
+            _Timer.start();
+            for (const ::std::vector<wchar_t>& _Name : _Names) {
+                _Hits += _Dfa.matches(unicode_string_view{_Name.data(), _Name.size()}) ? 1 : 0;
+            }
+
+            _Timer.stop();
+            _Benchmark_traits::_Consume(_Hits);
+        }
+
+        return _Timer.per_operation(_Names.size());
+    }
+
+    void run_glob_benchmark() {
+        uint64_t _State = _Benchmark_traits::_Seed;
+        ::std::vector<database_rule> _Rules;
+        ::std::vector<::std::vector<wchar_t>> _Names;
+        for (const size_t _Size : _Glob_benchmark_traits::_Sizes) {
+            _Glob_benchmark_traits::_Make_set(_Size, _State, _Rules, _Names);
+            benchmark_timer _Timer;
+            _Timer.start();
+            const glob_dfa _Dfa(_Rules); // compiled once, it's too slow to repeat for large sets
+            _Timer.stop();
+            ::printf("[GLOB]: %5zu patterns, compiled in %8.1f ms (%zu automata, %zu states), %7.1f ns per name\n",
+                _Size, _Timer.per_operation(1'000'000), _Dfa.automaton_count(), _Dfa.state_count(),
+                _Glob_benchmark_traits::_Measure(_Dfa, _Names));
+        }
+    }
+} // namespace mjx
\ No newline at end of file
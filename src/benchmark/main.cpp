@@ -0,0 +1,68 @@
+// main.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.hpp>
+#include <cstdio>
+#include <cwchar>
+
+namespace mjx {
+    struct _Benchmark_entry {
+        const wchar_t* _Name; // name of the command line argument that selects the benchmark
+        void (*_Run)();
+        bool _Default; // true if run when no benchmark is selected
+    };
+
+    inline constexpr _Benchmark_entry _Benchmarks[] = {
+        {L"--checksum", &run_checksum_benchmark, true},
+        {L"--membership", &run_membership_benchmark, true},
+        {L"--glob", &run_glob_benchmark, true},
+        {L"--command-line", &run_command_line_benchmark, true}
+    };
+
+    inline bool _Is_selected(const _Benchmark_entry& _Entry, int _Count, wchar_t** _Args) noexcept {
+        if (_Count == 1) { // no benchmark selected, run the default ones
+            return _Entry._Default;
+        }
+
+        for (int _Idx = 1; _Idx < _Count; ++_Idx) {
+            if (::wcscmp(_Args[_Idx], _Entry._Name) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    inline int _Entry_point(int _Count, wchar_t** _Args) {
+        size_t _Selected = 0;
+        for (const _Benchmark_entry& _Entry : _Benchmarks) {
+            if (_Is_selected(_Entry, _Count, _Args)) {
+                ++_Selected;
+            }
+        }
+
+        if (_Count > 1 && _Selected != static_cast<size_t>(_Count - 1)) {
+            ::puts("[ERROR]: No benchmark associated with the given argument.");
+            return -1;
+        }
+
+        for (const _Benchmark_entry& _Entry : _Benchmarks) {
+            if (_Is_selected(_Entry, _Count, _Args)) {
+                _Entry._Run();
+            }
+        }
+
+        return 0;
+    }
+} // namespace mjx
+
+int wmain(int _Count, wchar_t** _Args) {
+    try {
+        return ::mjx::_Entry_point(_Count, _Args);
+    } catch (...) {
+        ::puts("[ERROR]: Unknown error.");
+        return -1;
+    }
+}
\ No newline at end of file
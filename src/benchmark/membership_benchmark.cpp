@@ -0,0 +1,80 @@
+// membership_benchmark.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.hpp>
+#include <cstdio>
+#include <dbmgr/database.hpp>
+#include <dbmgr/membership_index.hpp>
+#include <dbmgr/perfect_hash.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Membership_benchmark_traits {
+        // Note: Almost no process is listed, so only one probe in _Hit_interval is a member.
+        //       The linear scan is what the service did before the index, it's measured
+        //       up to the largest set to show where it stops being usable.
+        static constexpr size_t _Sizes[]      = {4, 16, 64, 256, 1024, 4096, 65536, 1048576};
+        static constexpr size_t _Probe_count  = 1024;
+        static constexpr size_t _Hit_interval = 16;
+
+        // makes the random entries and the probes
+        static void _Make_set(const size_t _Size, uint64_t& _State,
+            ::std::vector<database_entry>& _Entries, ::std::vector<checksum_t>& _Probes);
+
+        // returns the time of a single lookup (in nanoseconds)
+        static double _Measure(const membership_index& _Index, const ::std::vector<checksum_t>& _Probes) noexcept;
+    };
+
+    void _Membership_benchmark_traits::_Make_set(const size_t _Size, uint64_t& _State,
+        ::std::vector<database_entry>& _Entries, ::std::vector<checksum_t>& _Probes) {
+        _Entries.clear();
+        _Entries.reserve(_Size);
+        for (size_t _Idx = 0; _Idx < _Size; ++_Idx) {
+            _Entries.push_back(database_entry{_Benchmark_traits::_Next_random(_State)});
+        }
+
+        _Probes.assign(_Probe_count, 0);
+        for (size_t _Idx = 0; _Idx < _Probe_count; ++_Idx) {
+            _Probes[_Idx] = _Idx % _Hit_interval == 0
+                ? _Entries[_Benchmark_traits::_Next_random(_State) % _Size].checksum()
+                : _Benchmark_traits::_Next_random(_State);
+        }
+    }
+
+    double _Membership_benchmark_traits::_Measure(
+        const membership_index& _Index, const ::std::vector<checksum_t>& _Probes) noexcept {
+        benchmark_timer _Timer;
+        size_t _Hits;
+        for (size_t _Run = 0; _Run < _Benchmark_traits::_Run_count; ++_Run) {
+            _Hits = 0;
+            _Timer.start();
+            for (const checksum_t _Probe : _Probes) {
+                _Hits += _Index.contains(_Probe) ? 1 : 0;
+            }
+
+            _Timer.stop();
+            _Benchmark_traits::_Consume(_Hits);
+        }
+
+        return _Timer.per_operation(_Probes.size());
+    }
+
+    void run_membership_benchmark() {
+        uint64_t _State = _Benchmark_traits::_Seed;
+        ::std::vector<database_entry> _Entries;
+        ::std::vector<checksum_t> _Probes;
+        for (const size_t _Size : _Membership_benchmark_traits::_Sizes) {
+            _Membership_benchmark_traits::_Make_set(_Size, _State, _Entries, _Probes);
+            const membership_index _Linear(_Entries, membership_strategy::linear);
+            const membership_index _Sorted(_Entries, membership_strategy::sorted);
+            const membership_index _Hashed(_Entries, membership_strategy::hashed);
+            const perfect_hash_set _Hash(_Entries); // the index doesn't report the size of the hash
+            ::printf("[MEMBERSHIP]: %7zu entries, linear %10.1f ns, sorted %6.1f ns, hashed %6.1f ns"
+                " (%.2f bits per key)\n", _Size, _Membership_benchmark_traits::_Measure(_Linear, _Probes),
+                _Membership_benchmark_traits::_Measure(_Sorted, _Probes),
+                _Membership_benchmark_traits::_Measure(_Hashed, _Probes), _Hash.bits_per_key());
+        }
+    }
+} // namespace mjx
\ No newline at end of file
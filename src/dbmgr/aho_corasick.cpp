@@ -0,0 +1,250 @@
+// aho_corasick.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <dbmgr/aho_corasick.hpp>
+#include <dbmgr/checksum.hpp>
+#include <unordered_map>
+
+namespace mjx {
+    bool _Aho_corasick_traits::_Is_valid_pattern(const unicode_string_view _Pattern) noexcept {
+        if (_Pattern.empty()) {
+            return false;
+        }
+
+        const wchar_t* const _Last = _Pattern.data() + _Pattern.size();
+        for (const wchar_t* _Iter = _Pattern.data(); _Iter != _Last; ++_Iter) {
+            if (*_Iter == L'\0') {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    unicode_string _Aho_corasick_traits::_Normalize(const unicode_string_view _Pattern) {
+        unicode_string _Result;
+        _Result.reserve(_Pattern.size());
+        const wchar_t* const _Last = _Pattern.data() + _Pattern.size();
+        for (const wchar_t* _Iter = _Pattern.data(); _Iter != _Last; ++_Iter) {
+            _Result.push_back(_Crc32c_traits::_Fold_case(*_Iter));
+        }
+
+        return _Result;
+    }
+
+    aho_corasick::aho_corasick() noexcept
+        : _Myroot(), _Mybase(), _Myslots(), _Myoutput(), _Mywide_chars(), _Mywide_classes(), _Myascii_classes{0} {}
+
+    aho_corasick::aho_corasick(const ::std::vector<database_rule>& _Rules)
+        : _Myroot(), _Mybase(), _Myslots(), _Myoutput(), _Mywide_chars(), _Mywide_classes(), _Myascii_classes{0} {
+        ::std::vector<unicode_string_view> _Patterns;
+        ::std::vector<wchar_t> _Chars;
+        for (const database_rule& _Rule : _Rules) {
+            if (_Rule.kind() == rule_kind::command_line && !_Rule.data().empty()) {
+                const wchar_t* const _First = reinterpret_cast<const wchar_t*>(_Rule.data().data());
+                const size_t _Size          = _Rule.data().size() / sizeof(wchar_t);
+                _Patterns.emplace_back(_First, _Size);
+                _Chars.insert(_Chars.end(), _First, _First + _Size);
+            }
+        }
+
+        if (_Patterns.empty()) {
+            return;
+        }
+
+        // assign a class to each distinct character, class 0 stands for all the other characters
+        ::std::sort(_Chars.begin(), _Chars.end());
+        _Chars.erase(::std::unique(_Chars.begin(), _Chars.end()), _Chars.end());
+        const size_t _Class_count = _Chars.size() + 1;
+        for (size_t _Idx = 0; _Idx < _Chars.size(); ++_Idx) {
+            if (static_cast<uint32_t>(_Chars[_Idx]) < 128) {
+                _Myascii_classes[_Chars[_Idx]] = static_cast<uint32_t>(_Idx + 1);
+            } else { // the characters are sorted, so are the wide characters
+                _Mywide_chars.push_back(_Chars[_Idx]);
+                _Mywide_classes.push_back(static_cast<uint32_t>(_Idx + 1));
+            }
+        }
+
+        // build the trie of the substrings
+        ::std::vector<::std::vector<_Transition>> _Rows(1); // trie edges, later all non-root transitions
+        ::std::unordered_map<uint64_t, uint32_t> _Edges; // (state, class) -> child
+        _Myoutput.push_back(0);
+        for (const unicode_string_view& _Pattern : _Patterns) {
+            uint32_t _State            = _Aho_corasick_traits::_Root_state;
+            const wchar_t* const _Last = _Pattern.data() + _Pattern.size();
+            for (const wchar_t* _Iter = _Pattern.data(); _Iter != _Last; ++_Iter) {
+                const uint32_t _Class = _Get_class(*_Iter);
+                const auto _Inserted  = _Edges.emplace(
+                    (static_cast<uint64_t>(_State) << 32) | _Class, static_cast<uint32_t>(_Rows.size()));
+                if (_Inserted.second) { // a new prefix
+                    _Rows[_State].push_back(_Transition{_Class, _Inserted.first->second});
+                    _Rows.emplace_back();
+                    _Myoutput.push_back(0);
+                }
+
+                _State = _Inserted.first->second;
+            }
+
+            _Myoutput[_State] = 1;
+        }
+
+        // Note: The states are visited in the breadth-first order, so the failure state of each state
+        //       is complete before the state itself. A state's transitions are its trie edges plus
+        //       the transitions of its failure state, the root's transitions are implied.
+        const size_t _State_count = _Rows.size();
+        const auto _Find          = [&](const uint32_t _State, const uint32_t _Class) noexcept -> uint32_t {
+            const ::std::vector<_Transition>& _Row = _Rows[_State];
+            const auto _Iter                       = ::std::lower_bound(_Row.begin(), _Row.end(), _Class,
+                [](const _Transition& _Elem, const uint32_t _Val) noexcept { return _Elem._Class < _Val; });
+            return _Iter != _Row.end() && _Iter->_Class == _Class ? _Iter->_Target : _Myroot[_Class];
+        };
+
+        _Myroot.assign(_Class_count, _Aho_corasick_traits::_Root_state);
+        ::std::vector<uint32_t> _Queue;
+        ::std::vector<uint32_t> _Fail(_State_count, _Aho_corasick_traits::_Root_state);
+        _Queue.reserve(_State_count);
+        for (const _Transition& _Edge : _Rows[_Aho_corasick_traits::_Root_state]) {
+            _Myroot[_Edge._Class] = _Edge._Target;
+            _Queue.push_back(_Edge._Target);
+        }
+
+        _Rows[_Aho_corasick_traits::_Root_state].clear();
+        ::std::vector<_Transition> _Merged;
+        for (size_t _Idx = 0; _Idx < _Queue.size(); ++_Idx) {
+            const uint32_t _State = _Queue[_Idx];
+            ::std::vector<_Transition>& _Row = _Rows[_State];
+            ::std::sort(_Row.begin(), _Row.end(),
+                [](const _Transition& _Left, const _Transition& _Right) noexcept {
+                    return _Left._Class < _Right._Class;
+                });
+            for (const _Transition& _Edge : _Row) {
+                _Fail[_Edge._Target] = _Find(_Fail[_State], _Edge._Class);
+                _Queue.push_back(_Edge._Target);
+            }
+
+            _Myoutput[_State] |= _Myoutput[_Fail[_State]];
+            const ::std::vector<_Transition>& _Inherited = _Rows[_Fail[_State]];
+            if (!_Inherited.empty()) { // merge the transitions of the failure state, the trie edges win
+                _Merged.clear();
+                auto _Own = _Row.begin();
+                for (const _Transition& _Other : _Inherited) {
+                    for (; _Own != _Row.end() && _Own->_Class < _Other._Class; ++_Own) {
+                        _Merged.push_back(*_Own);
+                    }
+
+                    if (_Own == _Row.end() || _Own->_Class != _Other._Class) {
+                        _Merged.push_back(_Other);
+                    }
+                }
+
+                _Merged.insert(_Merged.end(), _Own, _Row.end());
+                _Row = _Merged;
+            }
+        }
+
+        // pack the transitions, the states with an output are never left, so they need none
+        size_t _First_free = 0;
+        _Mybase.assign(_State_count, 0);
+        for (uint32_t _State = 1; _State < _State_count; ++_State) {
+            if (!_Myoutput[_State] && !_Rows[_State].empty()) {
+                _Mybase[_State] = _Pack(_State, _Rows[_State], _First_free);
+            }
+        }
+
+        _Myslots.resize(_Myslots.size() + _Class_count, _Slot{_Aho_corasick_traits::_No_owner, 0}); // no bound checks
+        _Myslots.shrink_to_fit();
+    }
+
+    aho_corasick::~aho_corasick() noexcept {}
+
+    uint32_t aho_corasick::_Get_class(const wchar_t _Ch) const noexcept {
+        if (static_cast<uint32_t>(_Ch) < 128) {
+            return _Myascii_classes[_Ch];
+        }
+
+        const auto _Iter = ::std::lower_bound(_Mywide_chars.begin(), _Mywide_chars.end(), _Ch);
+        return _Iter != _Mywide_chars.end() && *_Iter == _Ch ? _Mywide_classes[_Iter - _Mywide_chars.begin()] : 0;
+    }
+
+    uint32_t aho_corasick::_Pack(const uint32_t _State, const ::std::vector<_Transition>& _Row, size_t& _First_free) {
+        // Note: First fit, the base is chosen so that the first transition lands on the first free slot
+        //       or later. The row is sorted by class. The search is bounded, if no base fits, the row is
+        //       appended after the last used slot, which keeps the packing linear.
+        const uint32_t _First_class = _Row.front()._Class;
+        size_t _Base                = _First_free > _First_class ? _First_free - _First_class : 0;
+        for (size_t _Probe = 0;; ++_Probe, ++_Base) {
+            if (_Probe == _Aho_corasick_traits::_Max_probes) {
+                _Base = _Myslots.size() > _First_class ? _Myslots.size() - _First_class : 0;
+                break;
+            }
+
+            bool _Fits = true;
+            for (const _Transition& _Elem : _Row) {
+                if (_Base + _Elem._Class < _Myslots.size()
+                    && _Myslots[_Base + _Elem._Class]._Owner != _Aho_corasick_traits::_No_owner) {
+                    _Fits = false;
+                    break;
+                }
+            }
+
+            if (_Fits) {
+                break;
+            }
+        }
+
+        if (_Base + _Row.back()._Class >= _Myslots.size()) {
+            _Myslots.resize(_Base + _Row.back()._Class + 1, _Slot{_Aho_corasick_traits::_No_owner, 0});
+        }
+
+        for (const _Transition& _Elem : _Row) {
+            _Myslots[_Base + _Elem._Class] = _Slot{_State, _Elem._Target};
+        }
+
+        while (_First_free < _Myslots.size() && _Myslots[_First_free]._Owner != _Aho_corasick_traits::_No_owner) {
+            ++_First_free;
+        }
+
+        return static_cast<uint32_t>(_Base);
+    }
+
+    bool aho_corasick::empty() const noexcept {
+        return _Myroot.empty();
+    }
+
+    size_t aho_corasick::state_count() const noexcept {
+        return _Myoutput.size();
+    }
+
+    bool aho_corasick::matches(const unicode_string_view _Text) const noexcept {
+        if (_Myroot.empty()) {
+            return false;
+        }
+
+        const uint32_t* const _Root = _Myroot.data();
+        const uint32_t* const _Base = _Mybase.data();
+        const _Slot* const _Slots   = _Myslots.data();
+        const uint8_t* const _Out   = _Myoutput.data();
+        const wchar_t* const _Last  = _Text.data() + _Text.size();
+        uint32_t _State             = _Aho_corasick_traits::_Root_state;
+        uint32_t _Class;
+        for (const wchar_t* _Iter = _Text.data(); _Iter != _Last; ++_Iter) {
+            _Class            = _Get_class(_Crc32c_traits::_Fold_case(*_Iter));
+            const _Slot& _Own = _Slots[_Base[_State] + _Class];
+            _State            = _Own._Owner == _State ? _Own._Target : _Root[_Class];
+            if (_Out[_State] != 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    database_rule make_command_line_rule(const unicode_string_view _Normalized) {
+        const byte_t* const _Bytes = reinterpret_cast<const byte_t*>(_Normalized.data());
+        return database_rule{rule_kind::command_line,
+            ::std::vector<byte_t>(_Bytes, _Bytes + _Normalized.size() * sizeof(wchar_t))};
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,84 @@
+// aho_corasick.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_AHO_CORASICK_HPP_
+#define _DBMGR_AHO_CORASICK_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/database_rule.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Aho_corasick_traits {
+        // Note: The automaton is a complete DFA, each character takes exactly one transition. Most of
+        //       the transitions are the same as the transitions of the root, so only the root is stored
+        //       densely. The other states store only the transitions that differ from the root's,
+        //       packed into a shared array, where a slot belongs to a state only if its owner matches.
+        static constexpr uint32_t _Root_state = 0;
+        static constexpr uint32_t _No_owner   = UINT32_MAX; // owner of the free slots
+        static constexpr size_t _Max_probes   = 64; // number of bases tried before a row is appended
+
+        // checks if the substring can be used as a rule (not empty, no null characters)
+        static bool _Is_valid_pattern(const unicode_string_view _Pattern) noexcept;
+
+        // case-folds the substring
+        static unicode_string _Normalize(const unicode_string_view _Pattern);
+    };
+
+    class aho_corasick { // immutable set of substrings compiled into an Aho-Corasick automaton
+    public:
+        aho_corasick() noexcept;
+        aho_corasick(const aho_corasick&)     = default;
+        aho_corasick(aho_corasick&&) noexcept = default;
+        ~aho_corasick() noexcept;
+
+        explicit aho_corasick(const ::std::vector<database_rule>& _Rules);
+
+        aho_corasick& operator=(const aho_corasick&)     = default;
+        aho_corasick& operator=(aho_corasick&&) noexcept = default;
+
+        // checks if the automaton is empty (matches no text)
+        bool empty() const noexcept;
+
+        // returns the number of states
+        size_t state_count() const noexcept;
+
+        // checks if the text contains any substring (one pass, regardless of the number of substrings)
+        bool matches(const unicode_string_view _Text) const noexcept;
+
+    private:
+        struct _Transition {
+            uint32_t _Class;
+            uint32_t _Target;
+        };
+
+        struct _Slot { // owner and target are adjacent, so a transition takes a single cache line
+            uint32_t _Owner; // state that owns the slot
+            uint32_t _Target;
+        };
+
+        // returns the class of the case-folded character
+        uint32_t _Get_class(const wchar_t _Ch) const noexcept;
+
+        // packs the transitions of the state into the first free slots that fit, returns its base
+        uint32_t _Pack(const uint32_t _State, const ::std::vector<_Transition>& _Row, size_t& _First_free);
+
+        ::std::vector<uint32_t> _Myroot; // transitions of the root, indexed by class
+        ::std::vector<uint32_t> _Mybase; // offset of each state's transitions in _Myslots
+        ::std::vector<_Slot> _Myslots; // indexed by base + class
+        ::std::vector<uint8_t> _Myoutput; // non-zero if some substring ends in the state
+        ::std::vector<wchar_t> _Mywide_chars; // sorted non-ASCII characters that have their own class
+        ::std::vector<uint32_t> _Mywide_classes;
+        uint32_t _Myascii_classes[128]; // class 0 stands for all characters that no substring uses
+    };
+
+    // makes a rule that matches the command lines that contain the normalized substring
+    database_rule make_command_line_rule(const unicode_string_view _Normalized);
+} // namespace mjx
+
+#endif // _DBMGR_AHO_CORASICK_HPP_
\ No newline at end of file
@@ -0,0 +1,564 @@
+// audit_log.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <dbmgr/audit_log.hpp>
+#include <dbmgr/database.hpp>
+#include <dbmgr/membership_index.hpp>
+#include <dbmgr/path_trie.hpp>
+#include <dbmgr/tinywin.hpp>
+#include <immintrin.h> // include after <Windows.h>
+#include <mjfs/directory.hpp>
+
+namespace mjx {
+    path _Audit_log_traits::_Get_directory() {
+        return database_location::current().directory();
+    }
+
+    path _Audit_log_traits::_Get_file_path(const uint64_t _Day) {
+        wchar_t _Name[] = L"audit-00000000.log";
+        uint32_t _Year;
+        uint32_t _Month;
+        uint32_t _Day_of_month;
+        _Split_day(_Day, _Year, _Month, _Day_of_month);
+        uint32_t _Date = _Year * 10'000 + _Month * 100 + _Day_of_month;
+        for (size_t _Idx = 13; _Idx >= 6; --_Idx) { // YYYYMMDD
+            _Name[_Idx] = static_cast<wchar_t>(L'0' + _Date % 10);
+            _Date      /= 10;
+        }
+
+        return _Get_directory() / _Name;
+    }
+
+    uint64_t _Audit_log_traits::_Parse_file_name(const unicode_string_view _Name) noexcept {
+        if (_Name.size() != 18 || _Name.substr(0, 6) != L"audit-" || _Name.substr(14) != L".log") {
+            return _No_day;
+        }
+
+        const wchar_t* _First = _Name.data() + 6;
+        uint32_t _Year;
+        uint32_t _Month;
+        uint32_t _Day;
+        if (!_Parse_number(_First, _First + 4, 4, _Year) || !_Parse_number(_First, _First + 2, 2, _Month)
+            || !_Parse_number(_First, _First + 2, 2, _Day)) {
+            return _No_day;
+        }
+
+        return _Make_day(_Year, _Month, _Day);
+    }
+
+    uint64_t _Audit_log_traits::_Make_day(const uint32_t _Year, const uint32_t _Month, const uint32_t _Day) noexcept {
+        // Note: The days are counted from March 1, 0000, so the leap day is always the last day of the year.
+        //       584'694 is the number of days between March 1, 0000 and January 1, 1601.
+        static constexpr uint8_t _Days_per_month[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (_Year < 1601 || _Year > 9999 || _Month < 1 || _Month > 12 || _Day < 1) {
+            return _No_day;
+        }
+
+        const bool _Leap = (_Year % 4 == 0 && _Year % 100 != 0) || _Year % 400 == 0;
+        if (_Day > _Days_per_month[_Month - 1] + (_Month == 2 && _Leap ? 1u : 0u)) {
+            return _No_day;
+        }
+
+        const uint32_t _Shifted_year = _Month <= 2 ? _Year - 1 : _Year;
+        const uint32_t _Era          = _Shifted_year / 400;
+        const uint32_t _Year_of_era  = _Shifted_year - _Era * 400;
+        const uint32_t _Day_of_year  = (153 * (_Month > 2 ? _Month - 3 : _Month + 9) + 2) / 5 + _Day - 1;
+        const uint32_t _Day_of_era   = _Year_of_era * 365 + _Year_of_era / 4 - _Year_of_era / 100 + _Day_of_year;
+        return static_cast<uint64_t>(_Era) * 146'097 + _Day_of_era - 584'694;
+    }
+
+    void _Audit_log_traits::_Split_day(
+        const uint64_t _Days, uint32_t& _Year, uint32_t& _Month, uint32_t& _Day) noexcept {
+        const uint64_t _Shifted     = _Days + 584'694; // days since March 1, 0000
+        const uint64_t _Era         = _Shifted / 146'097;
+        const uint32_t _Day_of_era  = static_cast<uint32_t>(_Shifted - _Era * 146'097);
+        const uint32_t _Year_of_era =
+            (_Day_of_era - _Day_of_era / 1460 + _Day_of_era / 36'524 - _Day_of_era / 146'096) / 365;
+        const uint32_t _Day_of_year =
+            _Day_of_era - (_Year_of_era * 365 + _Year_of_era / 4 - _Year_of_era / 100);
+        const uint32_t _Month_idx   = (5 * _Day_of_year + 2) / 153; // March is 0
+        _Day                        = _Day_of_year - (153 * _Month_idx + 2) / 5 + 1;
+        _Month                      = _Month_idx < 10 ? _Month_idx + 3 : _Month_idx - 9;
+        _Year                       = static_cast<uint32_t>(_Era * 400) + _Year_of_era + (_Month <= 2 ? 1 : 0);
+    }
+
+    uint64_t _Audit_log_traits::_To_local_time(const uint64_t _Time) noexcept {
+        FILETIME _Utc;
+        FILETIME _Local;
+        _Utc.dwLowDateTime  = static_cast<unsigned long>(_Time);
+        _Utc.dwHighDateTime = static_cast<unsigned long>(_Time >> 32);
+        if (!::FileTimeToLocalFileTime(&_Utc, &_Local)) { // time zone unavailable, keep UTC
+            return _Time;
+        }
+
+        return (static_cast<uint64_t>(_Local.dwHighDateTime) << 32) | _Local.dwLowDateTime;
+    }
+
+    _Audit_log_traits::_Index_block _Audit_log_traits::_Make_index(
+        const audit_record* const _First, const size_t _Count) noexcept {
+        _Index_block _Index   = {};
+        _Index._Magic         = _Block_magic;
+        _Index._Count         = static_cast<uint32_t>(_Count);
+        _Index._Min_time      = UINT64_MAX;
+        _Index._Min_checksum  = UINT64_MAX;
+        _Index._Checksum      = static_cast<uint32_t>(compute_checksum(
+            byte_string_view{reinterpret_cast<const byte_t*>(_First), _Count * sizeof(audit_record)}));
+        for (const audit_record* _Record = _First; _Record != _First + _Count; ++_Record) {
+            _Index._Min_time     = (::std::min)(_Index._Min_time, _Record->time);
+            _Index._Max_time     = (::std::max)(_Index._Max_time, _Record->time);
+            _Index._Min_checksum = (::std::min)(_Index._Min_checksum, _Record->checksum);
+            _Index._Max_checksum = (::std::max)(_Index._Max_checksum, _Record->checksum);
+            _Index._Reasons     |= static_cast<uint16_t>(1u << (static_cast<uint8_t>(_Record->reason) & 15));
+            _Index._Outcomes    |= static_cast<uint8_t>(1u << (static_cast<uint8_t>(_Record->outcome) & 7));
+        }
+
+        return _Index;
+    }
+
+    bool _Audit_log_traits::_Is_valid_index(const _Index_block& _Index, const uint64_t _Size) noexcept {
+        return _Index._Magic == _Block_magic && _Index._Count > 0 && _Index._Count <= _Max_block_count
+            && _Index._Min_time <= _Index._Max_time && _Index._Min_checksum <= _Index._Max_checksum
+            && _Index._Reserved == 0 && _Index._Count * sizeof(audit_record) <= _Size;
+    }
+
+    bool _Audit_log_traits::_May_match(const _Index_block& _Index, const audit_query& _Query) noexcept {
+        return _Index._Max_time >= _Query.since && _Index._Min_time < _Query.until
+            && (_Query.checksum == 0
+                || (_Query.checksum >= _Index._Min_checksum && _Query.checksum <= _Index._Max_checksum))
+            && (_Query.outcomes == 0 || (_Index._Outcomes & _Query.outcomes) != 0);
+    }
+
+    bool _Audit_log_traits::_Must_match(const _Index_block& _Index, const audit_query& _Query) noexcept {
+        return _Index._Min_time >= _Query.since && _Index._Max_time < _Query.until
+            && (_Query.checksum == 0
+                || (_Index._Min_checksum == _Query.checksum && _Index._Max_checksum == _Query.checksum))
+            && (_Query.outcomes == 0 || (_Index._Outcomes & ~_Query.outcomes) == 0);
+    }
+
+    bool _Audit_log_traits::_Matches(const audit_record& _Record, const audit_query& _Query) noexcept {
+        const uint8_t _Outcome = static_cast<uint8_t>(_Record.outcome);
+        return _Record.time >= _Query.since && _Record.time < _Query.until
+            && (_Query.checksum == 0 || _Record.checksum == _Query.checksum)
+            && (_Query.outcomes == 0 || (_Outcome < 8 && (_Query.outcomes & (1u << _Outcome)) != 0));
+    }
+
+    [[nodiscard]] bool _Audit_log_traits::_Parse_number(
+        const wchar_t*& _First, const wchar_t* const _Last, const size_t _Digits, uint32_t& _Val) noexcept {
+        if (static_cast<size_t>(_Last - _First) < _Digits) {
+            return false;
+        }
+
+        _Val = 0;
+        for (size_t _Idx = 0; _Idx < _Digits; ++_Idx, ++_First) {
+            if (*_First < L'0' || *_First > L'9') {
+                return false;
+            }
+
+            _Val = _Val * 10 + static_cast<uint32_t>(*_First - L'0');
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] bool _Audit_log_traits::_Parse_time(
+        const unicode_string_view _Str, uint64_t& _Time, bool& _Whole_day) noexcept {
+        const wchar_t* _First      = _Str.data();
+        const wchar_t* const _Last = _First + _Str.size();
+        uint32_t _Year;
+        uint32_t _Month;
+        uint32_t _Day;
+        uint32_t _Hours   = 0;
+        uint32_t _Minutes = 0;
+        if (!_Parse_number(_First, _Last, 4, _Year) || _First == _Last || *_First++ != L'-'
+            || !_Parse_number(_First, _Last, 2, _Month) || _First == _Last || *_First++ != L'-'
+            || !_Parse_number(_First, _Last, 2, _Day)) {
+            return false;
+        }
+
+        _Whole_day = _First == _Last;
+        if (!_Whole_day) { // THH:MM
+            if (*_First++ != L'T' || !_Parse_number(_First, _Last, 2, _Hours) || _First == _Last
+                || *_First++ != L':' || !_Parse_number(_First, _Last, 2, _Minutes) || _First != _Last
+                || _Hours > 23 || _Minutes > 59) {
+                return false;
+            }
+        }
+
+        const uint64_t _Days = _Make_day(_Year, _Month, _Day);
+        if (_Days == _No_day) {
+            return false;
+        }
+
+        _Time = _Days * _Ticks_per_day + (_Hours * 60 + _Minutes) * (_Ticks_per_day / 1440);
+        return true;
+    }
+
+    [[nodiscard]] bool _Audit_log_traits::_Parse_query(
+        const unicode_string_view _Spec, audit_query& _Query, unicode_string_view& _Name) noexcept {
+        // Note: The filters are separated by commas. The application name may contain commas,
+        //       so it must be the last filter. The times are local, they're converted to UTC
+        //       with the current time zone bias.
+        _Query = audit_query{0, UINT64_MAX, 0, 0};
+        _Name  = unicode_string_view{};
+        unicode_string_view _Rest = _Spec;
+        unicode_string_view _Filter;
+        uint64_t _Time;
+        bool _Whole_day;
+        FILETIME _Local;
+        FILETIME _Utc;
+        while (!_Rest.empty()) {
+            if (_Rest.substr(0, 4) == L"app:") { // takes the rest of the query
+                _Name = _Rest.substr(4);
+                return !_Name.empty();
+            }
+
+            const size_t _Comma_pos = _Rest.find(L',');
+            _Filter                 = _Rest.substr(0, _Comma_pos);
+            _Rest                   = _Comma_pos == unicode_string_view::npos
+                ? unicode_string_view{} : _Rest.substr(_Comma_pos + 1);
+            if (_Filter.substr(0, 6) == L"since:" || _Filter.substr(0, 6) == L"until:") {
+                if (!_Parse_time(_Filter.substr(6), _Time, _Whole_day)) {
+                    return false;
+                }
+
+                if (_Filter[0] == L'u' && _Whole_day) { // the whole day is included
+                    _Time += _Ticks_per_day;
+                }
+
+                _Local.dwLowDateTime  = static_cast<unsigned long>(_Time);
+                _Local.dwHighDateTime = static_cast<unsigned long>(_Time >> 32);
+                if (::LocalFileTimeToFileTime(&_Local, &_Utc)) { // time zone unavailable, use UTC
+                    _Time = (static_cast<uint64_t>(_Utc.dwHighDateTime) << 32) | _Utc.dwLowDateTime;
+                }
+
+                (_Filter[0] == L's' ? _Query.since : _Query.until) = _Time;
+            } else if (_Filter == L"outcome:terminated") {
+                _Query.outcomes |= 1 << static_cast<uint8_t>(audit_outcome::terminated);
+            } else if (_Filter == L"outcome:exited") {
+                _Query.outcomes |= 1 << static_cast<uint8_t>(audit_outcome::exited);
+            } else if (_Filter == L"outcome:failed") {
+                _Query.outcomes |= 1 << static_cast<uint8_t>(audit_outcome::failed);
+            } else { // unknown filter
+                return false;
+            }
+        }
+
+        return _Query.since < _Query.until;
+    }
+
+    void _Audit_scan_traits::_Scan_avx2(const audit_record* _First, const audit_record* const _Last,
+        const audit_query& _Query, ::std::vector<audit_record>& _Result) {
+        // Note: Each lane holds a single record, the lanes gather the fields 3 qwords (a record) apart.
+        //       The outcome is the 6th byte of the third qword, its bit is compared with the query.
+        const __m256i _Offsets = ::_mm256_setr_epi64x(0, 3, 6, 9);
+        const __m256i _Since   = ::_mm256_set1_epi64x(static_cast<long long>(
+            (::std::min)(_Query.since, static_cast<uint64_t>(LLONG_MAX))) - 1);
+        const __m256i _Until   = ::_mm256_set1_epi64x(
+            static_cast<long long>((::std::min)(_Query.until, static_cast<uint64_t>(LLONG_MAX))));
+        const __m256i _Sum     = ::_mm256_set1_epi64x(static_cast<long long>(_Query.checksum));
+        const __m256i _Mask    = ::_mm256_set1_epi64x(_Query.outcomes);
+        const __m256i _One     = ::_mm256_set1_epi64x(1);
+        const __m256i _Byte    = ::_mm256_set1_epi64x(0xFF);
+        const __m256i _Zero    = ::_mm256_setzero_si256();
+        const long long* _Base;
+        __m256i _Time;
+        __m256i _Selected;
+        __m256i _Bit;
+        int _Bits;
+        for (; _Last - _First >= 4; _First += 4) { // compare 4 records at once
+            _Base     = reinterpret_cast<const long long*>(_First);
+            _Time     = _mm256_i64gather_epi64(_Base, _Offsets, 8);
+            _Selected = ::_mm256_and_si256(
+                ::_mm256_cmpgt_epi64(_Time, _Since), ::_mm256_cmpgt_epi64(_Until, _Time));
+            if (_Query.checksum != 0) {
+                _Selected = ::_mm256_and_si256(
+                    _Selected, ::_mm256_cmpeq_epi64(_mm256_i64gather_epi64(_Base + 1, _Offsets, 8), _Sum));
+            }
+
+            if (_Query.outcomes != 0) {
+                _Bit      = ::_mm256_sllv_epi64(_One, ::_mm256_and_si256(::_mm256_srli_epi64(
+                    _mm256_i64gather_epi64(_Base + 2, _Offsets, 8), 40), _Byte));
+                _Selected = ::_mm256_andnot_si256(
+                    ::_mm256_cmpeq_epi64(::_mm256_and_si256(_Bit, _Mask), _Zero), _Selected);
+            }
+
+            _Bits = ::_mm256_movemask_pd(::_mm256_castsi256_pd(_Selected));
+            for (int _Idx = 0; _Bits != 0; ++_Idx, _Bits >>= 1) {
+                if (_Bits & 1) {
+                    _Result.push_back(_First[_Idx]);
+                }
+            }
+        }
+
+        _Scan_software(_First, _Last, _Query, _Result); // compare the remaining records
+    }
+
+    void _Audit_scan_traits::_Scan_software(const audit_record* _First, const audit_record* const _Last,
+        const audit_query& _Query, ::std::vector<audit_record>& _Result) {
+        for (; _First != _Last; ++_First) {
+            if (_Audit_log_traits::_Matches(*_First, _Query)) {
+                _Result.push_back(*_First);
+            }
+        }
+    }
+
+    audit_log_writer::audit_log_writer() noexcept
+        : _Myfile(), _Mystream(), _Mybuf(), _Myday(_Audit_log_traits::_No_day) {}
+
+    audit_log_writer::~audit_log_writer() noexcept {}
+
+    bool audit_log_writer::_Recover() noexcept {
+        // Note: A crash may leave the last block incomplete. It's truncated, so the next block
+        //       is appended right after the last valid one. The checksums are verified by the readers.
+        const uint64_t _Size = _Myfile.size();
+        _Audit_log_traits::_File_header _Header;
+        if (_Size < sizeof(_Header) || !_Mystream.seek(0)
+            || _Mystream.read(reinterpret_cast<byte_t*>(&_Header), sizeof(_Header)) != sizeof(_Header)
+            || _Header._Magic != _Audit_log_traits::_Magic || _Header._Version != _Audit_log_traits::_Version
+            || _Header._Record_size != sizeof(audit_record) || _Header._Day != _Myday) {
+            _Header              = {}; // empty or unknown file, start a new partition
+            _Header._Magic       = _Audit_log_traits::_Magic;
+            _Header._Version     = _Audit_log_traits::_Version;
+            _Header._Record_size = static_cast<uint16_t>(sizeof(audit_record));
+            _Header._Day         = _Myday;
+            return _Myfile.resize(0) && _Mystream.seek(0)
+                && _Mystream.write(reinterpret_cast<const byte_t*>(&_Header), sizeof(_Header));
+        }
+
+        _Audit_log_traits::_Index_block _Index;
+        uint64_t _Pos = sizeof(_Header);
+        while (_Size - _Pos >= sizeof(_Index)) {
+            if (!_Mystream.seek(_Pos)
+                || _Mystream.read(reinterpret_cast<byte_t*>(&_Index), sizeof(_Index)) != sizeof(_Index)
+                || !_Audit_log_traits::_Is_valid_index(_Index, _Size - _Pos - sizeof(_Index))) {
+                break;
+            }
+
+            _Pos += sizeof(_Index) + _Index._Count * sizeof(audit_record);
+        }
+
+        if (_Pos != _Size && !_Myfile.resize(_Pos)) { // drop the torn block
+            return false;
+        }
+
+        return _Mystream.seek(_Pos);
+    }
+
+    bool audit_log_writer::_Open(const uint64_t _Day) noexcept {
+        // Note: The partition is shared for reading, so the database manager can query it while the service runs.
+        if (_Mystream.is_open() && _Myday == _Day) { // already open
+            return true;
+        }
+
+        _Mystream.close();
+        _Myfile.close();
+        _Myday = _Day;
+        try {
+            _Myfile = file(_Audit_log_traits::_Get_file_path(_Day),
+                file_access::read | file_access::write, file_share::read);
+        } catch (...) {
+            return false; // try again later
+        }
+
+        _Mystream.bind_file(_Myfile);
+        if (!_Mystream.is_open() || !_Recover()) {
+            _Mystream.close();
+            _Myfile.close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool audit_log_writer::_Write(const audit_record* _First, size_t _Count) noexcept {
+        // Note: The blocks are assembled in memory, so the partition is always extended by a single
+        //       sequential write, no matter how many records there are.
+        try {
+            size_t _Block_count;
+            _Audit_log_traits::_Index_block _Index;
+            _Mybuf.clear();
+            while (_Count > 0) {
+                _Block_count = (::std::min)(_Count, _Audit_log_traits::_Max_block_count);
+                _Index       = _Audit_log_traits::_Make_index(_First, _Block_count);
+                _Mybuf.append(reinterpret_cast<const byte_t*>(&_Index), sizeof(_Index));
+                _Mybuf.append(reinterpret_cast<const byte_t*>(_First), _Block_count * sizeof(audit_record));
+                _First += _Block_count;
+                _Count -= _Block_count;
+            }
+
+            if (!_Mybuf.empty() && !_Mystream.write(_Mybuf)) { // the block may be torn, drop it
+                _Recover();
+                return false;
+            }
+
+            return true;
+        } catch (...) {
+            return false; // not enough memory, drop the records
+        }
+    }
+
+    bool audit_log_writer::append(::std::vector<audit_record>& _Records) noexcept {
+        // Note: The records are sorted, so each partition gets a single run of records and
+        //       the time ranges of the blocks don't overlap much.
+        ::std::sort(_Records.begin(), _Records.end(),
+            [](const audit_record& _Left, const audit_record& _Right) noexcept {
+                return _Left.time < _Right.time;
+            });
+        const audit_record* _First      = _Records.data();
+        const audit_record* const _Last = _First + _Records.size();
+        const audit_record* _Next;
+        uint64_t _Day;
+        bool _Result = true;
+        while (_First != _Last) {
+            _Day  = _First->time / _Audit_log_traits::_Ticks_per_day;
+            _Next = ::std::partition_point(_First, _Last, [_Day](const audit_record& _Record) noexcept {
+                return _Record.time / _Audit_log_traits::_Ticks_per_day == _Day;
+            });
+            if (!_Open(_Day) || !_Write(_First, static_cast<size_t>(_Next - _First))) {
+                _Result = false;
+            }
+
+            _First = _Next;
+        }
+
+        return _Result;
+    }
+
+    audit_log_view::audit_log_view(const path& _Target) noexcept
+        : _Mymapping(nullptr), _Mybase(nullptr), _Mysize(0) {
+        // Note: The service may append to the partition while it's mapped, the view covers only
+        //       the blocks written before it was created.
+        file _File(_Target, file_access::read, file_share::read | file_share::write);
+        if (!_File.is_open()) {
+            return;
+        }
+
+        const uint64_t _File_size = _File.size();
+        if (_File_size < sizeof(_Audit_log_traits::_File_header)) {
+            return;
+        }
+
+#ifdef _M_X64
+        _Mysize = _File_size;
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        if (_File_size > SIZE_MAX) { // too large to be mapped
+            return;
+        }
+
+        _Mysize = static_cast<size_t>(_File_size);
+#endif // _M_X64
+        _Mymapping = ::CreateFileMappingW(_File.native_handle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_Mymapping) {
+            return;
+        }
+
+        _Mybase = ::MapViewOfFile(_Mymapping, FILE_MAP_READ, 0, 0, 0);
+        if (!_Mybase) {
+            _Unmap();
+            return;
+        }
+
+        _Audit_log_traits::_File_header _Header;
+        ::memcpy(&_Header, _Mybase, sizeof(_Header));
+        if (_Header._Magic != _Audit_log_traits::_Magic || _Header._Version != _Audit_log_traits::_Version
+            || _Header._Record_size != sizeof(audit_record)) { // unknown file
+            _Unmap();
+        }
+    }
+
+    audit_log_view::~audit_log_view() noexcept {
+        _Unmap();
+    }
+
+    void audit_log_view::_Unmap() noexcept {
+        if (_Mybase) {
+            ::UnmapViewOfFile(_Mybase);
+            _Mybase = nullptr;
+        }
+
+        if (_Mymapping) {
+            ::CloseHandle(_Mymapping);
+            _Mymapping = nullptr;
+        }
+    }
+
+    bool audit_log_view::is_open() const noexcept {
+        return _Mybase != nullptr;
+    }
+
+    void audit_log_view::query(const audit_query& _Query, ::std::vector<audit_record>& _Result) const {
+        // Note: The index block is enough to skip a block, or to take all its records at once. The records
+        //       are scanned only if the block is partially selected, and only the touched blocks are verified.
+        if (!_Mybase) {
+            return;
+        }
+
+        const byte_t* const _Bytes = static_cast<const byte_t*>(_Mybase);
+        const bool _Use_avx2       = _Membership_traits::_Use_avx2();
+        size_t _Pos                = sizeof(_Audit_log_traits::_File_header);
+        _Audit_log_traits::_Index_block _Index;
+        const audit_record* _First;
+        size_t _Size;
+        while (_Mysize - _Pos >= sizeof(_Index)) {
+            ::memcpy(&_Index, _Bytes + _Pos, sizeof(_Index));
+            if (!_Audit_log_traits::_Is_valid_index(_Index, _Mysize - _Pos - sizeof(_Index))) { // torn block
+                break;
+            }
+
+            _First = reinterpret_cast<const audit_record*>(_Bytes + _Pos + sizeof(_Index));
+            _Size  = _Index._Count * sizeof(audit_record);
+            _Pos  += sizeof(_Index) + _Size;
+            if (!_Audit_log_traits::_May_match(_Index, _Query) || static_cast<uint32_t>(compute_checksum(
+                byte_string_view{reinterpret_cast<const byte_t*>(_First), _Size})) != _Index._Checksum) {
+                continue; // nothing selected or a damaged block
+            }
+
+            if (_Audit_log_traits::_Must_match(_Index, _Query)) {
+                _Result.insert(_Result.end(), _First, _First + _Index._Count);
+            } else if (_Use_avx2) {
+                _Audit_scan_traits::_Scan_avx2(_First, _First + _Index._Count, _Query, _Result);
+            } else {
+                _Audit_scan_traits::_Scan_software(_First, _First + _Index._Count, _Query, _Result);
+            }
+        }
+    }
+
+    bool query_audit_log(const audit_query& _Query, ::std::vector<audit_record>& _Result) {
+        // Note: The partitions are named after their days, so the ones outside of the time range
+        //       aren't even mapped. The records of different appends may interleave, so they're sorted.
+        const uint64_t _First_day = _Query.since / _Audit_log_traits::_Ticks_per_day;
+        const uint64_t _Last_day  = _Query.until == 0 ? 0 : (_Query.until - 1) / _Audit_log_traits::_Ticks_per_day;
+        bool _Found               = false;
+        const wchar_t* _Name;
+        uint64_t _Day;
+        for (const directory_entry& _Entry : directory_iterator{_Audit_log_traits::_Get_directory()}) {
+            const path::string_type& _Native = _Entry.absolute_path().native();
+            _Name                            = _Native.data() + _Native.size();
+            while (_Name != _Native.data() && !_Path_trie_traits::_Is_separator(_Name[-1])) {
+                --_Name;
+            }
+
+            _Day = _Audit_log_traits::_Parse_file_name(
+                unicode_string_view{_Name, _Native.size() - static_cast<size_t>(_Name - _Native.data())});
+            if (_Day == _Audit_log_traits::_No_day || !_Entry.is_regular_file()) {
+                continue;
+            }
+
+            _Found = true;
+            if (_Day >= _First_day && _Day <= _Last_day) {
+                audit_log_view{_Entry.absolute_path()}.query(_Query, _Result);
+            }
+        }
+
+        ::std::sort(_Result.begin(), _Result.end(),
+            [](const audit_record& _Left, const audit_record& _Right) noexcept {
+                return _Left.time < _Right.time;
+            });
+        return _Found;
+    }
+} // namespace mjx
\ No newline at end of file
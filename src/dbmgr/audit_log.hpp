@@ -0,0 +1,208 @@
+// audit_log.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_AUDIT_LOG_HPP_
+#define _DBMGR_AUDIT_LOG_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    enum class audit_reason : uint8_t { // why the process was terminated
+        none           = 0,
+        checksum       = 1, // locked by the name checksum
+        path           = 2, // matched a path rule
+        name           = 3, // matched a name rule
+        command        = 4, // matched a command line rule
+        image          = 5, // matched an image rule
+        respawn        = 6, // relaunched in a loop, terminated on sight
+        instance_limit = 7, // exceeded the instance limit
+        descendant     = 8 // started by a terminated process
+    };
+
+    enum class audit_outcome : uint8_t { // result of the termination
+        terminated = 1,
+        exited     = 2, // the process exited before it could be terminated
+        failed     = 3 // the process couldn't be terminated (e.g. access denied)
+    };
+
+    struct audit_record { // single enforcement action, as reported by the service
+        uint64_t time; // FILETIME of the termination
+        checksum_t checksum; // checksum of the locked application (0 if unknown)
+        uint32_t pid;
+        audit_reason reason;
+        audit_outcome outcome;
+        uint16_t reserved; // must be zero
+    };
+
+    static_assert(sizeof(audit_record) == 24, "audit_record must be 24 bytes long");
+
+    struct audit_query { // selects the audit records
+        uint64_t since; // FILETIME of the oldest selected record (inclusive)
+        uint64_t until; // FILETIME of the newest selected record (exclusive)
+        checksum_t checksum; // selects a single application, 0 selects all applications
+        uint8_t outcomes; // combination of (1 << audit_outcome) bits, 0 selects all outcomes
+    };
+
+    struct _Audit_log_traits {
+        // Note: The log is partitioned by days (UTC), each day has its own file. A partition consists of
+        //       a file header followed by blocks. Each block starts with an index block that describes
+        //       the records that follow it (the ranges of their times and checksums, their reasons and
+        //       outcomes), so a reader can skip a whole block without touching its records, and the writer
+        //       can drop a block that was torn by a crash. The partitions are only appended to.
+        struct _File_header {
+            uint32_t _Magic; // always _Magic
+            uint16_t _Version; // always _Version
+            uint16_t _Record_size; // always sizeof(audit_record)
+            uint64_t _Day; // number of days since January 1, 1601 (UTC)
+        };
+
+        struct _Index_block {
+            uint32_t _Magic; // always _Block_magic
+            uint32_t _Count; // number of records that follow the index block
+            uint64_t _Min_time; // time of the oldest record
+            uint64_t _Max_time; // time of the newest record
+            checksum_t _Min_checksum;
+            checksum_t _Max_checksum;
+            uint32_t _Checksum; // CRC-32C of the records
+            uint16_t _Reasons; // combination of (1 << audit_reason) bits
+            uint8_t _Outcomes; // combination of (1 << audit_outcome) bits
+            uint8_t _Reserved; // must be zero
+        };
+
+        static_assert(sizeof(_File_header) == 16, "_File_header must be 16 bytes long");
+        static_assert(sizeof(_Index_block) == 48, "_Index_block must be 48 bytes long");
+
+        static constexpr uint32_t _Magic         = 0x4C41'4C41; // "ALAL" in little-endian order
+        static constexpr uint32_t _Block_magic   = 0x4249'4C41; // "ALIB" in little-endian order
+        static constexpr uint16_t _Version       = 2;
+        static constexpr size_t _Max_block_count = 4096; // maximum number of records in a single block
+        static constexpr uint64_t _Ticks_per_day = 864'000'000'000; // FILETIME ticks per day
+        static constexpr uint64_t _No_day        = UINT64_MAX; // invalid date
+
+        // returns the directory of the partitions
+        static path _Get_directory();
+
+        // returns a path to the partition of the selected day
+        static path _Get_file_path(const uint64_t _Day);
+
+        // returns the day of the partition, or _No_day if the file name doesn't name a partition
+        static uint64_t _Parse_file_name(const unicode_string_view _Name) noexcept;
+
+        // returns the number of days since January 1, 1601, or _No_day if the date is invalid
+        static uint64_t _Make_day(const uint32_t _Year, const uint32_t _Month, const uint32_t _Day) noexcept;
+
+        // splits the number of days since January 1, 1601 into the date
+        static void _Split_day(const uint64_t _Days, uint32_t& _Year, uint32_t& _Month, uint32_t& _Day) noexcept;
+
+        // converts the FILETIME to the local time (unchanged if the time zone is unavailable)
+        static uint64_t _To_local_time(const uint64_t _Time) noexcept;
+
+        // creates the index block of the records
+        static _Index_block _Make_index(const audit_record* const _First, const size_t _Count) noexcept;
+
+        // checks if the index block is valid, _Size is the number of bytes that follow it
+        static bool _Is_valid_index(const _Index_block& _Index, const uint64_t _Size) noexcept;
+
+        // checks if any record described by the index block may be selected by the query
+        static bool _May_match(const _Index_block& _Index, const audit_query& _Query) noexcept;
+
+        // checks if all records described by the index block are selected by the query
+        static bool _Must_match(const _Index_block& _Index, const audit_query& _Query) noexcept;
+
+        // checks if the record is selected by the query
+        static bool _Matches(const audit_record& _Record, const audit_query& _Query) noexcept;
+
+        // parses the query, _Name receives the application name (empty if all applications are selected)
+        [[nodiscard]] static bool _Parse_query(
+            const unicode_string_view _Spec, audit_query& _Query, unicode_string_view& _Name) noexcept;
+
+    private:
+        // parses the date (YYYY-MM-DD) and optional time (THH:MM) into local FILETIME,
+        // _Whole_day is true if the time is omitted
+        [[nodiscard]] static bool _Parse_time(
+            const unicode_string_view _Str, uint64_t& _Time, bool& _Whole_day) noexcept;
+
+        // parses the unsigned decimal number of exactly _Digits digits
+        [[nodiscard]] static bool _Parse_number(
+            const wchar_t*& _First, const wchar_t* const _Last, const size_t _Digits, uint32_t& _Val) noexcept;
+    };
+
+    struct _Audit_scan_traits {
+        // Note: The records are 24 bytes long, so the AVX2 scan gathers the fields of 4 records
+        //       at once and compares them with the query in parallel. The times are compared as signed
+        //       integers, which is safe, since no FILETIME reaches 2^63.
+
+        // scans the records with AVX2 SIMD extension support
+        static void _Scan_avx2(const audit_record* _First, const audit_record* const _Last,
+            const audit_query& _Query, ::std::vector<audit_record>& _Result);
+
+        // scans the records without AVX2 SIMD extension support
+        static void _Scan_software(const audit_record* _First, const audit_record* const _Last,
+            const audit_query& _Query, ::std::vector<audit_record>& _Result);
+    };
+
+    class audit_log_writer { // appends the records to the audit log
+    public:
+        audit_log_writer() noexcept;
+        ~audit_log_writer() noexcept;
+
+        audit_log_writer(const audit_log_writer&)            = delete;
+        audit_log_writer& operator=(const audit_log_writer&) = delete;
+
+        // sorts the records by their time and appends them to their partitions, one write per partition
+        bool append(::std::vector<audit_record>& _Records) noexcept;
+
+    private:
+        // opens the partition (creates it if it doesn't exist), drops the torn block if there is one
+        bool _Open(const uint64_t _Day) noexcept;
+
+        // finds the end of the last valid block, starts a new partition if the header is invalid
+        bool _Recover() noexcept;
+
+        // appends the records to the open partition
+        bool _Write(const audit_record* _First, size_t _Count) noexcept;
+
+        file _Myfile;
+        file_stream _Mystream;
+        byte_string _Mybuf; // reused by all appends
+        uint64_t _Myday; // day of the open partition
+    };
+
+    class audit_log_view { // read-only memory-mapped view of a single partition
+    public:
+        explicit audit_log_view(const path& _Target) noexcept;
+        ~audit_log_view() noexcept;
+
+        audit_log_view(const audit_log_view&)            = delete;
+        audit_log_view& operator=(const audit_log_view&) = delete;
+
+        // checks if the partition is mapped and valid
+        bool is_open() const noexcept;
+
+        // appends the records selected by the query to _Result
+        void query(const audit_query& _Query, ::std::vector<audit_record>& _Result) const;
+
+    private:
+        // unmaps the partition
+        void _Unmap() noexcept;
+
+        void* _Mymapping;
+        const void* _Mybase; // beginning of the mapped file
+        size_t _Mysize; // size of the mapped file
+    };
+
+    // appends the records selected by the query from all partitions to _Result, fails if there is no partition
+    bool query_audit_log(const audit_query& _Query, ::std::vector<audit_record>& _Result);
+} // namespace mjx
+
+#endif // _DBMGR_AUDIT_LOG_HPP_
\ No newline at end of file
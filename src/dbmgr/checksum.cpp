@@ -3,30 +3,70 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <cstring>
 #include <dbmgr/checksum.hpp>
 #include <dbmgr/tinywin.hpp>
 #include <nmmintrin.h> // include after <Windows.h>
 
 namespace mjx {
+    // Note: The compile-time implementations are checked against the reference vectors of CRC-32C
+    //       and XXH64, and against the UTF-16 checksums produced by the run-time implementations.
+    static_assert(_Static_checksum_traits::_Crc32c("123456789", 9, false) == 0xE306'9283,
+        "CRC-32C check value mismatch");
+    static_assert(_Static_checksum_traits::_Xxh64("", 0, false) == 0xEF46'DB37'51D8'E999,
+        "XXH64 empty string hash mismatch");
+    static_assert(_Static_checksum_traits::_Xxh64("abc", 3, false) == 0x44BC'2CF5'AD77'0999,
+        "XXH64 short string hash mismatch");
+    static_assert(_Static_checksum_traits::_Xxh64("Nobody inspects the spammish repetition", 39, false)
+        == 0xFBCE'A83C'8A37'8BF1, "XXH64 long string hash mismatch");
+    static_assert(compute_static_checksum(L"notepad.exe") == 0x28D2'2FC4, "CRC-32C UTF-16 checksum mismatch");
+    static_assert(compute_static_checksum(L"notepad.exe", checksum_mode::wide) == 0x727A'92E5'7B7C'B416,
+        "XXH64 UTF-16 hash mismatch");
+    static_assert(compute_static_checksum(L"NOTEPAD.EXE", checksum_mode::case_insensitive)
+        == compute_static_checksum(L"notepad.exe"), "CRC-32C case folding mismatch");
+    static_assert(compute_static_checksum(L"\u00C9CRAN.EXE", checksum_mode::case_insensitive | checksum_mode::wide)
+        == compute_static_checksum(L"\u00E9cran.exe", checksum_mode::wide), "XXH64 case folding mismatch");
+
     bool _Crc32c_traits::_Use_sse42() noexcept {
-        return ::IsProcessorFeaturePresent(PF_SSE4_2_INSTRUCTIONS_AVAILABLE) != 0;
+        static const bool _Available = ::IsProcessorFeaturePresent(PF_SSE4_2_INSTRUCTIONS_AVAILABLE) != 0;
+        return _Available;
     }
 
-    checksum_t _Crc32c_traits::_Compute_sse42(const void* _First, const void* const _Last) noexcept {
+    uint32_t _Crc32c_traits::_Compute_sse42(const void* _First, const void* const _Last) noexcept {
         const byte_t* _BFirst      = static_cast<const byte_t*>(_First);
         const byte_t* const _BLast = static_cast<const byte_t*>(_Last);
-        checksum_t _Val            = 0xFFFF'FFFF;
-        for (; _BFirst != _BLast; ++_BFirst) {
+        uint32_t _Val              = 0xFFFF'FFFF;
+#ifdef _M_X64
+        uint64_t _Val64            = _Val;
+        uint64_t _Word;
+        for (; _BLast - _BFirst >= 8; _BFirst += 8) { // process 8 bytes at once
+            ::memcpy(&_Word, _BFirst, 8);
+            _Val64 = ::_mm_crc32_u64(_Val64, _Word);
+        }
+
+        _Val = static_cast<uint32_t>(_Val64);
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        uint32_t _Word;
+        for (; _BLast - _BFirst >= 4; _BFirst += 4) { // process 4 bytes at once
+            ::memcpy(&_Word, _BFirst, 4);
+            _Val = ::_mm_crc32_u32(_Val, _Word);
+        }
+#endif // _M_X64
+        for (; _BFirst != _BLast; ++_BFirst) { // process the remaining bytes
             _Val = ::_mm_crc32_u8(_Val, *_BFirst);
         }
 
         return _Val ^ 0xFFFF'FFFF;
     }
 
-    checksum_t _Crc32c_traits::_Compute_software(const void* _First, const void* const _Last) noexcept {
+    uint32_t _Crc32c_traits::_Compute_software(const void* _First, const void* const _Last) noexcept {
+        return _Update_software(0xFFFF'FFFF, _First, _Last) ^ 0xFFFF'FFFF;
+    }
+
+    uint32_t _Crc32c_traits::_Update_software(
+        uint32_t _Val, const void* _First, const void* const _Last) noexcept {
         const byte_t* _BFirst                 = static_cast<const byte_t*>(_First);
         const byte_t* const _BLast            = static_cast<const byte_t*>(_Last);
-        checksum_t _Val                       = 0xFFFF'FFFF;
         static constexpr uint32_t _Table[256] = { // CRC-32C lookup table
             0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C,
             0x26A1E7E8, 0xD4CA64EB, 0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B,
@@ -76,14 +116,247 @@ namespace mjx {
             _Val = _Table[(_Val ^ *_BFirst) & 0xFF] ^ (_Val >> 8);
         }
 
+        return _Val;
+    }
+
+    inline __m128i _Fold_case_sse2(const __m128i _Chunk) noexcept {
+        // Note: Each block of 8 characters is folded with a few comparisons and one addition.
+        //       Signed comparisons are safe, all folded ranges are below 0x8000.
+        const __m128i _Upper_first  = ::_mm_set1_epi16(L'A' - 1);
+        const __m128i _Upper_last   = ::_mm_set1_epi16(L'Z' + 1);
+        const __m128i _Latin1_first = ::_mm_set1_epi16(0x00C0 - 1);
+        const __m128i _Latin1_last  = ::_mm_set1_epi16(0x00DE + 1);
+        const __m128i _Latin1_skip  = ::_mm_set1_epi16(0x00D7);
+        const __m128i _Mask         = ::_mm_or_si128(
+            ::_mm_and_si128(::_mm_cmpgt_epi16(_Chunk, _Upper_first), ::_mm_cmplt_epi16(_Chunk, _Upper_last)),
+            ::_mm_andnot_si128(::_mm_cmpeq_epi16(_Chunk, _Latin1_skip), ::_mm_and_si128(
+                ::_mm_cmpgt_epi16(_Chunk, _Latin1_first), ::_mm_cmplt_epi16(_Chunk, _Latin1_last))));
+        return ::_mm_add_epi16(_Chunk, ::_mm_and_si128(_Mask, ::_mm_set1_epi16(0x20)));
+    }
+
+    uint32_t _Crc32c_traits::_Compute_folded_sse42(const wchar_t* _First, const wchar_t* const _Last) noexcept {
+        uint32_t _Val = 0xFFFF'FFFF;
+        __m128i _Chunk;
+#ifdef _M_X64
+        uint64_t _Val64 = _Val;
+        for (; _Last - _First >= 8; _First += 8) { // process 8 characters at once
+            _Chunk = _Fold_case_sse2(::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First)));
+            _Val64 = ::_mm_crc32_u64(_Val64, static_cast<uint64_t>(::_mm_cvtsi128_si64(_Chunk)));
+            _Val64 = ::_mm_crc32_u64(
+                _Val64, static_cast<uint64_t>(::_mm_cvtsi128_si64(::_mm_unpackhi_epi64(_Chunk, _Chunk))));
+        }
+
+        _Val = static_cast<uint32_t>(_Val64);
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        for (; _Last - _First >= 8; _First += 8) { // process 8 characters at once
+            _Chunk = _Fold_case_sse2(::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First)));
+            for (int _Idx = 0; _Idx < 4; ++_Idx) { // process 2 characters at once
+                _Val   = ::_mm_crc32_u32(_Val, static_cast<uint32_t>(::_mm_cvtsi128_si32(_Chunk)));
+                _Chunk = ::_mm_srli_si128(_Chunk, 4);
+            }
+        }
+#endif // _M_X64
+        for (; _First != _Last; ++_First) { // process the remaining characters
+            _Val = ::_mm_crc32_u16(_Val, static_cast<unsigned short>(_Fold_case(*_First)));
+        }
+
         return _Val ^ 0xFFFF'FFFF;
     }
 
-    checksum_t compute_checksum(const unicode_string_view _Str) noexcept {
+    uint32_t _Crc32c_traits::_Compute_folded_software(
+        const wchar_t* _First, const wchar_t* const _Last) noexcept {
+        uint32_t _Val = 0xFFFF'FFFF;
+        wchar_t _Ch;
+        for (; _First != _Last; ++_First) {
+            _Ch  = _Fold_case(*_First);
+            _Val = _Update_software(_Val, &_Ch, &_Ch + 1);
+        }
+
+        return _Val ^ 0xFFFF'FFFF;
+    }
+
+    void _Xxh64_traits::_Process_stripe(uint64_t (&_Lanes)[4], const byte_t* const _Stripe) noexcept {
+        uint64_t _Input;
+        for (size_t _Idx = 0; _Idx < 4; ++_Idx) { // the lanes don't depend on each other
+            ::memcpy(&_Input, _Stripe + _Idx * 8, 8);
+            _Lanes[_Idx] = _Round(_Lanes[_Idx], _Input);
+        }
+    }
+
+    uint64_t _Xxh64_traits::_Merge_lanes(const uint64_t (&_Lanes)[4]) noexcept {
+        uint64_t _Hash = _Rotate(_Lanes[0], 1) + _Rotate(_Lanes[1], 7)
+            + _Rotate(_Lanes[2], 12) + _Rotate(_Lanes[3], 18);
+        for (const uint64_t _Lane : _Lanes) {
+            _Hash = (_Hash ^ _Round(0, _Lane)) * _Prime1 + _Prime4;
+        }
+
+        return _Hash;
+    }
+
+    uint64_t _Xxh64_traits::_Finalize(uint64_t _Hash, const byte_t* _First, const byte_t* const _Last) noexcept {
+        uint64_t _Word;
+        for (; _Last - _First >= 8; _First += 8) { // process 8 bytes at once
+            ::memcpy(&_Word, _First, 8);
+            _Hash = _Rotate(_Hash ^ _Round(0, _Word), 27) * _Prime1 + _Prime4;
+        }
+
+        if (_Last - _First >= 4) { // process 4 bytes at once
+            uint32_t _Half;
+            ::memcpy(&_Half, _First, 4);
+            _Hash   = _Rotate(_Hash ^ (static_cast<uint64_t>(_Half) * _Prime1), 23) * _Prime2 + _Prime3;
+            _First += 4;
+        }
+
+        for (; _First != _Last; ++_First) { // process the remaining bytes
+            _Hash = _Rotate(_Hash ^ (static_cast<uint64_t>(*_First) * _Prime5), 11) * _Prime1;
+        }
+
+        // mix all the bits
+        _Hash = (_Hash ^ (_Hash >> 33)) * _Prime2;
+        _Hash = (_Hash ^ (_Hash >> 29)) * _Prime3;
+        return _Hash ^ (_Hash >> 32);
+    }
+
+    uint64_t _Xxh64_traits::_Compute(const void* _First, const void* const _Last) noexcept {
+        const byte_t* _BFirst      = static_cast<const byte_t*>(_First);
+        const byte_t* const _BLast = static_cast<const byte_t*>(_Last);
+        const uint64_t _Size       = static_cast<uint64_t>(_BLast - _BFirst);
+        uint64_t _Hash             = _Prime5;
+        if (_Size >= 32) {
+            uint64_t _Lanes[4] = {_Prime1 + _Prime2, _Prime2, 0, 0 - _Prime1};
+            for (; _BLast - _BFirst >= 32; _BFirst += 32) { // process 32 bytes at once
+                _Process_stripe(_Lanes, _BFirst);
+            }
+
+            _Hash = _Merge_lanes(_Lanes);
+        }
+
+        return _Finalize(_Hash + _Size, _BFirst, _BLast);
+    }
+
+    uint64_t _Xxh64_traits::_Compute_folded(const wchar_t* _First, const wchar_t* const _Last) noexcept {
+        // Note: The characters are folded in registers, 8 at a time, so the result is the same
+        //       as hashing a folded copy of the string. Only the tail goes through a small buffer.
+        const uint64_t _Size = static_cast<uint64_t>(_Last - _First) * sizeof(wchar_t);
+        uint64_t _Hash       = _Prime5;
+        __m128i _Low;
+        __m128i _High;
+        if (_Size >= 32) {
+            uint64_t _Lanes[4] = {_Prime1 + _Prime2, _Prime2, 0, 0 - _Prime1};
+            for (; _Last - _First >= 16; _First += 16) { // process 16 characters (a single stripe) at once
+                _Low  = _Fold_case_sse2(::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First)));
+                _High = _Fold_case_sse2(::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First + 8)));
+#ifdef _M_X64
+                _Lanes[0] = _Round(_Lanes[0], static_cast<uint64_t>(::_mm_cvtsi128_si64(_Low)));
+                _Lanes[1] = _Round(
+                    _Lanes[1], static_cast<uint64_t>(::_mm_cvtsi128_si64(::_mm_unpackhi_epi64(_Low, _Low))));
+                _Lanes[2] = _Round(_Lanes[2], static_cast<uint64_t>(::_mm_cvtsi128_si64(_High)));
+                _Lanes[3] = _Round(
+                    _Lanes[3], static_cast<uint64_t>(::_mm_cvtsi128_si64(::_mm_unpackhi_epi64(_High, _High))));
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+                byte_t _Stripe[32];
+                ::_mm_storeu_si128(reinterpret_cast<__m128i*>(_Stripe), _Low);
+                ::_mm_storeu_si128(reinterpret_cast<__m128i*>(_Stripe + 16), _High);
+                _Process_stripe(_Lanes, _Stripe);
+#endif // _M_X64
+            }
+
+            _Hash = _Merge_lanes(_Lanes);
+        }
+
+        byte_t _Buf[32];
+        size_t _Off = 0;
+        if (_Last - _First >= 8) { // fold 8 characters at once
+            ::_mm_storeu_si128(reinterpret_cast<__m128i*>(_Buf),
+                _Fold_case_sse2(::_mm_loadu_si128(reinterpret_cast<const __m128i*>(_First))));
+            _First += 8;
+            _Off    = 16;
+        }
+
+        wchar_t _Ch;
+        for (; _First != _Last; ++_First, _Off += sizeof(wchar_t)) { // fold the remaining characters
+            _Ch = _Crc32c_traits::_Fold_case(*_First);
+            ::memcpy(_Buf + _Off, &_Ch, sizeof(wchar_t));
+        }
+
+        return _Finalize(_Hash + _Size, _Buf, _Buf + _Off);
+    }
+
+    const _Checksum_kernel _Checksum_kernel_traits::_Kernels[_Checksum_kernel_traits::_Kernel_count] = {
+        {"crc32c-software", checksum_mode::exact, false,
+            [](const wchar_t* const _First, const wchar_t* const _Last) noexcept -> checksum_t {
+                return _Crc32c_traits::_Compute_software(_First, _Last);
+            }},
+        {"crc32c-sse42", checksum_mode::exact, true,
+            [](const wchar_t* const _First, const wchar_t* const _Last) noexcept -> checksum_t {
+                return _Crc32c_traits::_Compute_sse42(_First, _Last);
+            }},
+        {"crc32c-folded-software", checksum_mode::case_insensitive, false,
+            [](const wchar_t* const _First, const wchar_t* const _Last) noexcept -> checksum_t {
+                return _Crc32c_traits::_Compute_folded_software(_First, _Last);
+            }},
+        {"crc32c-folded-sse42", checksum_mode::case_insensitive, true,
+            [](const wchar_t* const _First, const wchar_t* const _Last) noexcept -> checksum_t {
+                return _Crc32c_traits::_Compute_folded_sse42(_First, _Last);
+            }},
+        {"xxh64", checksum_mode::wide, false,
+            [](const wchar_t* const _First, const wchar_t* const _Last) noexcept -> checksum_t {
+                return _Xxh64_traits::_Compute(_First, _Last);
+            }},
+        {"xxh64-folded", checksum_mode::wide | checksum_mode::case_insensitive, false,
+            [](const wchar_t* const _First, const wchar_t* const _Last) noexcept -> checksum_t {
+                return _Xxh64_traits::_Compute_folded(_First, _Last);
+            }}
+    };
+
+    bool _Checksum_kernel_traits::_Is_available(const _Checksum_kernel& _Kernel) noexcept {
+        return !_Kernel._Needs_sse42 || _Crc32c_traits::_Use_sse42();
+    }
+
+    const _Checksum_kernel& _Checksum_kernel_traits::_Get_reference(const checksum_mode _Mode) noexcept {
+        for (const _Checksum_kernel& _Kernel : _Kernels) {
+            if (_Kernel._Mode == _Mode) { // the first kernel is the reference one
+                return _Kernel;
+            }
+        }
+
+        return _Kernels[0]; // unreachable, every mode has a kernel
+    }
+
+    _Checksum_kernel_fn _Checksum_kernel_traits::_Find_fastest(const checksum_mode _Mode) noexcept {
+        _Checksum_kernel_fn _Result = _Get_reference(_Mode)._Compute;
+        for (const _Checksum_kernel& _Kernel : _Kernels) {
+            if (_Kernel._Mode == _Mode && _Is_available(_Kernel)) { // the later kernels are faster
+                _Result = _Kernel._Compute;
+            }
+        }
+
+        return _Result;
+    }
+
+    _Checksum_kernel_fn _Checksum_kernel_traits::_Select(const checksum_mode _Mode) noexcept {
+        static const _Checksum_kernel_fn _Selected[] = {
+            _Find_fastest(checksum_mode::exact),
+            _Find_fastest(checksum_mode::case_insensitive),
+            _Find_fastest(checksum_mode::wide),
+            _Find_fastest(checksum_mode::wide | checksum_mode::case_insensitive)
+        };
+        return _Selected[static_cast<unsigned char>(_Mode & (checksum_mode::case_insensitive | checksum_mode::wide))];
+    }
+
+    checksum_t compute_checksum(const byte_string_view _Bytes) noexcept {
         if (_Crc32c_traits::_Use_sse42()) { // use SIMD-based solution
-            return _Crc32c_traits::_Compute_sse42(_Str.data(), _Str.data() + _Str.size());
+            return _Crc32c_traits::_Compute_sse42(_Bytes.data(), _Bytes.data() + _Bytes.size());
         } else { // use software-based solution
-            return _Crc32c_traits::_Compute_software(_Str.data(), _Str.data() + _Str.size());
+            return _Crc32c_traits::_Compute_software(_Bytes.data(), _Bytes.data() + _Bytes.size());
         }
     }
+
+    checksum_t compute_checksum(const unicode_string_view _Str) noexcept {
+        return _Checksum_kernel_traits::_Select(checksum_mode::exact)(_Str.data(), _Str.data() + _Str.size());
+    }
+
+    checksum_t compute_checksum(const unicode_string_view _Str, const checksum_mode _Mode) noexcept {
+        return _Checksum_kernel_traits::_Select(_Mode)(_Str.data(), _Str.data() + _Str.size());
+    }
 } // namespace mjx
\ No newline at end of file
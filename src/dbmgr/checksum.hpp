@@ -6,24 +6,220 @@
 #pragma once
 #ifndef _DBMGR_CHECKSUM_HPP_
 #define _DBMGR_CHECKSUM_HPP_
+#include <cstddef>
 #include <cstdint>
+#include <mjfs/bitmask.hpp>
 #include <mjstr/string_view.hpp>
 
 namespace mjx {
-    using checksum_t = uint32_t; // 32-bit unsigned integer
+    using checksum_t = uint64_t; // 64-bit unsigned integer (32-bit checksums are zero-extended)
+
+    enum class checksum_mode : unsigned char {
+        exact            = 0, // checksum of the raw UTF-16 code units
+        case_insensitive = 0x01, // checksum of the case-folded UTF-16 code units
+        wide             = 0x02 // 64-bit XXH64 hash instead of 32-bit CRC-32C checksum
+    };
+
+    _DECLARE_BIT_OPS(checksum_mode)
 
     struct _Crc32c_traits {
-        // checks if SSE4.2 SIMD extension can be used
+        // checks if SSE4.2 SIMD extension can be used (checked once)
         static bool _Use_sse42() noexcept;
     
         // computes CRC-32C checksum with SSE4.2 SIMD extension support
-        static checksum_t _Compute_sse42(const void* _First, const void* const _Last) noexcept;
+        static uint32_t _Compute_sse42(const void* _First, const void* const _Last) noexcept;
     
         // computes CRC-32C checksum without SSE4.2 SIMD extension support
-        static checksum_t _Compute_software(const void* _First, const void* const _Last) noexcept;
+        static uint32_t _Compute_software(const void* _First, const void* const _Last) noexcept;
+
+        // updates CRC-32C checksum without SSE4.2 SIMD extension support
+        static uint32_t _Update_software(uint32_t _Val, const void* _First, const void* const _Last) noexcept;
+
+        // Note: Case folding maps uppercase letters from the Basic Latin and Latin-1 Supplement blocks
+        //       to lowercase. Other characters are hashed as they are. The folding is done in registers,
+        //       while the checksum is being computed, so no copy of the string is needed.
+
+        // folds the case of a single character
+        static constexpr wchar_t _Fold_case(const wchar_t _Ch) noexcept {
+            if ((_Ch >= L'A' && _Ch <= L'Z') || (_Ch >= 0x00C0 && _Ch <= 0x00DE && _Ch != 0x00D7)) {
+                return static_cast<wchar_t>(_Ch + 0x20); // 0x00D7 is the multiplication sign
+            }
+
+            return _Ch;
+        }
+
+        // computes case-folded CRC-32C checksum with SSE4.2 SIMD extension support
+        static uint32_t _Compute_folded_sse42(const wchar_t* _First, const wchar_t* const _Last) noexcept;
+
+        // computes case-folded CRC-32C checksum without SSE4.2 SIMD extension support
+        static uint32_t _Compute_folded_software(const wchar_t* _First, const wchar_t* const _Last) noexcept;
+    };
+
+    struct _Xxh64_traits {
+        // Note: CRC-32C collides too often once the database stores millions of names. XXH64 is used
+        //       for 64-bit checksums, it hashes 32-byte stripes in four independent lanes, so the
+        //       multiplications overlap. It needs no CPU extension besides SSE2, which is used to fold
+        //       the case and is always available on supported systems.
+        static constexpr uint64_t _Prime1 = 0x9E37'79B1'85EB'CA87;
+        static constexpr uint64_t _Prime2 = 0xC2B2'AE3D'27D4'EB4F;
+        static constexpr uint64_t _Prime3 = 0x1656'67B1'9E37'79F9;
+        static constexpr uint64_t _Prime4 = 0x85EB'CA77'C2B2'AE63;
+        static constexpr uint64_t _Prime5 = 0x27D4'EB2F'1656'67C5;
+
+        // rotates the value to the left
+        static constexpr uint64_t _Rotate(const uint64_t _Val, const int _Shift) noexcept {
+            return (_Val << _Shift) | (_Val >> (64 - _Shift));
+        }
+
+        // mixes 8 bytes of the input into the lane
+        static constexpr uint64_t _Round(const uint64_t _Lane, const uint64_t _Input) noexcept {
+            return _Rotate(_Lane + _Input * _Prime2, 31) * _Prime1;
+        }
+
+        // processes a single 32-byte stripe
+        static void _Process_stripe(uint64_t (&_Lanes)[4], const byte_t* const _Stripe) noexcept;
+
+        // merges the lanes into a single hash
+        static uint64_t _Merge_lanes(const uint64_t (&_Lanes)[4]) noexcept;
+
+        // processes the remaining bytes (less than 32) and mixes the final hash
+        static uint64_t _Finalize(uint64_t _Hash, const byte_t* _First, const byte_t* const _Last) noexcept;
+
+        // computes XXH64 hash
+        static uint64_t _Compute(const void* _First, const void* const _Last) noexcept;
+
+        // computes case-folded XXH64 hash
+        static uint64_t _Compute_folded(const wchar_t* _First, const wchar_t* const _Last) noexcept;
+    };
+
+    using _Checksum_kernel_fn = checksum_t (*)(const wchar_t* const _First, const wchar_t* const _Last) noexcept;
+
+    struct _Checksum_kernel { // single implementation of the checksum
+        const char* _Name;
+        checksum_mode _Mode; // mode implemented by the kernel
+        bool _Needs_sse42; // true if the kernel requires SSE4.2 SIMD extension
+        _Checksum_kernel_fn _Compute;
     };
 
+    struct _Checksum_kernel_traits {
+        // Note: All the kernels are listed in a single table, so they can be enumerated, e.g. to compare
+        //       them with each other or to measure them. For each mode, the reference kernel comes first
+        //       and the fastest one comes last. The kernel for each mode is selected only once.
+        static constexpr size_t _Kernel_count = 6;
+
+        static const _Checksum_kernel _Kernels[_Kernel_count];
+
+        // checks if the kernel can run on the current CPU
+        static bool _Is_available(const _Checksum_kernel& _Kernel) noexcept;
+
+        // returns the reference kernel for the selected mode
+        static const _Checksum_kernel& _Get_reference(const checksum_mode _Mode) noexcept;
+
+        // returns the fastest available kernel for the selected mode
+        static _Checksum_kernel_fn _Select(const checksum_mode _Mode) noexcept;
+
+    private:
+        // finds the fastest available kernel for the selected mode
+        static _Checksum_kernel_fn _Find_fastest(const checksum_mode _Mode) noexcept;
+    };
+
+    struct _Static_checksum_traits {
+        // Note: These functions compute the same checksums as compute_checksum(), but at compile time.
+        //       They read the string byte by byte, so they're slow and meant for literals only.
+
+        // returns the selected byte of the string (little-endian), optionally case-folded
+        template <class _Elem>
+        static constexpr uint64_t _Get_byte(const _Elem* const _Str, const size_t _Idx, const bool _Fold) noexcept {
+            const _Elem _Ch     = _Str[_Idx / sizeof(_Elem)];
+            const uint64_t _Val = static_cast<uint64_t>(_Fold ? _Crc32c_traits::_Fold_case(_Ch) : _Ch);
+            return (_Val >> (8 * (_Idx % sizeof(_Elem)))) & 0xFF;
+        }
+
+        // returns _Count bytes of the string starting at the selected byte (little-endian)
+        template <class _Elem>
+        static constexpr uint64_t _Get_word(
+            const _Elem* const _Str, const size_t _Idx, const size_t _Count, const bool _Fold) noexcept {
+            uint64_t _Word = 0;
+            for (size_t _Off = 0; _Off < _Count; ++_Off) {
+                _Word |= _Get_byte(_Str, _Idx + _Off, _Fold) << (8 * _Off);
+            }
+
+            return _Word;
+        }
+
+        // computes CRC-32C checksum of the first _Size bytes of the string
+        template <class _Elem>
+        static constexpr uint32_t _Crc32c(const _Elem* const _Str, const size_t _Size, const bool _Fold) noexcept {
+            uint32_t _Val = 0xFFFF'FFFF;
+            for (size_t _Idx = 0; _Idx < _Size; ++_Idx) {
+                _Val ^= static_cast<uint32_t>(_Get_byte(_Str, _Idx, _Fold));
+                for (int _Bit = 0; _Bit < 8; ++_Bit) { // 0x82F63B78 is the reversed CRC-32C polynomial
+                    _Val = (_Val >> 1) ^ (0x82F6'3B78 & (0 - (_Val & 1)));
+                }
+            }
+
+            return _Val ^ 0xFFFF'FFFF;
+        }
+
+        // computes XXH64 hash of the first _Size bytes of the string
+        template <class _Elem>
+        static constexpr uint64_t _Xxh64(const _Elem* const _Str, const size_t _Size, const bool _Fold) noexcept {
+            size_t _Idx    = 0;
+            uint64_t _Hash = _Xxh64_traits::_Prime5;
+            if (_Size >= 32) {
+                uint64_t _Lanes[4] = {_Xxh64_traits::_Prime1 + _Xxh64_traits::_Prime2,
+                    _Xxh64_traits::_Prime2, 0, 0 - _Xxh64_traits::_Prime1};
+                for (; _Size - _Idx >= 32; _Idx += 32) {
+                    for (size_t _Lane = 0; _Lane < 4; ++_Lane) {
+                        _Lanes[_Lane] = _Xxh64_traits::_Round(
+                            _Lanes[_Lane], _Get_word(_Str, _Idx + _Lane * 8, 8, _Fold));
+                    }
+                }
+
+                _Hash = _Xxh64_traits::_Rotate(_Lanes[0], 1) + _Xxh64_traits::_Rotate(_Lanes[1], 7)
+                    + _Xxh64_traits::_Rotate(_Lanes[2], 12) + _Xxh64_traits::_Rotate(_Lanes[3], 18);
+                for (const uint64_t _Lane : _Lanes) {
+                    _Hash = (_Hash ^ _Xxh64_traits::_Round(0, _Lane)) * _Xxh64_traits::_Prime1
+                        + _Xxh64_traits::_Prime4;
+                }
+            }
+
+            _Hash += _Size;
+            for (; _Size - _Idx >= 8; _Idx += 8) {
+                _Hash = _Xxh64_traits::_Rotate(_Hash ^ _Xxh64_traits::_Round(0, _Get_word(_Str, _Idx, 8, _Fold)), 27)
+                    * _Xxh64_traits::_Prime1 + _Xxh64_traits::_Prime4;
+            }
+
+            if (_Size - _Idx >= 4) {
+                _Hash = _Xxh64_traits::_Rotate(_Hash ^ (_Get_word(_Str, _Idx, 4, _Fold) * _Xxh64_traits::_Prime1), 23)
+                    * _Xxh64_traits::_Prime2 + _Xxh64_traits::_Prime3;
+                _Idx += 4;
+            }
+
+            for (; _Idx < _Size; ++_Idx) {
+                _Hash = _Xxh64_traits::_Rotate(_Hash ^ (_Get_byte(_Str, _Idx, _Fold) * _Xxh64_traits::_Prime5), 11)
+                    * _Xxh64_traits::_Prime1;
+            }
+
+            _Hash = (_Hash ^ (_Hash >> 33)) * _Xxh64_traits::_Prime2;
+            _Hash = (_Hash ^ (_Hash >> 29)) * _Xxh64_traits::_Prime3;
+            return _Hash ^ (_Hash >> 32);
+        }
+    };
+
+    checksum_t compute_checksum(const byte_string_view _Bytes) noexcept;
     checksum_t compute_checksum(const unicode_string_view _Str) noexcept;
+    checksum_t compute_checksum(const unicode_string_view _Str, const checksum_mode _Mode) noexcept;
+
+    // computes the checksum of the literal at compile time (same as compute_checksum())
+    template <size_t _Size>
+    constexpr checksum_t compute_static_checksum(
+        const wchar_t (&_Str)[_Size], const checksum_mode _Mode = checksum_mode::exact) noexcept {
+        const size_t _Bytes = (_Size - 1) * sizeof(wchar_t); // skip the null-terminator
+        const bool _Fold    = _Has_bits(_Mode, checksum_mode::case_insensitive);
+        return _Has_bits(_Mode, checksum_mode::wide) ? _Static_checksum_traits::_Xxh64(_Str, _Bytes, _Fold)
+            : _Static_checksum_traits::_Crc32c(_Str, _Bytes, _Fold);
+    }
 } // namespace mjx
 
 #endif // _DBMGR_CHECKSUM_HPP_
\ No newline at end of file
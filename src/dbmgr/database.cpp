@@ -3,12 +3,14 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
 #include <cstring>
 #include <dbmgr/database.hpp>
-#ifdef _APPLOCKER_SERVICE
+#include <dbmgr/packed_entries.hpp>
 #include <dbmgr/tinywin.hpp>
-#endif // _APPLOCKER_SERVICE
 #include <mjfs/file_stream.hpp>
+#include <mjfs/status.hpp>
+#include <mjmem/object_allocator.hpp>
 #include <mjmem/smart_pointer.hpp>
 #include <type_traits>
 
@@ -77,22 +79,172 @@ namespace mjx {
         return _Myval == _Other._Myval;
     }
 
+    bool database_entry::operator<(const database_entry& _Other) const noexcept {
+        return _Myval < _Other._Myval;
+    }
+
     checksum_t database_entry::checksum() const noexcept {
         return _Myval;
     }
 
-    database::database() noexcept : _Myentries(), _Mysave(false) {
-        _Load_database();
+    database_view::database_view() noexcept
+        : _Mymapping(nullptr), _Mybase(nullptr), _Mydata(nullptr), _Mycount(0),
+        _Mywidth(sizeof(uint32_t)), _Mysorted(false), _Mypacked(false), _Myrules(false),
+        _Mymode(checksum_mode::exact), _Myenforcement(enforcement_mode::deny_list) {
+        _Map();
     }
 
-    database::~database() noexcept {
-        if (_Mysave) {
-            _Save();
+    database_view::~database_view() noexcept {
+        _Unmap();
+    }
+
+    void database_view::_Map() noexcept {
+        // Note: The file can be closed once the mapping is created, because the mapping holds
+        //       its own reference to the file. An empty file cannot be mapped, it's treated as
+        //       an empty database. Only the header is validated here, verifying the payload
+        //       checksum would defeat the purpose of the view.
+        file _File(database_location::current().file(), file_access::read, file_share::read);
+        if (!_File.is_open()) {
+            return;
+        }
+
+        const uint64_t _File_size = _File.size();
+        if (_File_size == 0) {
+            return;
+        }
+
+        _Mymapping = ::CreateFileMappingW(_File.native_handle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_Mymapping) {
+            return;
+        }
+
+        _Mybase = ::MapViewOfFile(_Mymapping, FILE_MAP_READ, 0, 0, 0);
+        if (!_Mybase) {
+            _Unmap();
+            return;
+        }
+
+        const byte_t* const _Bytes = static_cast<const byte_t*>(_Mybase);
+#ifdef _M_X64
+        const size_t _Size         = _File_size;
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        const size_t _Size         = static_cast<size_t>(_File_size);
+#endif // _M_X64
+        if (_Database_format_traits::_Has_header(_Bytes, _Size)) {
+            database_header _Header;
+            ::memcpy(&_Header, _Bytes, sizeof(database_header));
+            if (!_Database_format_traits::_Is_valid_header(_Header, _File_size)) { // invalid file
+                _Unmap();
+                return;
+            }
+
+            _Mydata        = _Bytes + sizeof(database_header);
+            _Mycount       = static_cast<size_t>(_Header.entry_count);
+            _Mywidth       = _Header.checksum_size;
+            _Mysorted      = _Has_bits(_Header.flags, database_flags::sorted);
+            _Mypacked      = _Has_bits(_Header.flags, database_flags::packed);
+            _Myrules       = _Has_bits(_Header.flags, database_flags::rules);
+            _Mymode        = _Database_format_traits::_Get_checksum_mode(_Header.flags);
+            _Myenforcement = _Database_format_traits::_Get_enforcement_mode(_Header.flags);
+            if (_Mypacked && !_Packed_entry_traits::_Is_valid(
+                _Mydata, static_cast<size_t>(_Header.payload_size), _Mycount)) { // inconsistent skip index
+                _Unmap();
+                return;
+            }
+        } else { // legacy format, unsorted and without header
+            _Mydata  = _Bytes;
+            _Mycount = _Size / sizeof(uint32_t);
+        }
+    }
+
+    void database_view::_Unmap() noexcept {
+        if (_Mybase) {
+            ::UnmapViewOfFile(_Mybase);
+            _Mybase = nullptr;
+        }
+
+        if (_Mymapping) {
+            ::CloseHandle(_Mymapping);
+            _Mymapping = nullptr;
+        }
+
+        _Mydata        = nullptr;
+        _Mycount       = 0;
+        _Mywidth       = sizeof(uint32_t);
+        _Mysorted      = false;
+        _Mypacked      = false;
+        _Myrules       = false;
+        _Mymode        = checksum_mode::exact;
+        _Myenforcement = enforcement_mode::deny_list;
+    }
+
+    checksum_t database_view::_Get_entry(const size_t _Idx) const noexcept {
+        if (_Mywidth == sizeof(uint32_t)) { // 4-byte checksum
+            uint32_t _Val; // the payload may be unaligned
+            ::memcpy(&_Val, _Mydata + _Idx * sizeof(uint32_t), sizeof(uint32_t));
+            return _Val;
+        } else { // 8-byte checksum
+            checksum_t _Val;
+            ::memcpy(&_Val, _Mydata + _Idx * sizeof(checksum_t), sizeof(checksum_t));
+            return _Val;
+        }
+    }
+
+    size_t database_view::entry_count() const noexcept {
+        return _Mycount;
+    }
+
+    checksum_mode database_view::get_checksum_mode() const noexcept {
+        return _Mymode;
+    }
+
+    enforcement_mode database_view::get_enforcement_mode() const noexcept {
+        return _Myenforcement;
+    }
+
+    bool database_view::has_rules() const noexcept {
+        return _Myrules;
+    }
+
+    bool database_view::contains(const database_entry& _Entry) const noexcept {
+        const checksum_t _Expected = _Entry.checksum();
+        if (_Mypacked) { // decode a single block
+            return _Packed_entry_traits::_Contains(_Mydata, _Mycount, _Expected);
+        } else if (_Mysorted) { // use binary search
+            size_t _First = 0;
+            size_t _Last  = _Mycount;
+            size_t _Mid;
+            checksum_t _Val;
+            while (_First < _Last) {
+                _Mid = _First + (_Last - _First) / 2;
+                _Val = _Get_entry(_Mid);
+                if (_Val == _Expected) {
+                    return true;
+                } else if (_Val < _Expected) {
+                    _First = _Mid + 1;
+                } else {
+                    _Last = _Mid;
+                }
+            }
+        } else { // use linear search
+            for (size_t _Idx = 0; _Idx < _Mycount; ++_Idx) {
+                if (_Get_entry(_Idx) == _Expected) {
+                    return true;
+                }
+            }
         }
+
+        return false;
     }
 
-    database_entry database::_Make_entry(const unicode_string_view _Name) noexcept {
-        return database_entry{compute_checksum(_Name)};
+    database::database() noexcept
+        : _Myentries(), _Myrules(), _Myview(), _Myindex(), _Myloaded(false), _Myindexed(false), _Myinvalid(false),
+        _Mymode(checksum_mode::exact), _Myenforcement(enforcement_mode::deny_list), _Mysave(false) {}
+
+    database::~database() noexcept {
+        if (_Mysave && !_Myinvalid) { // never overwrite a file that couldn't be loaded
+            _Save();
+        }
     }
 
     size_t database::_Find_entry(const database_entry& _Entry) const noexcept {
@@ -105,57 +257,247 @@ namespace mjx {
         return _Npos;
     }
 
-    void database::_Load_database() {
-        file _File(database_location::current().file(), file_access::read, file_share::read);
+    [[nodiscard]] bool database::_Load_legacy_entries(
+        file_stream& _Stream, const uint64_t _Size, ::std::vector<database_entry>& _Entries) {
+        // Note: Legacy files have no header, so incomplete trailing entries can't be detected.
+        //       As before, they are skipped.
+        const size_t _Count = static_cast<size_t>(_Size / sizeof(uint32_t));
+        _Entries.resize(_Count);
+        const size_t _Bytes = _Count * sizeof(uint32_t);
+        if (_Stream.read(reinterpret_cast<byte_t*>(_Entries.data()), _Bytes) != _Bytes) {
+            return false;
+        }
+
+        _Widen_entries(_Entries);
+        return true;
+    }
+
+    void database::_Widen_entries(::std::vector<database_entry>& _Entries) noexcept {
+        // Note: The entries are converted from the last one, so no 4-byte checksum is overwritten
+        //       before it's read.
+        const byte_t* const _Bytes = reinterpret_cast<const byte_t*>(_Entries.data());
+        uint32_t _Val;
+        for (size_t _Idx = _Entries.size(); _Idx > 0; --_Idx) {
+            ::memcpy(&_Val, _Bytes + (_Idx - 1) * sizeof(uint32_t), sizeof(uint32_t));
+            _Entries[_Idx - 1] = database_entry{_Val};
+        }
+    }
+
+    void database::_Narrow_entries(::std::vector<database_entry>& _Entries) noexcept {
+        // Note: The entries are converted from the first one, so no 8-byte checksum is overwritten
+        //       before it's read.
+        byte_t* const _Bytes = reinterpret_cast<byte_t*>(_Entries.data());
+        uint32_t _Val;
+        for (size_t _Idx = 0; _Idx < _Entries.size(); ++_Idx) {
+            _Val = static_cast<uint32_t>(_Entries[_Idx].checksum());
+            ::memcpy(_Bytes + _Idx * sizeof(uint32_t), &_Val, sizeof(uint32_t));
+        }
+    }
+
+    [[nodiscard]] bool database::_Load_packed_entries(file_stream& _Stream,
+        const database_header& _Header, ::std::vector<database_entry>& _Entries) {
+        const size_t _Payload_size = static_cast<size_t>(_Header.payload_size);
+        const size_t _Count        = static_cast<size_t>(_Header.entry_count);
+        ::std::vector<byte_t> _Payload(_Payload_size);
+        if (_Stream.read(_Payload.data(), _Payload_size) != _Payload_size) {
+            return false;
+        }
+
+        if (!_Database_format_traits::_Is_valid_payload(_Header, _Payload.data())
+            || !_Packed_entry_traits::_Is_valid(_Payload.data(), _Payload_size, _Count)) {
+            return false;
+        }
+
+        _Entries.resize(_Count);
+        _Packed_entry_traits::_Decode(_Payload.data(), _Count, _Entries.data());
+        return true;
+    }
+
+    [[nodiscard]] bool database::_Load_rules(
+        file_stream& _Stream, const uint64_t _Size, ::std::vector<database_rule>& _Rules) {
+        rule_section_header _Header;
+        if (_Stream.read(reinterpret_cast<byte_t*>(&_Header), sizeof(rule_section_header))
+            != sizeof(rule_section_header) || !_Database_format_traits::_Is_valid_rule_header(_Header, _Size)) {
+            return false;
+        }
+
+        const size_t _Payload_size = static_cast<size_t>(_Header.payload_size);
+        ::std::vector<byte_t> _Payload(_Payload_size);
+        if (_Stream.read(_Payload.data(), _Payload_size) != _Payload_size) {
+            return false;
+        }
+
+        return _Database_format_traits::_Is_valid_rules(_Header, _Payload.data())
+            && _Rule_section_traits::_Decode(_Payload.data(), _Payload_size, _Header.rule_count, _Rules);
+    }
+
+    [[nodiscard]] bool database::_Load_database() const {
+        const path& _Path = database_location::current().file();
+        file _File(_Path, file_access::read, file_share::read);
         file_stream _Stream(_File);
-        if (_Stream.is_open()) {
-            static constexpr size_t _Small_buf_size = 1024;
-#ifdef _M_X64
-            const size_t _Size                      = _File.size();
-#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
-            const size_t _Size                      = static_cast<size_t>(_File.size());
-#endif // _M_X64
-            if (_Size <= _Small_buf_size) { // use small buffer (stack)
-                byte_t _Buf[_Small_buf_size];
-                if (_Stream.read(_Buf, _Size) == _Size) {
-                    _Extract_entries_from_bytes(_Buf, _Size);
+        if (!_Stream.is_open()) { // either the database doesn't exist yet or it's being written
+            if (::mjx::exists(_Path)) {
+                return false;
+            }
+
+            _Myentries.clear();
+            _Myrules.clear();
+            _Mymode        = checksum_mode::exact;
+            _Myenforcement = enforcement_mode::deny_list;
+            return true;
+        }
+
+        // Note: The header is read first, so the file can be validated and the entries can be
+        //       allocated in O(1). The payload is then read directly into the entries.
+        const uint64_t _File_size = _File.size();
+        ::std::vector<database_entry> _Entries;
+        ::std::vector<database_rule> _Rules;
+        database_header _Header;
+        checksum_mode _Mode;
+        enforcement_mode _Enforcement = enforcement_mode::deny_list; // legacy files are always deny-lists
+        if (_File_size < sizeof(database_header)
+            || _Stream.read(reinterpret_cast<byte_t*>(&_Header), sizeof(database_header))
+                != sizeof(database_header)
+            || !_Database_format_traits::_Has_header(
+                reinterpret_cast<const byte_t*>(&_Header), sizeof(database_header))) { // legacy format
+            if (!_Stream.seek(0) || !_Load_legacy_entries(_Stream, _File_size, _Entries)) {
+                return false;
+            }
+
+            _Mode = checksum_mode::exact; // legacy files always store exact checksums
+        } else {
+            if (!_Database_format_traits::_Is_valid_header(_Header, _File_size)) { // invalid or torn file
+                return false;
+            }
+
+            _Mode        = _Database_format_traits::_Get_checksum_mode(_Header.flags);
+            _Enforcement = _Database_format_traits::_Get_enforcement_mode(_Header.flags);
+            if (_Has_bits(_Header.flags, database_flags::packed)) {
+                if (!_Load_packed_entries(_Stream, _Header, _Entries)) {
+                    return false;
+                }
+            } else {
+                const size_t _Payload_size = static_cast<size_t>(_Header.payload_size);
+                _Entries.resize(static_cast<size_t>(_Header.entry_count));
+                if (_Stream.read(reinterpret_cast<byte_t*>(_Entries.data()), _Payload_size) != _Payload_size) {
+                    return false;
                 }
-            } else { // use larger buffer (heap)
-                auto _Buf = ::mjx::make_unique_smart_array<byte_t>(_Size);
-                if (_Stream.read(_Buf.get(), _Size) == _Size) {
-                    _Extract_entries_from_bytes(_Buf.get(), _Size);
+
+                if (!_Database_format_traits::_Is_valid_payload(
+                    _Header, reinterpret_cast<const byte_t*>(_Entries.data()))) { // corrupted payload
+                    return false;
+                }
+
+                if (_Header.checksum_size == sizeof(uint32_t)) { // 4-byte checksums were read, widen them
+                    _Widen_entries(_Entries);
                 }
             }
+
+            if (_Has_bits(_Header.flags, database_flags::rules) && !_Load_rules(_Stream,
+                _File_size - sizeof(database_header) - _Header.payload_size, _Rules)) { // corrupted rules
+                return false;
+            }
         }
+
+        _Myentries     = ::std::move(_Entries);
+        _Myrules       = ::std::move(_Rules);
+        _Mymode        = _Mode;
+        _Myenforcement = _Enforcement;
+        return true;
     }
 
-    void database::_Extract_entries_from_bytes(const byte_t* const _Bytes, size_t _Count) {
-        static constexpr size_t _Bytes_per_entry = 4; // 4-byte entry
-        const size_t _Remainder                  = _Count % _Bytes_per_entry;
-        if (_Remainder != 0) { // skip incomplete entries
-            _Count -= _Remainder;
+    void database::_Materialize() const {
+        if (!_Myloaded) {
+            _Myview.reset(); // the view is no longer needed, release the file
+            if (!_Load_database()) { // invalid file, read as an empty database, but never saved over
+                _Myentries.clear();
+                _Myrules.clear();
+                _Mymode        = checksum_mode::exact;
+                _Myenforcement = enforcement_mode::deny_list;
+                _Myinvalid     = true;
+            }
+
+            _Myloaded  = true;
+            _Myindexed = false; // rebuild the index
         }
+    }
 
-        checksum_t _Val;
-        for (size_t _Off = 0; _Off < _Count; _Off += _Bytes_per_entry) {
-            ::memcpy(&_Val, _Bytes + _Off, _Bytes_per_entry);
-            _Myentries.push_back(database_entry{_Val});
+    const database_view& database::_Get_view() const {
+        if (!_Myview) {
+            _Myview.reset(::mjx::create_object<database_view>());
         }
+
+        return *_Myview;
+    }
+
+    const membership_index& database::_Get_index() const {
+        if (!_Myindexed) {
+            _Myindex   = membership_index{_Myentries};
+            _Myindexed = true;
+        }
+
+        return _Myindex;
     }
 
     void database::_Save() noexcept {
+        if (!::std::is_sorted(_Myentries.begin(), _Myentries.end())) { // sorted entries allow binary search
+            ::std::sort(_Myentries.begin(), _Myentries.end());
+        }
+
+        // Note: Large databases are stored in the packed encoding, if it makes them smaller.
+        //       If the packed buffer can't be allocated, the raw encoding is used instead.
+        const size_t _Count    = _Myentries.size();
+        const byte_t* _Payload = reinterpret_cast<const byte_t*>(_Myentries.data());
+        database_flags _Flags  = database_flags::sorted | _Database_format_traits::_Make_flags(_Mymode)
+                              | _Database_format_traits::_Make_flags(_Myenforcement);
+        size_t _Payload_size   = _Count * _Database_format_traits::_Get_checksum_size(_Flags);
+        ::std::vector<byte_t> _Packed;
+        if (_Count >= _Database_format_traits::_Packed_threshold) {
+            const size_t _Packed_size = _Packed_entry_traits::_Encoded_size(_Myentries.data(), _Count);
+            if (_Packed_size < _Payload_size) {
+                try {
+                    _Packed.resize(_Packed_size);
+                    _Packed_entry_traits::_Encode(_Myentries.data(), _Count, _Packed.data());
+                    _Payload      = _Packed.data();
+                    _Payload_size = _Packed_size;
+                    _Flags       |= database_flags::packed;
+                } catch (...) {
+                    // keep the raw encoding
+                }
+            }
+        }
+
+        // Note: Unlike the packed entries, the rules have no fallback encoding. If they can't be
+        //       encoded, the file is left intact rather than saved without them.
+        ::std::vector<byte_t> _Rules;
+        if (!_Myrules.empty()) {
+            try {
+                _Rules.resize(_Rule_section_traits::_Encoded_size(_Myrules));
+                _Rule_section_traits::_Encode(_Myrules, _Rules.data());
+                _Flags |= database_flags::rules;
+            } catch (...) {
+                return;
+            }
+        }
+
+        // Note: The entries are no longer needed once they're saved (_Save() is called only by
+        //       the destructor), so 4-byte checksums are stored in place to avoid another buffer.
+        if (!_Has_bits(_Flags, database_flags::packed) && _Payload_size < _Count * sizeof(database_entry)) {
+            _Narrow_entries(_Myentries);
+        }
+
+        const database_header _Header = _Database_format_traits::_Make_header(
+            _Payload, _Payload_size, _Count, _Flags);
         file _File(database_location::current().file(), file_access::write);
         file_stream _Stream(_File);
         if (_Stream.is_open()) {
             if (_File.resize(0)) { // must be empty
-                static constexpr size_t _Byte_count = sizeof(checksum_t);
-                byte_t _Bytes[_Byte_count];
-                checksum_t _Checksum;
-                for (const database_entry& _Entry : _Myentries) {
-                    _Checksum = _Entry.checksum();
-                    ::memcpy(_Bytes, &_Checksum, _Byte_count);
-                    if (!_Stream.write(_Bytes, _Byte_count)) { // something went wrong, break
-                        break;
+                if (_Stream.write(reinterpret_cast<const byte_t*>(&_Header), sizeof(database_header))
+                    && _Stream.write(_Payload, _Payload_size) && _Has_bits(_Flags, database_flags::rules)) {
+                    const rule_section_header _Rule_header = _Database_format_traits::_Make_rule_header(
+                        _Rules.data(), _Rules.size(), _Myrules.size());
+                    if (_Stream.write(reinterpret_cast<const byte_t*>(&_Rule_header), sizeof(rule_section_header))) {
+                        _Stream.write(_Rules.data(), _Rules.size());
                     }
                 }
             }
@@ -167,50 +509,196 @@ namespace mjx {
         return _Db;
     }
 
-    size_t database::entry_count() const noexcept {
-        return _Myentries.size();
+    size_t database::entry_count() const {
+        return _Myloaded ? _Myentries.size() : _Get_view().entry_count();
+    }
+
+    checksum_mode database::get_checksum_mode() const {
+        return _Myloaded ? _Mymode : _Get_view().get_checksum_mode();
+    }
+
+    [[nodiscard]] bool database::set_checksum_mode(const checksum_mode _Mode) {
+        // Note: Only checksums are stored, so the existing entries can't be converted.
+        _Materialize();
+        if (_Mode == _Mymode) { // nothing has changed
+            return true;
+        }
+
+        if (!_Myentries.empty() || ::std::any_of(_Myrules.begin(), _Myrules.end(),
+            [](const database_rule& _Rule) noexcept {
+                return _Rule.kind() == rule_kind::schedule || _Rule.kind() == rule_kind::instance_limit;
+            })) {
+            return false; // the schedules and the instance limits store the checksums as well
+        }
+
+        _Mymode = _Mode;
+        _Mysave = true; // save changes
+        return true;
+    }
+
+    enforcement_mode database::get_enforcement_mode() const {
+        return _Myloaded ? _Myenforcement : _Get_view().get_enforcement_mode();
+    }
+
+    void database::set_enforcement_mode(const enforcement_mode _Mode) {
+        _Materialize();
+        if (_Mode != _Myenforcement) {
+            _Myenforcement = _Mode;
+            _Mysave        = true; // save changes
+        }
+    }
+
+    database_entry database::make_entry(const unicode_string_view _Name) const {
+        return database_entry{compute_checksum(_Name, get_checksum_mode())};
+    }
+
+    bool database::has_entry(const unicode_string_view _Name) const {
+        return contains(make_entry(_Name));
     }
 
-    bool database::has_entry(const unicode_string_view _Name) const noexcept {
-        return _Find_entry(_Make_entry(_Name)) != _Npos;
+    bool database::contains(const database_entry& _Entry) const {
+        return _Myloaded ? _Get_index().contains(_Entry.checksum()) : _Get_view().contains(_Entry);
     }
 
-    const ::std::vector<database_entry>& database::get_entries() const noexcept {
+    const ::std::vector<database_entry>& database::get_entries() const {
+        _Materialize();
         return _Myentries;
     }
 
-    void database::clear() noexcept {
-        if (!_Myentries.empty()) {
-            _Myentries.clear();
+    bool database::has_rules() const {
+        return _Myloaded ? !_Myrules.empty() : _Get_view().has_rules();
+    }
+
+    const ::std::vector<database_rule>& database::get_rules() const {
+        _Materialize();
+        return _Myrules;
+    }
+
+    [[nodiscard]] bool database::append_rule(database_rule&& _Rule) {
+        if (_Rule.data().size() > _Rule_section_traits::_Max_data_size) {
+            return false;
+        }
+
+        _Materialize();
+        const auto _Iter = ::std::lower_bound(_Myrules.begin(), _Myrules.end(), _Rule);
+        if (_Iter != _Myrules.end() && *_Iter == _Rule) { // already exists
+            return false;
+        }
+
+        _Myrules.insert(_Iter, ::std::move(_Rule)); // keep the rules sorted
+        _Mysave = true; // save changes
+        return true;
+    }
+
+    [[nodiscard]] bool database::erase_rule(const database_rule& _Rule) {
+        _Materialize();
+        const auto _Iter = ::std::lower_bound(_Myrules.begin(), _Myrules.end(), _Rule);
+        if (_Iter != _Myrules.end() && *_Iter == _Rule) {
+            _Myrules.erase(_Iter);
             _Mysave = true; // save changes
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    void database::clear() {
+        if (entry_count() > 0 || has_rules()) {
+            _Myview.reset(); // the view is no longer needed, release the file
+            _Myentries.clear();
+            _Myrules.clear();
+            _Myloaded  = true; // nothing to load
+            _Myindexed = false; // rebuild the index
+            _Mysave    = true; // save changes
         }
     }
 
     [[nodiscard]] bool database::append(const unicode_string_view _Name) {
-        const database_entry& _Entry = _Make_entry(_Name);
+        _Materialize();
+        const database_entry& _Entry = make_entry(_Name);
         if (_Find_entry(_Entry) == _Npos) {
             _Myentries.push_back(_Entry);
-            _Mysave = true; // save changes
+            _Myindexed = false; // rebuild the index
+            _Mysave    = true; // save changes
             return true;
         } else {
             return false;
         }
     }
 
-    [[nodiscard]] bool database::erase(const unicode_string_view _Name) noexcept {
-        const size_t _Off = _Find_entry(_Make_entry(_Name));
+    [[nodiscard]] bool database::erase(const unicode_string_view _Name) {
+        _Materialize();
+        const size_t _Off = _Find_entry(make_entry(_Name));
         if (_Off != _Npos) {
             _Myentries.erase(_Myentries.begin() + _Off);
-            _Mysave = true; // save changes
+            _Myindexed = false; // rebuild the index
+            _Mysave    = true; // save changes
             return true;
         } else {
             return false;
         }
     }
 
-    void database::reload() {
-        _Myentries.clear();
+    size_t database::merge(::std::vector<database_entry>&& _Entries) {
+        _Materialize();
+        const size_t _Old_count = _Myentries.size();
+        if (_Myentries.empty()) {
+            _Myentries = ::std::move(_Entries);
+        } else {
+            _Myentries.insert(_Myentries.end(), _Entries.begin(), _Entries.end());
+        }
+
+        ::std::sort(_Myentries.begin(), _Myentries.end());
+        _Myentries.erase(::std::unique(_Myentries.begin(), _Myentries.end()), _Myentries.end());
+        const size_t _New_count = _Myentries.size() - _Old_count; // existing entries are unique
+        if (_New_count > 0) {
+            _Myindexed = false; // rebuild the index
+            _Mysave    = true; // save changes
+        }
+
+        return _New_count;
+    }
+
+    size_t database::erase(::std::vector<database_entry>&& _Entries) {
+        _Materialize();
+        ::std::sort(_Entries.begin(), _Entries.end());
+        const size_t _Old_count = _Myentries.size();
+        _Myentries.erase(::std::remove_if(_Myentries.begin(), _Myentries.end(),
+            [&_Entries](const database_entry& _Entry) noexcept {
+                return ::std::binary_search(_Entries.begin(), _Entries.end(), _Entry);
+            }), _Myentries.end());
+        const size_t _Erased = _Old_count - _Myentries.size();
+        if (_Erased > 0) {
+            _Myindexed = false; // rebuild the index
+            _Mysave    = true; // save changes
+        }
+
+        return _Erased;
+    }
+
+    bool database::reload() {
+        // Note: If the file is invalid (e.g. it's being written right now), the current entries
+        //       are kept. The caller will be notified again once the write is complete.
+        _Myview.reset();
         _Mysave = false; // reset changes
-        _Load_database();
+        if (_Load_database()) {
+            _Myloaded  = true;
+            _Myindexed = false; // rebuild the index
+            _Myinvalid = false;
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    bool database::is_loaded() const noexcept {
+        return _Myloaded;
+    }
+
+    bool database::is_valid() const {
+        // Note: A file that doesn't parse (torn, corrupted or written by a newer version) is read
+        //       as an empty database, but it must never be replaced by one.
+        _Materialize();
+        return !_Myinvalid;
     }
 } // namespace mjx
\ No newline at end of file
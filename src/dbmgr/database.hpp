@@ -8,8 +8,13 @@
 #define _DBMGR_DATABASE_HPP_
 #include <cstddef>
 #include <dbmgr/checksum.hpp>
+#include <dbmgr/database_format.hpp>
+#include <dbmgr/database_rule.hpp>
+#include <dbmgr/membership_index.hpp>
 #include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
 #include <mjfs/path.hpp>
+#include <mjmem/smart_pointer.hpp>
 #include <mjstr/string_view.hpp>
 #include <vector>
 
@@ -54,12 +59,61 @@ namespace mjx {
 
         // compares two entries
         bool operator==(const database_entry& _Other) const noexcept;
+        bool operator<(const database_entry& _Other) const noexcept;
 
-        // returns the stored entry as a 4-byte integer
+        // returns the stored checksum
         checksum_t checksum() const noexcept;
 
     private:
-        checksum_t _Myval; // 4-byte entry
+        checksum_t _Myval; // 8-byte entry (4-byte checksums are zero-extended)
+    };
+
+    static_assert(sizeof(database_entry) == sizeof(checksum_t),
+        "database_entry must be layout-compatible with checksum_t");
+
+    class database_view { // read-only memory-mapped view of the database file
+    public:
+        database_view() noexcept;
+        ~database_view() noexcept;
+
+        database_view(const database_view&)            = delete;
+        database_view& operator=(const database_view&) = delete;
+
+        // returns the number of entries
+        size_t entry_count() const noexcept;
+
+        // checks if the view has the selected entry
+        bool contains(const database_entry& _Entry) const noexcept;
+
+        // returns the checksum mode stored in the header
+        checksum_mode get_checksum_mode() const noexcept;
+
+        // returns the enforcement mode stored in the header
+        enforcement_mode get_enforcement_mode() const noexcept;
+
+        // checks if the file stores any rules
+        bool has_rules() const noexcept;
+
+    private:
+        // maps the database file into memory
+        void _Map() noexcept;
+
+        // unmaps the database file
+        void _Unmap() noexcept;
+
+        // returns the selected entry
+        checksum_t _Get_entry(const size_t _Idx) const noexcept;
+
+        void* _Mymapping;
+        const void* _Mybase; // beginning of the mapped file
+        const byte_t* _Mydata; // beginning of the payload
+        size_t _Mycount; // number of entries
+        size_t _Mywidth; // size of a single stored checksum (4 or 8 bytes)
+        bool _Mysorted; // true if the entries are sorted
+        bool _Mypacked; // true if the entries are packed
+        bool _Myrules; // true if the entries are followed by the rules section
+        checksum_mode _Mymode;
+        enforcement_mode _Myenforcement;
     };
 
     class database {
@@ -73,47 +127,119 @@ namespace mjx {
         static database& current() noexcept;
         
         // returns the number of entries
-        size_t entry_count() const noexcept;
+        size_t entry_count() const;
         
+        // returns the checksum mode used by all entries
+        checksum_mode get_checksum_mode() const;
+
+        // changes the checksum mode, possible only if the database is empty
+        [[nodiscard]] bool set_checksum_mode(const checksum_mode _Mode);
+
+        // returns the enforcement mode
+        enforcement_mode get_enforcement_mode() const;
+
+        // changes the enforcement mode
+        void set_enforcement_mode(const enforcement_mode _Mode);
+
+        // makes a database entry from the name (uses the current checksum mode)
+        database_entry make_entry(const unicode_string_view _Name) const;
+
         // checks if the database has the selected entry
-        bool has_entry(const unicode_string_view _Name) const noexcept;
+        bool has_entry(const unicode_string_view _Name) const;
+        bool contains(const database_entry& _Entry) const;
         
         // returns all entries
-        const ::std::vector<database_entry>& get_entries() const noexcept;
+        const ::std::vector<database_entry>& get_entries() const;
         
         // clears the database
-        void clear() noexcept;
+        void clear();
         
         // adds a new entry
         [[nodiscard]] bool append(const unicode_string_view _Name);
         
         // erases the selected entry
-        [[nodiscard]] bool erase(const unicode_string_view _Name) noexcept;
+        [[nodiscard]] bool erase(const unicode_string_view _Name);
+
+        // checks if the database has any rules
+        bool has_rules() const;
+
+        // returns all rules (sorted)
+        const ::std::vector<database_rule>& get_rules() const;
+
+        // adds a new rule
+        [[nodiscard]] bool append_rule(database_rule&& _Rule);
+
+        // erases the selected rule
+        [[nodiscard]] bool erase_rule(const database_rule& _Rule);
+
+        // merges the selected entries (sorts and removes duplicates), returns the number of new entries
+        size_t merge(::std::vector<database_entry>&& _Entries);
+
+        // erases all the selected entries, returns the number of erased entries
+        size_t erase(::std::vector<database_entry>&& _Entries);
+
+        // reloads the database, keeps the current entries if the file is invalid
+        bool reload();
 
-        // reloads the database
-        void reload();
+        // checks if the entries are loaded into memory
+        bool is_loaded() const noexcept;
+
+        // checks if the database file is valid (loads it if necessary), an invalid file is never overwritten
+        bool is_valid() const;
 
     private:
         static constexpr size_t _Npos = static_cast<size_t>(-1); // means entry not found
 
         database() noexcept;
 
-        // makes a database entry from
-        static database_entry _Make_entry(const unicode_string_view _Name) noexcept;
-
         // returns the position of the selected entry
         size_t _Find_entry(const database_entry& _Entry) const noexcept;
         
         // loads the database
-        void _Load_database();
+        [[nodiscard]] bool _Load_database() const;
+
+        // loads entries from the file in the legacy format (no header)
+        [[nodiscard]] static bool _Load_legacy_entries(
+            file_stream& _Stream, const uint64_t _Size, ::std::vector<database_entry>& _Entries);
+
+        // converts 4-byte checksums stored at the beginning of the entries to 8-byte ones (in-place)
+        static void _Widen_entries(::std::vector<database_entry>& _Entries) noexcept;
+
+        // converts the entries to 4-byte checksums stored at their beginning (in-place)
+        static void _Narrow_entries(::std::vector<database_entry>& _Entries) noexcept;
+
+        // loads entries stored in the packed encoding
+        [[nodiscard]] static bool _Load_packed_entries(file_stream& _Stream,
+            const database_header& _Header, ::std::vector<database_entry>& _Entries);
+
+        // loads the rules section that follows the payload
+        [[nodiscard]] static bool _Load_rules(file_stream& _Stream,
+            const uint64_t _Size, ::std::vector<database_rule>& _Rules);
+
+        // loads the database if it hasn't been loaded yet
+        void _Materialize() const;
+
+        // returns the read-only view of the database file, maps it if necessary
+        const database_view& _Get_view() const;
 
-        // extracts the database entries from raw bytes
-        void _Extract_entries_from_bytes(const byte_t* const _Bytes, size_t _Count);
+        // returns the index of the loaded entries, builds it if necessary
+        const membership_index& _Get_index() const;
         
         // saves the database
         void _Save() noexcept;
 
-        ::std::vector<database_entry> _Myentries;
+        // Note: The database is loaded lazily. Read-only queries are answered from a memory-mapped
+        //       view of the file, the entries are loaded into memory only when they are requested
+        //       or modified.
+        mutable ::std::vector<database_entry> _Myentries;
+        mutable ::std::vector<database_rule> _Myrules; // loaded together with the entries
+        mutable unique_smart_ptr<database_view> _Myview;
+        mutable membership_index _Myindex; // built on the first lookup after the entries change
+        mutable bool _Myloaded; // true if the entries are loaded into memory
+        mutable bool _Myindexed; // true if _Myindex matches the entries
+        mutable bool _Myinvalid; // true if the file exists but couldn't be loaded (never saved over)
+        mutable checksum_mode _Mymode; // read from the header together with the entries
+        mutable enforcement_mode _Myenforcement; // read from the header together with the entries
         bool _Mysave; // true if the database should be saved
     };
 } // namespace mjx
@@ -0,0 +1,157 @@
+// database_format.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <dbmgr/database_format.hpp>
+#include <dbmgr/packed_entries.hpp>
+
+namespace mjx {
+    database_flags _Database_format_traits::_Make_flags(const checksum_mode _Mode) noexcept {
+        database_flags _Flags = database_flags::none;
+        if (_Has_bits(_Mode, checksum_mode::case_insensitive)) {
+            _Flags |= database_flags::case_insensitive;
+        }
+
+        if (_Has_bits(_Mode, checksum_mode::wide)) {
+            _Flags |= database_flags::wide;
+        }
+
+        return _Flags;
+    }
+
+    checksum_mode _Database_format_traits::_Get_checksum_mode(const database_flags _Flags) noexcept {
+        checksum_mode _Mode = checksum_mode::exact;
+        if (_Has_bits(_Flags, database_flags::case_insensitive)) {
+            _Mode |= checksum_mode::case_insensitive;
+        }
+
+        if (_Has_bits(_Flags, database_flags::wide)) {
+            _Mode |= checksum_mode::wide;
+        }
+
+        return _Mode;
+    }
+
+    database_flags _Database_format_traits::_Make_flags(const enforcement_mode _Mode) noexcept {
+        return _Mode == enforcement_mode::allow_list ? database_flags::allow_list : database_flags::none;
+    }
+
+    enforcement_mode _Database_format_traits::_Get_enforcement_mode(const database_flags _Flags) noexcept {
+        return _Has_bits(_Flags, database_flags::allow_list)
+            ? enforcement_mode::allow_list : enforcement_mode::deny_list;
+    }
+
+    size_t _Database_format_traits::_Get_checksum_size(const database_flags _Flags) noexcept {
+        return _Has_bits(_Flags, database_flags::wide) ? sizeof(uint64_t) : sizeof(uint32_t);
+    }
+
+    uint16_t _Database_format_traits::_Get_version(const database_flags _Flags) noexcept {
+        if (_Has_bits(_Flags, database_flags::allow_list)) {
+            return _Version;
+        } else if (_Has_bits(_Flags, database_flags::rules)) {
+            return _Rules_version;
+        } else if (_Has_bits(_Flags, database_flags::wide)) {
+            return _Wide_version;
+        } else {
+            return _Narrow_version;
+        }
+    }
+
+    database_header _Database_format_traits::_Make_header(const byte_t* const _Payload,
+        const size_t _Size, const size_t _Count, const database_flags _Flags) noexcept {
+        database_header _Header  = {0};
+        _Header.magic            = _Magic;
+        _Header.version          = _Get_version(_Flags);
+        _Header.flags            = _Flags;
+        _Header.checksum_size    = static_cast<uint8_t>(_Get_checksum_size(_Flags));
+        _Header.payload_checksum = static_cast<uint32_t>(
+            compute_checksum(byte_string_view{_Payload, _Size}));
+        _Header.entry_count      = _Count;
+        _Header.payload_size     = _Size;
+        return _Header;
+    }
+
+    bool _Database_format_traits::_Has_header(const byte_t* const _Bytes, const size_t _Size) noexcept {
+        if (_Size < sizeof(database_header)) {
+            return false;
+        }
+
+        uint32_t _Val;
+        ::memcpy(&_Val, _Bytes, sizeof(uint32_t));
+        return _Val == _Magic;
+    }
+
+    bool _Database_format_traits::_Is_valid_header(
+        const database_header& _Header, const uint64_t _File_size) noexcept {
+        if (_Header.magic != _Magic || _Header.version == 0 || _Header.version > _Version) {
+            return false; // unknown format
+        }
+
+        if (_Header.checksum_size != _Get_checksum_size(_Header.flags)) {
+            return false; // incompatible checksum width
+        }
+
+        if (_Header.reserved[0] != 0 || _Header.reserved[1] != 0 || _Header.reserved[2] != 0) {
+            return false;
+        }
+
+        if (_File_size < sizeof(database_header)) {
+            return false; // torn or truncated write
+        }
+
+        const uint64_t _Remaining = _File_size - sizeof(database_header);
+        if (_Has_bits(_Header.flags, database_flags::rules)) { // the rules section follows the payload
+            if (_Remaining < sizeof(rule_section_header)
+                || _Header.payload_size > _Remaining - sizeof(rule_section_header)) {
+                return false; // torn or truncated write
+            }
+        } else if (_Header.payload_size != _Remaining) {
+            return false; // torn or truncated write
+        }
+
+        if (_Has_bits(_Header.flags, database_flags::packed)) { // must store at least the skip index
+            constexpr uint64_t _Block_size = _Packed_entry_traits::_Block_size;
+            const uint64_t _Blocks         = _Header.entry_count / _Block_size
+                + (_Header.entry_count % _Block_size != 0 ? 1 : 0);
+            return _Has_bits(_Header.flags, database_flags::sorted)
+                && _Header.payload_size >= _Packed_entry_traits::_Padding_size
+                && _Blocks <= (_Header.payload_size - _Packed_entry_traits::_Padding_size)
+                    / sizeof(_Packed_entry_traits::_Block_info);
+        } else { // must store exactly entry_count checksums
+            return _Header.entry_count <= _Header.payload_size / _Header.checksum_size
+                && _Header.entry_count * _Header.checksum_size == _Header.payload_size;
+        }
+    }
+
+    bool _Database_format_traits::_Is_valid_payload(
+        const database_header& _Header, const byte_t* const _Payload) noexcept {
+        return static_cast<uint32_t>(compute_checksum(byte_string_view{
+            _Payload, static_cast<size_t>(_Header.payload_size)})) == _Header.payload_checksum;
+    }
+
+    rule_section_header _Database_format_traits::_Make_rule_header(
+        const byte_t* const _Rules, const size_t _Size, const size_t _Count) noexcept {
+        rule_section_header _Header;
+        _Header.rule_count       = static_cast<uint32_t>(_Count);
+        _Header.payload_checksum = static_cast<uint32_t>(compute_checksum(byte_string_view{_Rules, _Size}));
+        _Header.payload_size     = _Size;
+        return _Header;
+    }
+
+    bool _Database_format_traits::_Is_valid_rule_header(
+        const rule_section_header& _Header, const uint64_t _Size) noexcept {
+        // Note: _Size is the size of the whole section, including the rules header. Each rule takes
+        //       at least 4 bytes (the record header), which bounds the rule count.
+        return _Size >= sizeof(rule_section_header)
+            && _Header.payload_size == _Size - sizeof(rule_section_header)
+            && _Header.rule_count <= _Header.payload_size / 4;
+    }
+
+    bool _Database_format_traits::_Is_valid_rules(
+        const rule_section_header& _Header, const byte_t* const _Rules) noexcept {
+        return static_cast<uint32_t>(compute_checksum(byte_string_view{
+            _Rules, static_cast<size_t>(_Header.payload_size)})) == _Header.payload_checksum;
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,114 @@
+// database_format.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_DATABASE_FORMAT_HPP_
+#define _DBMGR_DATABASE_FORMAT_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <mjfs/bitmask.hpp>
+
+namespace mjx {
+    enum class database_flags : uint16_t {
+        none             = 0,
+        sorted           = 0x0001, // entries are sorted in ascending order
+        packed           = 0x0002, // entries are stored as bit-packed deltas (see _Packed_entry_traits)
+        case_insensitive = 0x0004, // entries are checksums of case-folded names
+        wide             = 0x0008, // entries are 8-byte XXH64 hashes instead of 4-byte CRC-32C checksums
+        rules            = 0x0010, // the payload is followed by the rules section (see rule_section_header)
+        allow_list       = 0x0020 // entries are permitted applications, all the others are terminated
+    };
+
+    _DECLARE_BIT_OPS(database_flags)
+
+    enum class enforcement_mode : unsigned char {
+        deny_list, // locked applications are terminated
+        allow_list // all applications except the permitted ones are terminated
+    };
+
+    struct database_header { // header of the database file
+        uint32_t magic; // always _Database_format_traits::_Magic
+        uint16_t version; // format version
+        database_flags flags;
+        uint8_t checksum_size; // size of a single checksum (4 or 8 bytes)
+        uint8_t reserved[3]; // must be zero
+        uint32_t payload_checksum; // CRC-32C of the payload
+        uint64_t entry_count; // number of entries stored in the payload
+        uint64_t payload_size; // size of the payload (in bytes)
+    };
+
+    static_assert(sizeof(database_header) == 32, "database_header must be 32 bytes long");
+
+    struct rule_section_header { // header of the rules section
+        uint32_t rule_count; // number of rules stored in the section
+        uint32_t payload_checksum; // CRC-32C of the rules
+        uint64_t payload_size; // size of the rules (in bytes)
+    };
+
+    static_assert(sizeof(rule_section_header) == 16, "rule_section_header must be 16 bytes long");
+
+    struct _Database_format_traits {
+        // Note: Legacy database files don't have any header, they are a raw concatenation
+        //       of 4-byte checksums. A file is treated as a legacy one if it doesn't start
+        //       with the magic value.
+        static constexpr uint32_t _Magic   = 0x4244'4C41; // "ALDB" in little-endian order
+        static constexpr uint16_t _Version = 5; // version 5 introduced the allow-list mode
+
+        // Note: Files are written with the lowest version that can describe them, so they can be read
+        //       by older versions of the application as long as they don't use the newer features.
+        //       An older version must never read an allow-list file, it would lock the permitted applications.
+        static constexpr uint16_t _Rules_version  = 4; // version 4 introduced the rules section
+        static constexpr uint16_t _Wide_version   = 3; // version 3 introduced 8-byte checksums
+        static constexpr uint16_t _Narrow_version = 2; // version 2 introduced the packed encoding
+
+        // Note: The packed encoding is used only if it makes the payload smaller. It's not
+        //       worth the effort for small databases.
+        static constexpr size_t _Packed_threshold = 1024; // minimum number of entries
+
+        // converts the checksum mode to the header flags
+        static database_flags _Make_flags(const checksum_mode _Mode) noexcept;
+
+        // converts the header flags to the checksum mode
+        static checksum_mode _Get_checksum_mode(const database_flags _Flags) noexcept;
+
+        // converts the enforcement mode to the header flags
+        static database_flags _Make_flags(const enforcement_mode _Mode) noexcept;
+
+        // converts the header flags to the enforcement mode
+        static enforcement_mode _Get_enforcement_mode(const database_flags _Flags) noexcept;
+
+        // returns the size of a single checksum stored in the payload
+        static size_t _Get_checksum_size(const database_flags _Flags) noexcept;
+
+        // returns the lowest version that supports the header flags
+        static uint16_t _Get_version(const database_flags _Flags) noexcept;
+
+        // makes a header that describes the payload
+        static database_header _Make_header(const byte_t* const _Payload, const size_t _Size,
+            const size_t _Count, const database_flags _Flags) noexcept;
+
+        // checks if the file starts with the header
+        static bool _Has_header(const byte_t* const _Bytes, const size_t _Size) noexcept;
+
+        // checks if the header is compatible and consistent with the file size (O(1))
+        static bool _Is_valid_header(const database_header& _Header, const uint64_t _File_size) noexcept;
+
+        // checks if the payload matches the checksum stored in the header
+        static bool _Is_valid_payload(const database_header& _Header, const byte_t* const _Payload) noexcept;
+
+        // makes a header that describes the rules
+        static rule_section_header _Make_rule_header(
+            const byte_t* const _Rules, const size_t _Size, const size_t _Count) noexcept;
+
+        // checks if the rules header is consistent with the remaining file size (O(1))
+        static bool _Is_valid_rule_header(const rule_section_header& _Header, const uint64_t _Size) noexcept;
+
+        // checks if the rules match the checksum stored in the rules header
+        static bool _Is_valid_rules(const rule_section_header& _Header, const byte_t* const _Rules) noexcept;
+    };
+} // namespace mjx
+
+#endif // _DBMGR_DATABASE_FORMAT_HPP_
\ No newline at end of file
@@ -0,0 +1,79 @@
+// database_rule.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <dbmgr/database_rule.hpp>
+
+namespace mjx {
+    database_rule::database_rule() noexcept : _Mykind(rule_kind::image_hash), _Mydata() {}
+
+    database_rule::database_rule(const rule_kind _Kind, ::std::vector<byte_t>&& _Data) noexcept
+        : _Mykind(_Kind), _Mydata(::std::move(_Data)) {}
+
+    database_rule::~database_rule() noexcept {}
+
+    bool database_rule::operator==(const database_rule& _Other) const noexcept {
+        return _Mykind == _Other._Mykind && _Mydata == _Other._Mydata;
+    }
+
+    bool database_rule::operator<(const database_rule& _Other) const noexcept {
+        return _Mykind != _Other._Mykind ? _Mykind < _Other._Mykind : _Mydata < _Other._Mydata;
+    }
+
+    rule_kind database_rule::kind() const noexcept {
+        return _Mykind;
+    }
+
+    const ::std::vector<byte_t>& database_rule::data() const noexcept {
+        return _Mydata;
+    }
+
+    size_t _Rule_section_traits::_Encoded_size(const ::std::vector<database_rule>& _Rules) noexcept {
+        size_t _Size = 0;
+        for (const database_rule& _Rule : _Rules) {
+            _Size += sizeof(_Record_header) + _Rule.data().size();
+        }
+
+        return _Size;
+    }
+
+    void _Rule_section_traits::_Encode(const ::std::vector<database_rule>& _Rules, byte_t* _Dest) noexcept {
+        _Record_header _Header = {};
+        for (const database_rule& _Rule : _Rules) {
+            _Header._Kind = _Rule.kind();
+            _Header._Size = static_cast<uint16_t>(_Rule.data().size());
+            ::memcpy(_Dest, &_Header, sizeof(_Record_header));
+            _Dest += sizeof(_Record_header);
+            if (_Header._Size > 0) {
+                ::memcpy(_Dest, _Rule.data().data(), _Header._Size);
+                _Dest += _Header._Size;
+            }
+        }
+    }
+
+    [[nodiscard]] bool _Rule_section_traits::_Decode(const byte_t* _Payload, const size_t _Size,
+        const size_t _Count, ::std::vector<database_rule>& _Rules) {
+        const byte_t* const _Last = _Payload + _Size;
+        _Record_header _Header;
+        _Rules.clear();
+        _Rules.reserve(_Count);
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+            if (static_cast<size_t>(_Last - _Payload) < sizeof(_Record_header)) {
+                return false; // truncated record header
+            }
+
+            ::memcpy(&_Header, _Payload, sizeof(_Record_header));
+            _Payload += sizeof(_Record_header);
+            if (_Header._Reserved != 0 || static_cast<size_t>(_Last - _Payload) < _Header._Size) {
+                return false; // unknown record or truncated rule data
+            }
+
+            _Rules.emplace_back(_Header._Kind, ::std::vector<byte_t>(_Payload, _Payload + _Header._Size));
+            _Payload += _Header._Size;
+        }
+
+        return _Payload == _Last;
+    }
+} // namespace mjx
\ No newline at end of file
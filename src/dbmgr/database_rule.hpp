@@ -0,0 +1,77 @@
+// database_rule.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_DATABASE_RULE_HPP_
+#define _DBMGR_DATABASE_RULE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    enum class rule_kind : uint8_t {
+        image_hash     = 1, // SHA-256 hash of the executable image
+        full_path      = 2, // normalized path of the executable image
+        directory      = 3, // normalized path of a directory that contains the executable image
+        name_glob      = 4, // case-folded wildcard pattern of the executable name (* and ? wildcards)
+        command_line   = 5, // case-folded substring of the command line (only interpreters are checked)
+        schedule       = 6, // name checksum locked only within a weekly time window
+        instance_limit = 7 // name checksum with the maximum number of running instances
+    };
+
+    class database_rule { // rule that matches processes by something other than their names
+    public:
+        database_rule() noexcept;
+        database_rule(const database_rule&)     = default;
+        database_rule(database_rule&&) noexcept = default;
+        ~database_rule() noexcept;
+
+        database_rule(const rule_kind _Kind, ::std::vector<byte_t>&& _Data) noexcept;
+
+        database_rule& operator=(const database_rule&)     = default;
+        database_rule& operator=(database_rule&&) noexcept = default;
+
+        // compares two rules
+        bool operator==(const database_rule& _Other) const noexcept;
+        bool operator<(const database_rule& _Other) const noexcept;
+
+        // returns the rule kind
+        rule_kind kind() const noexcept;
+
+        // returns the rule data (its meaning depends on the kind)
+        const ::std::vector<byte_t>& data() const noexcept;
+
+    private:
+        rule_kind _Mykind;
+        ::std::vector<byte_t> _Mydata;
+    };
+
+    struct _Rule_section_traits {
+        // Note: The rules section follows the entries. It starts with rule_section_header and stores
+        //       the rules sorted, each one as a record header followed by the rule data.
+        struct _Record_header {
+            rule_kind _Kind;
+            uint8_t _Reserved; // must be zero
+            uint16_t _Size; // size of the rule data (in bytes)
+        };
+
+        static_assert(sizeof(_Record_header) == 4, "_Record_header must be 4 bytes long");
+
+        static constexpr size_t _Max_data_size = 0xFFFF;
+
+        // returns the size of the encoded rules (in bytes)
+        static size_t _Encoded_size(const ::std::vector<database_rule>& _Rules) noexcept;
+
+        // encodes the rules, _Dest must be at least _Encoded_size() bytes long
+        static void _Encode(const ::std::vector<database_rule>& _Rules, byte_t* _Dest) noexcept;
+
+        // decodes the rules, fails if the payload is inconsistent
+        [[nodiscard]] static bool _Decode(const byte_t* _Payload, const size_t _Size,
+            const size_t _Count, ::std::vector<database_rule>& _Rules);
+    };
+} // namespace mjx
+
+#endif // _DBMGR_DATABASE_RULE_HPP_
\ No newline at end of file
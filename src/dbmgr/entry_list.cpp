@@ -0,0 +1,191 @@
+// entry_list.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cstring>
+#include <dbmgr/entry_list.hpp>
+#include <dbmgr/tinywin.hpp>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+
+namespace mjx {
+    [[nodiscard]] bool _Entry_list_traits::_Read_file(const path& _Path, ::std::vector<char>& _Buf) {
+        file _File(_Path, file_access::read, file_share::read);
+        file_stream _Stream(_File);
+        if (!_Stream.is_open()) {
+            return false;
+        }
+
+#ifdef _M_X64
+        const size_t _Size = _File.size();
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        const size_t _Size = static_cast<size_t>(_File.size());
+#endif // _M_X64
+        _Buf.resize(_Size);
+        return _Stream.read(reinterpret_cast<byte_t*>(_Buf.data()), _Size) == _Size;
+    }
+
+    ::std::vector<_Entry_list_traits::_Chunk> _Entry_list_traits::_Split(
+        const char* _First, const char* const _Last, const checksum_mode _Mode, size_t _Count) {
+        const size_t _Size = static_cast<size_t>(_Last - _First);
+        if (_Size < _Parallel_threshold) { // small list, don't split
+            _Count = 1;
+        }
+
+        ::std::vector<_Chunk> _Chunks;
+        _Chunks.reserve(_Count);
+        const size_t _Chunk_size = _Size / _Count;
+        const char* _Chunk_last;
+        for (size_t _Idx = 1; _Idx < _Count && _First != _Last; ++_Idx) {
+            _Chunk_last = _First + _Chunk_size;
+            if (_Chunk_last >= _Last) {
+                break;
+            }
+
+            // move the chunk boundary past the end of the current line
+            _Chunk_last = static_cast<const char*>(
+                ::memchr(_Chunk_last, '\n', static_cast<size_t>(_Last - _Chunk_last)));
+            if (!_Chunk_last) { // no more lines, the last chunk takes the rest
+                break;
+            }
+
+            ++_Chunk_last;
+            _Chunks.push_back(_Chunk{_First, _Chunk_last, _Mode, {}, 0, false});
+            _First = _Chunk_last;
+        }
+
+        if (_First != _Last) {
+            _Chunks.push_back(_Chunk{_First, _Last, _Mode, {}, 0, false});
+        }
+
+        return _Chunks;
+    }
+
+    void _Entry_list_traits::_Hash_chunk(_Chunk& _Target) {
+        const char* _First      = _Target._First;
+        const char* const _Last = _Target._Last;
+        const char* _Line_last;
+        size_t _Length;
+        wchar_t _Name[_Max_name_length];
+        int _Converted; // number of converted characters
+        while (_First != _Last) {
+            _Line_last = static_cast<const char*>(
+                ::memchr(_First, '\n', static_cast<size_t>(_Last - _First)));
+            if (!_Line_last) { // the last line is not terminated
+                _Line_last = _Last;
+            }
+
+            _Length = static_cast<size_t>(_Line_last - _First);
+            if (_Length > 0 && _First[_Length - 1] == '\r') { // skip CR from CRLF
+                --_Length;
+            }
+
+            if (_Length > 0) { // skip empty lines
+                _Converted = ::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, _First,
+                    static_cast<int>(_Length), _Name, static_cast<int>(_Max_name_length));
+                if (_Converted > 0) {
+                    _Target._Entries.push_back(database_entry{compute_checksum(
+                        unicode_string_view{_Name, static_cast<size_t>(_Converted)}, _Target._Mode)});
+                } else { // the name is too long or malformed, reported by the caller
+                    ++_Target._Skipped;
+                }
+            }
+
+            _First = _Line_last != _Last ? _Line_last + 1 : _Last;
+        }
+    }
+
+    [[nodiscard]] bool _Entry_list_traits::_Hash_parallel(::std::vector<_Chunk>& _Chunks) {
+        // Note: The chunks are hashed on plain threads, at most MAXIMUM_WAIT_OBJECTS of them, so that
+        //       the calling thread can wait for all of them at once. If a thread can't be created,
+        //       its chunk is hashed on the calling thread instead.
+        ::std::vector<HANDLE> _Threads;
+        _Threads.reserve(_Chunks.size());
+        HANDLE _Thread;
+        for (_Chunk& _Target : _Chunks) {
+            _Thread = ::CreateThread(nullptr, 0,
+                [](void* _Arg) -> unsigned long {
+                    _Chunk* const _Local_target = static_cast<_Chunk*>(_Arg);
+                    try {
+                        _Hash_chunk(*_Local_target);
+                    } catch (...) {
+                        _Local_target->_Failed = true; // not enough memory
+                    }
+
+                    return 0;
+                },
+                &_Target, 0, nullptr
+            );
+            if (_Thread) {
+                _Threads.push_back(_Thread);
+                continue;
+            }
+
+            try { // the other threads still use the chunks, so the exception can't leave yet
+                _Hash_chunk(_Target);
+            } catch (...) {
+                _Target._Failed = true; // not enough memory
+            }
+        }
+
+        if (!_Threads.empty()) {
+            ::WaitForMultipleObjects(
+                static_cast<unsigned long>(_Threads.size()), _Threads.data(), TRUE, INFINITE);
+            for (const HANDLE _Handle : _Threads) {
+                ::CloseHandle(_Handle);
+            }
+        }
+
+        for (const _Chunk& _Target : _Chunks) {
+            if (_Target._Failed) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] bool import_entry_list(const path& _Path, const checksum_mode _Mode,
+        ::std::vector<database_entry>& _Entries, size_t& _Skipped) {
+        ::std::vector<char> _Buf;
+        if (!_Entry_list_traits::_Read_file(_Path, _Buf)) {
+            return false;
+        }
+
+        const char* _First      = _Buf.data();
+        const char* const _Last = _Buf.data() + _Buf.size();
+        if (_Buf.size() >= 3 && ::memcmp(_First, "\xEF\xBB\xBF", 3) == 0) { // skip UTF-8 BOM
+            _First += 3;
+        }
+
+        SYSTEM_INFO _Info;
+        ::GetSystemInfo(&_Info);
+        const size_t _Thread_count = (::std::min)(
+            static_cast<size_t>(_Info.dwNumberOfProcessors), static_cast<size_t>(MAXIMUM_WAIT_OBJECTS));
+        auto _Chunks               = _Entry_list_traits::_Split(
+            _First, _Last, _Mode, _Thread_count > 0 ? _Thread_count : 1);
+        if (_Chunks.size() <= 1) { // hash on the calling thread
+            for (_Entry_list_traits::_Chunk& _Chunk : _Chunks) {
+                _Entry_list_traits::_Hash_chunk(_Chunk);
+            }
+        } else if (!_Entry_list_traits::_Hash_parallel(_Chunks)) {
+            return false;
+        }
+
+        size_t _Count = 0;
+        _Skipped      = 0;
+        for (const _Entry_list_traits::_Chunk& _Chunk : _Chunks) {
+            _Count   += _Chunk._Entries.size();
+            _Skipped += _Chunk._Skipped;
+        }
+
+        _Entries.reserve(_Entries.size() + _Count);
+        for (const _Entry_list_traits::_Chunk& _Chunk : _Chunks) {
+            _Entries.insert(_Entries.end(), _Chunk._Entries.begin(), _Chunk._Entries.end());
+        }
+
+        return true;
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,50 @@
+// entry_list.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_ENTRY_LIST_HPP_
+#define _DBMGR_ENTRY_LIST_HPP_
+#include <cstddef>
+#include <dbmgr/database.hpp>
+#include <mjfs/path.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Entry_list_traits {
+        // Note: Lists smaller than this are hashed on the calling thread, since starting
+        //       the thread-pool would take longer than hashing the names.
+        static constexpr size_t _Parallel_threshold = 64 * 1024; // 64 KiB
+        static constexpr size_t _Max_name_length    = 260; // MAX_PATH
+
+        struct _Chunk {
+            const char* _First;
+            const char* _Last;
+            checksum_mode _Mode;
+            ::std::vector<database_entry> _Entries;
+            size_t _Skipped; // number of names that are too long or malformed
+            bool _Failed; // true if the chunk couldn't be hashed (not enough memory)
+        };
+
+        // reads the whole file into the buffer
+        [[nodiscard]] static bool _Read_file(const path& _Path, ::std::vector<char>& _Buf);
+
+        // splits the buffer into at most _Count chunks, each ending at a line boundary
+        static ::std::vector<_Chunk> _Split(
+            const char* _First, const char* const _Last, const checksum_mode _Mode, size_t _Count);
+
+        // hashes all names stored in the chunk
+        static void _Hash_chunk(_Chunk& _Target);
+
+        // hashes all chunks, each on its own thread
+        [[nodiscard]] static bool _Hash_parallel(::std::vector<_Chunk>& _Chunks);
+    };
+
+    // parses a newline-delimited UTF-8 list of names and computes their checksums in parallel,
+    // _Skipped receives the number of names that are longer than _Max_name_length or not valid UTF-8
+    [[nodiscard]] bool import_entry_list(const path& _Path, const checksum_mode _Mode,
+        ::std::vector<database_entry>& _Entries, size_t& _Skipped);
+} // namespace mjx
+
+#endif // _DBMGR_ENTRY_LIST_HPP_
\ No newline at end of file
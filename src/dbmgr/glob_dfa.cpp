@@ -0,0 +1,336 @@
+// glob_dfa.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/glob_dfa.hpp>
+#include <unordered_map>
+
+namespace mjx {
+    bool _Glob_dfa_traits::_Is_valid_pattern(const unicode_string_view _Pattern) noexcept {
+        if (_Pattern.empty()) {
+            return false;
+        }
+
+        const wchar_t* const _Last = _Pattern.data() + _Pattern.size();
+        for (const wchar_t* _Iter = _Pattern.data(); _Iter != _Last; ++_Iter) {
+            if (*_Iter == L'\\' || *_Iter == L'/' || *_Iter == L'\0') { // names never contain these characters
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    unicode_string _Glob_dfa_traits::_Normalize(const unicode_string_view _Pattern) {
+        unicode_string _Result;
+        _Result.reserve(_Pattern.size());
+        const wchar_t* const _Last = _Pattern.data() + _Pattern.size();
+        for (const wchar_t* _Iter = _Pattern.data(); _Iter != _Last; ++_Iter) {
+            if (*_Iter != _Any_string || _Result.empty() || _Result.back() != _Any_string) {
+                _Result.push_back(_Crc32c_traits::_Fold_case(*_Iter));
+            }
+        }
+
+        return _Result;
+    }
+
+    size_t glob_dfa::_Automaton::_Get_class(const wchar_t _Ch) const noexcept {
+        if (static_cast<uint32_t>(_Ch) < 128) {
+            return _Ascii_classes[_Ch];
+        }
+
+        const auto _Iter = ::std::lower_bound(_Wide_chars.begin(), _Wide_chars.end(), _Ch);
+        return _Iter != _Wide_chars.end() && *_Iter == _Ch ? _Wide_classes[_Iter - _Wide_chars.begin()] : 0;
+    }
+
+    bool glob_dfa::_Automaton::_Matches(const unicode_string_view _Name) const noexcept {
+        const uint32_t* const _Table = _Transitions.data();
+        const wchar_t* const _Last   = _Name.data() + _Name.size();
+        uint32_t _State              = _Glob_dfa_traits::_Start_state;
+        for (const wchar_t* _Iter = _Name.data(); _Iter != _Last; ++_Iter) {
+            _State = _Table[_State * _Class_count + _Get_class(_Crc32c_traits::_Fold_case(*_Iter))];
+            if (_State == _Glob_dfa_traits::_Dead_state) { // no pattern can match anymore
+                return false;
+            }
+        }
+
+        return _Accepting[_State] != 0;
+    }
+
+    glob_dfa::glob_dfa() noexcept : _Myautomata() {}
+
+    glob_dfa::glob_dfa(const ::std::vector<database_rule>& _Rules) : _Myautomata() {
+        ::std::vector<unicode_string_view> _Patterns;
+        for (const database_rule& _Rule : _Rules) {
+            if (_Rule.kind() == rule_kind::name_glob && !_Rule.data().empty()) {
+                _Patterns.emplace_back(reinterpret_cast<const wchar_t*>(_Rule.data().data()),
+                    _Rule.data().size() / sizeof(wchar_t));
+            }
+        }
+
+        if (!_Patterns.empty()) {
+            _Compile(_Patterns.data(), _Patterns.data() + _Patterns.size());
+        }
+    }
+
+    glob_dfa::~glob_dfa() noexcept {}
+
+    void glob_dfa::_Compile(const unicode_string_view* const _First, const unicode_string_view* const _Last) {
+        // Note: A single pattern always gets its own automaton, even if it exceeds the limits,
+        //       since it can't be split any further.
+        const size_t _Count = static_cast<size_t>(_Last - _First);
+        _Automaton _New_automaton;
+        if (_Try_compile(_First, _Last, _Count == 1, _New_automaton)) {
+            _Myautomata.push_back(::std::move(_New_automaton));
+        } else {
+            _Compile(_First, _First + _Count / 2);
+            _Compile(_First + _Count / 2, _Last);
+        }
+    }
+
+    [[nodiscard]] bool glob_dfa::_Try_compile(const unicode_string_view* const _First,
+        const unicode_string_view* const _Last, const bool _Unbounded, _Automaton& _Result) {
+        // Note: The NFA is a DAG of positions, each position holds a character and its successor.
+        //       The accepting position (null character) ends all the patterns. A '*' position keeps
+        //       itself on any character and implies its successor, a '?' position advances on any character.
+        //       The patterns are inserted backwards and equal suffixes share their positions, so e.g.
+        //       "*miner*.exe" and "*xmrig*.exe" reach the same "*.exe" position. Otherwise every subset
+        //       of the matched infixes would become a separate DFA state.
+        struct _Set_hash {
+            size_t operator()(const ::std::vector<uint32_t>& _Set) const noexcept {
+                uint64_t _Hash = 0xCBF2'9CE4'8422'2325;
+                for (const uint32_t _Pos : _Set) {
+                    _Hash = (_Hash ^ _Pos) * 0x0000'0100'0000'01B3;
+                }
+
+                return static_cast<size_t>(_Hash ^ (_Hash >> 32));
+            }
+        };
+
+        ::std::vector<wchar_t> _Chars{L'\0'}; // the accepting position comes first
+        ::std::vector<uint32_t> _Next{0};
+        ::std::vector<uint32_t> _Start;
+        ::std::vector<wchar_t> _Literals;
+        ::std::unordered_map<uint64_t, uint32_t> _Positions; // (character, successor) -> position
+        for (const unicode_string_view* _Iter = _First; _Iter != _Last; ++_Iter) {
+            uint32_t _Pos = 0;
+            for (size_t _Idx = _Iter->size(); _Idx > 0; --_Idx) {
+                const wchar_t _Ch    = _Iter->data()[_Idx - 1];
+                const uint64_t _Key  = (static_cast<uint64_t>(static_cast<uint16_t>(_Ch)) << 32) | _Pos;
+                const auto _Inserted = _Positions.emplace(_Key, static_cast<uint32_t>(_Chars.size()));
+                if (_Inserted.second) { // a new suffix
+                    _Chars.push_back(_Ch);
+                    _Next.push_back(_Pos);
+                    if (_Ch != _Glob_dfa_traits::_Any_string && _Ch != _Glob_dfa_traits::_Any_character) {
+                        _Literals.push_back(_Ch);
+                    }
+                }
+
+                _Pos = _Inserted.first->second;
+            }
+
+            _Start.push_back(_Pos);
+        }
+
+        // assign a class to each distinct literal, class 0 stands for all the other characters
+        ::std::sort(_Literals.begin(), _Literals.end());
+        _Literals.erase(::std::unique(_Literals.begin(), _Literals.end()), _Literals.end());
+        ::std::fill(::std::begin(_Result._Ascii_classes), ::std::end(_Result._Ascii_classes), uint16_t{0});
+        _Result._Wide_chars.clear();
+        _Result._Wide_classes.clear();
+        _Result._Class_count = _Literals.size() + 1;
+        for (size_t _Idx = 0; _Idx < _Literals.size(); ++_Idx) {
+            if (static_cast<uint32_t>(_Literals[_Idx]) < 128) {
+                _Result._Ascii_classes[_Literals[_Idx]] = static_cast<uint16_t>(_Idx + 1);
+            } else { // the literals are sorted, so are the wide characters
+                _Result._Wide_chars.push_back(_Literals[_Idx]);
+                _Result._Wide_classes.push_back(static_cast<uint16_t>(_Idx + 1));
+            }
+        }
+
+        const auto _Close = [&_Chars, &_Next](::std::vector<uint32_t>& _Set) {
+            for (size_t _Idx = 0; _Idx < _Set.size(); ++_Idx) { // the set grows while it's traversed
+                if (_Chars[_Set[_Idx]] == _Glob_dfa_traits::_Any_string) {
+                    _Set.push_back(_Next[_Set[_Idx]]);
+                }
+            }
+
+            ::std::sort(_Set.begin(), _Set.end());
+            _Set.erase(::std::unique(_Set.begin(), _Set.end()), _Set.end());
+        };
+
+        // Note: The positions reachable from a leading '*' belong to every state, since the '*' never
+        //       leaves. They are kept out of the stored sets and their transitions are computed once.
+        //       Otherwise every state of e.g. "*miner*.exe"-like patterns would store all of them.
+        const size_t _Class_count = _Result._Class_count;
+        ::std::vector<uint32_t> _Persistent;
+        for (const uint32_t _Pos : _Start) {
+            if (_Chars[_Pos] == _Glob_dfa_traits::_Any_string) {
+                _Persistent.push_back(_Pos);
+            }
+        }
+
+        _Close(_Persistent);
+        ::std::vector<uint8_t> _Is_persistent(_Chars.size(), 0);
+        for (const uint32_t _Pos : _Persistent) {
+            _Is_persistent[_Pos] = 1;
+        }
+
+        bool _Always_accepting = false; // true if some pattern is just "*"
+        ::std::vector<uint32_t> _Persistent_common; // positions that follow any character
+        ::std::vector<::std::vector<uint32_t>> _Persistent_buckets(_Class_count); // positions that follow a class
+        for (const uint32_t _Pos : _Persistent) {
+            switch (_Chars[_Pos]) {
+            case L'\0':
+                _Always_accepting = true;
+                break;
+            case _Glob_dfa_traits::_Any_string:
+                break;
+            case _Glob_dfa_traits::_Any_character:
+                _Persistent_common.push_back(_Next[_Pos]);
+                break;
+            default:
+                _Persistent_buckets[_Result._Get_class(_Chars[_Pos])].push_back(_Next[_Pos]);
+                break;
+            }
+        }
+
+        const auto _Remove_persistent = [&_Is_persistent](::std::vector<uint32_t>& _Set) {
+            _Set.erase(::std::remove_if(_Set.begin(), _Set.end(),
+                           [&_Is_persistent](const uint32_t _Pos) noexcept { return _Is_persistent[_Pos] != 0; }),
+                _Set.end());
+        };
+
+        for (::std::vector<uint32_t>& _Bucket : _Persistent_buckets) { // the same in every state, close them once
+            _Close(_Bucket);
+            _Remove_persistent(_Bucket);
+        }
+
+        ::std::vector<::std::vector<uint32_t>> _Sets;
+        ::std::unordered_map<::std::vector<uint32_t>, uint32_t, _Set_hash> _Ids;
+        size_t _Stored = 0; // number of stored positions
+        ::std::vector<uint32_t> _Merged;
+        const auto _Add_state = [&](::std::vector<uint32_t>& _Set, const ::std::vector<uint32_t>& _Closed) -> uint32_t {
+            _Close(_Set);
+            _Remove_persistent(_Set);
+            if (!_Closed.empty()) { // merge the already closed positions
+                _Merged.resize(_Set.size() + _Closed.size());
+                _Merged.erase(
+                    ::std::set_union(_Set.begin(), _Set.end(), _Closed.begin(), _Closed.end(), _Merged.begin()),
+                    _Merged.end());
+                _Set.swap(_Merged);
+            }
+
+            const auto _Iter = _Ids.find(_Set);
+            if (_Iter != _Ids.end()) {
+                return _Iter->second;
+            }
+
+            const uint32_t _Id = static_cast<uint32_t>(_Sets.size());
+            _Stored           += _Set.size();
+            _Ids.emplace(_Set, _Id);
+            _Sets.push_back(_Set);
+            return _Id;
+        };
+
+        ::std::vector<uint32_t> _Target;
+        _Sets.emplace_back(); // dead state
+        if (_Persistent.empty()) { // otherwise no state is dead and the empty set gets its own state
+            _Ids.emplace(_Sets.back(), _Glob_dfa_traits::_Dead_state);
+        }
+
+        _Add_state(_Start, _Persistent_buckets[0]); // class 0 follows no position, so its bucket is empty
+
+        _Result._Transitions.clear();
+        _Result._Accepting.clear();
+        ::std::vector<uint32_t> _Common; // positions that follow any character
+        ::std::vector<::std::vector<uint32_t>> _Buckets(_Class_count); // positions that follow a single class
+        for (size_t _State = 0; _State < _Sets.size(); ++_State) {
+            if (!_Unbounded && (_Sets.size() * _Class_count > _Glob_dfa_traits::_Max_table_size
+                || _Stored > _Glob_dfa_traits::_Max_set_size)) { // too many states, split the patterns
+                return false;
+            }
+
+            if (_State == _Glob_dfa_traits::_Dead_state) {
+                _Result._Transitions.insert(_Result._Transitions.end(), _Class_count, _Glob_dfa_traits::_Dead_state);
+                _Result._Accepting.push_back(0);
+                continue;
+            }
+
+            _Common = _Persistent_common;
+            for (::std::vector<uint32_t>& _Bucket : _Buckets) {
+                _Bucket.clear();
+            }
+
+            bool _Accepting = _Always_accepting;
+            for (const uint32_t _Pos : _Sets[_State]) {
+                switch (_Chars[_Pos]) {
+                case L'\0':
+                    _Accepting = true;
+                    break;
+                case _Glob_dfa_traits::_Any_string:
+                    _Common.push_back(_Pos);
+                    break;
+                case _Glob_dfa_traits::_Any_character:
+                    _Common.push_back(_Next[_Pos]);
+                    break;
+                default:
+                    _Buckets[_Result._Get_class(_Chars[_Pos])].push_back(_Next[_Pos]);
+                    break;
+                }
+            }
+
+            // the classes without their own positions share the target of class 0, compute it only once
+            _Target = _Common;
+            const uint32_t _Shared = _Add_state(_Target, _Persistent_buckets[0]);
+            _Result._Accepting.push_back(_Accepting ? 1 : 0);
+            for (size_t _Class = 0; _Class < _Class_count; ++_Class) {
+                if (_Buckets[_Class].empty() && _Persistent_buckets[_Class].empty()) {
+                    _Result._Transitions.push_back(_Shared);
+                } else {
+                    _Target = _Common;
+                    _Target.insert(_Target.end(), _Buckets[_Class].begin(), _Buckets[_Class].end());
+                    _Result._Transitions.push_back(_Add_state(_Target, _Persistent_buckets[_Class]));
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool glob_dfa::empty() const noexcept {
+        return _Myautomata.empty();
+    }
+
+    size_t glob_dfa::automaton_count() const noexcept {
+        return _Myautomata.size();
+    }
+
+    size_t glob_dfa::state_count() const noexcept {
+        size_t _Count = 0;
+        for (const _Automaton& _Automaton : _Myautomata) {
+            _Count += _Automaton._Accepting.size();
+        }
+
+        return _Count;
+    }
+
+    bool glob_dfa::matches(const unicode_string_view _Name) const noexcept {
+        for (const _Automaton& _Automaton : _Myautomata) {
+            if (_Automaton._Matches(_Name)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    database_rule make_glob_rule(const unicode_string_view _Normalized) {
+        const byte_t* const _Bytes = reinterpret_cast<const byte_t*>(_Normalized.data());
+        return database_rule{rule_kind::name_glob,
+            ::std::vector<byte_t>(_Bytes, _Bytes + _Normalized.size() * sizeof(wchar_t))};
+    }
+} // namespace mjx
\ No newline at end of file
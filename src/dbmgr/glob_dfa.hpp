@@ -0,0 +1,91 @@
+// glob_dfa.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_GLOB_DFA_HPP_
+#define _DBMGR_GLOB_DFA_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/database_rule.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Glob_dfa_traits {
+        // Note: All patterns are compiled into a single DFA with the subset construction, so a name
+        //       is matched against all of them in one pass. Equal pattern suffixes are shared, which keeps
+        //       the usual "*word*.exe" sets small. Some pattern sets still blow up the number of states;
+        //       if the table would exceed the limits, the patterns are split in halves and each half
+        //       gets its own automaton.
+        static constexpr wchar_t _Any_string    = L'*';
+        static constexpr wchar_t _Any_character = L'?';
+        static constexpr uint32_t _Dead_state   = 0; // rejects all names, never left
+        static constexpr uint32_t _Start_state  = 1;
+        static constexpr size_t _Max_table_size = 4 * 1024 * 1024; // max transitions per automaton (16 MiB)
+        static constexpr size_t _Max_set_size   = 16 * 1024 * 1024; // max NFA positions stored during construction
+
+        // checks if the pattern can be used as a rule (not empty, no directory separators)
+        static bool _Is_valid_pattern(const unicode_string_view _Pattern) noexcept;
+
+        // case-folds the pattern and collapses consecutive '*' wildcards
+        static unicode_string _Normalize(const unicode_string_view _Pattern);
+    };
+
+    class glob_dfa { // immutable set of wildcard patterns compiled into a DFA
+    public:
+        glob_dfa() noexcept;
+        glob_dfa(const glob_dfa&)     = default;
+        glob_dfa(glob_dfa&&) noexcept = default;
+        ~glob_dfa() noexcept;
+
+        explicit glob_dfa(const ::std::vector<database_rule>& _Rules);
+
+        glob_dfa& operator=(const glob_dfa&)     = default;
+        glob_dfa& operator=(glob_dfa&&) noexcept = default;
+
+        // checks if the DFA is empty (matches no name)
+        bool empty() const noexcept;
+
+        // returns the number of automata (one unless the patterns had to be split)
+        size_t automaton_count() const noexcept;
+
+        // returns the total number of states
+        size_t state_count() const noexcept;
+
+        // checks if the name matches any pattern (one pass per automaton)
+        bool matches(const unicode_string_view _Name) const noexcept;
+
+    private:
+        struct _Automaton {
+            ::std::vector<uint32_t> _Transitions; // indexed by state * _Class_count + class
+            ::std::vector<uint8_t> _Accepting; // non-zero if the state accepts the name
+            ::std::vector<wchar_t> _Wide_chars; // sorted non-ASCII characters that have their own class
+            ::std::vector<uint16_t> _Wide_classes;
+            uint16_t _Ascii_classes[128]; // class 0 stands for all characters that no pattern uses
+            size_t _Class_count;
+
+            // returns the class of the case-folded character
+            size_t _Get_class(const wchar_t _Ch) const noexcept;
+
+            // runs the automaton
+            bool _Matches(const unicode_string_view _Name) const noexcept;
+        };
+
+        // compiles the patterns, splits them if they don't fit into a single automaton
+        void _Compile(const unicode_string_view* const _First, const unicode_string_view* const _Last);
+
+        // tries to compile the patterns into a single automaton
+        [[nodiscard]] static bool _Try_compile(const unicode_string_view* const _First,
+            const unicode_string_view* const _Last, const bool _Unbounded, _Automaton& _Result);
+
+        ::std::vector<_Automaton> _Myautomata;
+    };
+
+    // makes a rule that matches the names with the normalized pattern
+    database_rule make_glob_rule(const unicode_string_view _Normalized);
+} // namespace mjx
+
+#endif // _DBMGR_GLOB_DFA_HPP_
\ No newline at end of file
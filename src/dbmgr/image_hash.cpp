@@ -0,0 +1,94 @@
+// image_hash.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <dbmgr/image_hash.hpp>
+#include <dbmgr/tinywin.hpp>
+#include <bcrypt.h> // include after <Windows.h>
+#include <mjfs/file.hpp>
+
+namespace mjx {
+    void* _Image_hash_traits::_Get_provider() noexcept {
+        // Note: The provider is shared by all hashes and lives until the process terminates,
+        //       opening it is much more expensive than hashing a typical executable.
+        static const BCRYPT_ALG_HANDLE _Provider = []() noexcept -> BCRYPT_ALG_HANDLE {
+            BCRYPT_ALG_HANDLE _Handle = nullptr;
+            return BCRYPT_SUCCESS(::BCryptOpenAlgorithmProvider(&_Handle, BCRYPT_SHA256_ALGORITHM, nullptr, 0))
+                ? _Handle : nullptr;
+        }();
+        return _Provider;
+    }
+
+    bool _Image_hash_traits::_Hash_mapping(void* const _Hash, void* const _Mapping, const uint64_t _Size) noexcept {
+        uint64_t _Off = 0;
+        size_t _Chunk;
+        const void* _View;
+        NTSTATUS _Status;
+        while (_Off < _Size) {
+#ifdef _M_X64
+            _Chunk = _Size - _Off < _View_size ? _Size - _Off : _View_size;
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+            _Chunk = _Size - _Off < _View_size ? static_cast<size_t>(_Size - _Off) : _View_size;
+#endif // _M_X64
+            _View  = ::MapViewOfFile(_Mapping, FILE_MAP_READ,
+                static_cast<unsigned long>(_Off >> 32), static_cast<unsigned long>(_Off), _Chunk);
+            if (!_View) {
+                return false;
+            }
+
+            _Status = ::BCryptHashData(static_cast<BCRYPT_HASH_HANDLE>(_Hash),
+                static_cast<PUCHAR>(const_cast<void*>(_View)), static_cast<unsigned long>(_Chunk), 0);
+            ::UnmapViewOfFile(_View);
+            if (!BCRYPT_SUCCESS(_Status)) {
+                return false;
+            }
+
+            _Off += _Chunk;
+        }
+
+        return true;
+    }
+
+    bool compute_image_hash(void* const _Handle, const uint64_t _Size, image_hash& _Hash) noexcept {
+        BCRYPT_ALG_HANDLE _Provider = _Image_hash_traits::_Get_provider();
+        if (!_Provider) { // CNG unavailable
+            return false;
+        }
+
+        BCRYPT_HASH_HANDLE _Hash_handle = nullptr;
+        if (!BCRYPT_SUCCESS(::BCryptCreateHash(_Provider, &_Hash_handle, nullptr, 0, nullptr, 0, 0))) {
+            return false;
+        }
+
+        bool _Succeeded = true;
+        if (_Size > 0) { // an empty file can't be mapped
+            void* const _Mapping = ::CreateFileMappingW(_Handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_Mapping) {
+                _Succeeded = _Image_hash_traits::_Hash_mapping(_Hash_handle, _Mapping, _Size);
+                ::CloseHandle(_Mapping);
+            } else {
+                _Succeeded = false;
+            }
+        }
+
+        if (_Succeeded) {
+            _Succeeded = BCRYPT_SUCCESS(::BCryptFinishHash(
+                _Hash_handle, _Hash.data(), static_cast<unsigned long>(_Hash.size()), 0));
+        }
+
+        ::BCryptDestroyHash(_Hash_handle);
+        return _Succeeded;
+    }
+
+    bool compute_image_hash(const path& _Path, image_hash& _Hash) noexcept {
+        // Note: The loader opens running images with shared read and delete access, so the file
+        //       must be opened with all the sharing flags to succeed while the image is in use.
+        file _File(_Path, file_access::read, file_share::all);
+        return _File.is_open() && compute_image_hash(_File.native_handle(), _File.size(), _Hash);
+    }
+
+    database_rule make_image_hash_rule(const image_hash& _Hash) {
+        return database_rule{rule_kind::image_hash, ::std::vector<byte_t>(_Hash.begin(), _Hash.end())};
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,42 @@
+// image_hash.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_IMAGE_HASH_HPP_
+#define _DBMGR_IMAGE_HASH_HPP_
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/database_rule.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    using image_hash = ::std::array<byte_t, 32>; // SHA-256 hash of the executable image
+
+    struct _Image_hash_traits {
+        // Note: The file is hashed through a sequence of mapped views, so neither the whole file
+        //       nor a copy of it has to fit in memory. The SHA-256 itself is computed by CNG,
+        //       which uses the SHA extensions (or AVX2) if the CPU supports them.
+        static constexpr size_t _View_size = 64 * 1024 * 1024; // 64 MiB, a multiple of the allocation granularity
+
+        // returns the cached SHA-256 algorithm provider (opened once)
+        static void* _Get_provider() noexcept;
+
+        // hashes the mapped file, view by view
+        static bool _Hash_mapping(void* const _Hash, void* const _Mapping, const uint64_t _Size) noexcept;
+    };
+
+    // computes the hash of the opened file
+    bool compute_image_hash(void* const _Handle, const uint64_t _Size, image_hash& _Hash) noexcept;
+
+    // computes the hash of the selected file
+    bool compute_image_hash(const path& _Path, image_hash& _Hash) noexcept;
+
+    // makes a rule that matches the image with the selected hash
+    database_rule make_image_hash_rule(const image_hash& _Hash);
+} // namespace mjx
+
+#endif // _DBMGR_IMAGE_HASH_HPP_
\ No newline at end of file
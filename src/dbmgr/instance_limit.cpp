@@ -0,0 +1,73 @@
+// instance_limit.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <dbmgr/instance_limit.hpp>
+
+namespace mjx {
+    [[nodiscard]] bool _Instance_limit_traits::_Parse(
+        const unicode_string_view _Target, unicode_string_view& _Name, uint32_t& _Limit) noexcept {
+        const size_t _Pos = _Target.rfind(L'@');
+        if (_Pos == unicode_string_view::npos || _Pos == 0 || _Pos == _Target.size() - 1) { // no name or no count
+            return false;
+        }
+
+        uint32_t _Value            = 0;
+        const wchar_t* const _Last = _Target.data() + _Target.size();
+        for (const wchar_t* _Iter = _Target.data() + _Pos + 1; _Iter != _Last; ++_Iter) {
+            if (*_Iter < L'0' || *_Iter > L'9') {
+                return false;
+            }
+
+            _Value = _Value * 10 + static_cast<uint32_t>(*_Iter - L'0');
+            if (_Value > _Max_limit) {
+                return false;
+            }
+        }
+
+        if (_Value == 0) { // no instance allowed, the application should be locked instead
+            return false;
+        }
+
+        _Name  = _Target.substr(0, _Pos);
+        _Limit = _Value;
+        return true;
+    }
+
+    [[nodiscard]] bool _Instance_limit_traits::_Decode(const database_rule& _Rule, instance_limit& _Limit) noexcept {
+        if (_Rule.kind() != rule_kind::instance_limit || _Rule.data().size() != sizeof(_Record)) {
+            return false;
+        }
+
+        _Record _Data;
+        ::memcpy(&_Data, _Rule.data().data(), sizeof(_Record));
+        if (_Data._Limit == 0 || _Data._Limit > _Max_limit) {
+            return false;
+        }
+
+        _Limit.checksum = _Data._Checksum;
+        _Limit.limit    = _Data._Limit;
+        return true;
+    }
+
+    [[nodiscard]] bool _Instance_limit_traits::_Find(
+        const ::std::vector<database_rule>& _Rules, const checksum_t _Checksum, instance_limit& _Limit) noexcept {
+        for (const database_rule& _Rule : _Rules) {
+            if (_Decode(_Rule, _Limit) && _Limit.checksum == _Checksum) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    database_rule make_instance_limit_rule(const instance_limit& _Limit) {
+        _Instance_limit_traits::_Record _Data = {}; // the reserved bytes must be zero, the rules are compared bytewise
+        _Data._Checksum                       = _Limit.checksum;
+        _Data._Limit                          = _Limit.limit;
+        const byte_t* const _Bytes            = reinterpret_cast<const byte_t*>(&_Data);
+        return database_rule{rule_kind::instance_limit, ::std::vector<byte_t>(_Bytes, _Bytes + sizeof(_Data))};
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,49 @@
+// instance_limit.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_INSTANCE_LIMIT_HPP_
+#define _DBMGR_INSTANCE_LIMIT_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/database_rule.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    struct instance_limit { // maximum number of running instances of an application
+        checksum_t checksum; // checksum of the application name
+        uint32_t limit;
+    };
+
+    struct _Instance_limit_traits {
+        static constexpr uint32_t _Max_limit = 0xFFFF;
+
+        struct _Record { // rule data
+            checksum_t _Checksum;
+            uint32_t _Limit;
+            uint32_t _Reserved; // must be zero
+        };
+
+        static_assert(sizeof(_Record) == 16, "_Record must be 16 bytes long");
+
+        // splits the "name@count" target into the name and the limit, the name may contain '@'
+        [[nodiscard]] static bool _Parse(
+            const unicode_string_view _Target, unicode_string_view& _Name, uint32_t& _Limit) noexcept;
+
+        // decodes the rule, fails if the rule isn't a valid instance limit
+        [[nodiscard]] static bool _Decode(const database_rule& _Rule, instance_limit& _Limit) noexcept;
+
+        // finds the limit of the application, fails if the application has no limit
+        [[nodiscard]] static bool _Find(
+            const ::std::vector<database_rule>& _Rules, const checksum_t _Checksum, instance_limit& _Limit) noexcept;
+    };
+
+    // makes a rule that limits the number of running instances of the application
+    database_rule make_instance_limit_rule(const instance_limit& _Limit);
+} // namespace mjx
+
+#endif // _DBMGR_INSTANCE_LIMIT_HPP_
\ No newline at end of file
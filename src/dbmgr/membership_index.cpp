@@ -0,0 +1,256 @@
+// membership_index.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <dbmgr/database.hpp>
+#include <dbmgr/membership_index.hpp>
+#include <dbmgr/tinywin.hpp>
+#include <immintrin.h> // include after <Windows.h>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+
+namespace mjx {
+    path _Membership_traits::_Get_file_path() {
+        return database_location::current().directory() / L"membership.thresholds";
+    }
+
+    membership_thresholds _Membership_traits::_Load_or_calibrate() {
+        membership_thresholds _Thresholds;
+        if (!membership_thresholds::load(_Thresholds)) { // not calibrated yet, calibrate once for this host
+            _Thresholds = membership_thresholds::calibrate();
+            (void) _Thresholds.save(); // calibrate again in the next process if the file can't be written
+        }
+
+        return _Thresholds;
+    }
+
+    int64_t _Membership_traits::_Measure(
+        const membership_index& _Index, const ::std::vector<checksum_t>& _Probes) noexcept {
+        // Note: The best run is taken to filter out preemption and cache warm-up.
+        LARGE_INTEGER _Start;
+        LARGE_INTEGER _End;
+        int64_t _Best = INT64_MAX;
+        size_t _Found = 0;
+        for (size_t _Run = 0; _Run < _Max_runs; ++_Run) {
+            ::QueryPerformanceCounter(&_Start);
+            for (const checksum_t _Probe : _Probes) {
+                _Found += _Index.contains(_Probe) ? 1 : 0;
+            }
+
+            ::QueryPerformanceCounter(&_End);
+            if (_End.QuadPart - _Start.QuadPart < _Best) {
+                _Best = _End.QuadPart - _Start.QuadPart;
+            }
+        }
+
+        // the result is used, so the compiler can't optimize away the lookups
+        return _Found > _Max_runs * _Probes.size() ? 0 : _Best;
+    }
+
+    bool _Membership_traits::_Use_avx2() noexcept {
+        static const bool _Available = ::IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE) != 0;
+        return _Available;
+    }
+
+    bool _Membership_traits::_Scan_avx2(
+        const checksum_t* _First, const checksum_t* const _Last, const checksum_t _Val) noexcept {
+        const __m256i _Expected = ::_mm256_set1_epi64x(static_cast<long long>(_Val));
+        __m256i _Chunk;
+        for (; _Last - _First >= 4; _First += 4) { // compare 4 checksums at once
+            _Chunk = ::_mm256_loadu_si256(reinterpret_cast<const __m256i*>(_First));
+            if (::_mm256_movemask_epi8(::_mm256_cmpeq_epi64(_Chunk, _Expected)) != 0) {
+                return true;
+            }
+        }
+
+        return _Scan_software(_First, _Last, _Val); // compare the remaining checksums
+    }
+
+    bool _Membership_traits::_Scan_software(
+        const checksum_t* _First, const checksum_t* const _Last, const checksum_t _Val) noexcept {
+        for (; _First != _Last; ++_First) {
+            if (*_First == _Val) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    const membership_thresholds& membership_thresholds::current() {
+        static const membership_thresholds _Thresholds = _Membership_traits::_Load_or_calibrate();
+        return _Thresholds;
+    }
+
+    membership_thresholds membership_thresholds::calibrate() {
+        // Note: The calibration times all the strategies on random sets of growing size. Each threshold
+        //       is the last size at which the simpler strategy was still faster. The probes are mostly
+        //       absent from the set, like most of the processes being checked.
+        LARGE_INTEGER _Freq;
+        if (!::QueryPerformanceFrequency(&_Freq) || _Freq.QuadPart == 0) { // timer unavailable, use defaults
+            return _Membership_traits::_Default_thresholds;
+        }
+
+        uint64_t _State  = 0x9E37'79B9'7F4A'7C15;
+        const auto _Next = [&_State]() noexcept { // xorshift64 generator
+            _State ^= _State << 13;
+            _State ^= _State >> 7;
+            _State ^= _State << 17;
+            return _State;
+        };
+
+        ::std::vector<checksum_t> _Probes(_Membership_traits::_Probe_count);
+        for (checksum_t& _Probe : _Probes) {
+            _Probe = static_cast<checksum_t>(_Next());
+        }
+
+        membership_thresholds _Result = {0, 0};
+        bool _Linear_done             = false;
+        bool _Sorted_done             = false;
+        ::std::vector<database_entry> _Entries;
+        for (size_t _Size = 4; _Size <= _Membership_traits::_Max_size && (!_Linear_done || !_Sorted_done);
+            _Size *= 2) {
+            while (_Entries.size() < _Size) {
+                _Entries.push_back(database_entry{static_cast<checksum_t>(_Next())});
+            }
+
+            const int64_t _Sorted_time =
+                _Membership_traits::_Measure(membership_index{_Entries, membership_strategy::sorted}, _Probes);
+            const int64_t _Hashed_time =
+                _Membership_traits::_Measure(membership_index{_Entries, membership_strategy::hashed}, _Probes);
+            if (!_Linear_done) {
+                if (_Membership_traits::_Measure(membership_index{_Entries, membership_strategy::linear}, _Probes)
+                    <= (::std::min)(_Sorted_time, _Hashed_time)) {
+                    _Result.linear_max = _Size;
+                } else {
+                    _Linear_done = true;
+                }
+            }
+
+            if (!_Sorted_done) {
+                if (_Sorted_time <= _Hashed_time) {
+                    _Result.sorted_max = _Size;
+                } else {
+                    _Sorted_done = true;
+                }
+            }
+        }
+
+        if (_Result.sorted_max < _Result.linear_max) {
+            _Result.sorted_max = _Result.linear_max;
+        }
+
+        return _Result;
+    }
+
+    bool membership_thresholds::load(membership_thresholds& _Thresholds) {
+        file _File(_Membership_traits::_Get_file_path(), file_access::read, file_share::all);
+        file_stream _Stream(_File);
+        if (!_Stream.is_open()) { // not calibrated yet
+            return false;
+        }
+
+        _Membership_traits::_File_header _Header;
+        if (_Stream.read(reinterpret_cast<byte_t*>(&_Header), sizeof(_Header)) != sizeof(_Header)
+            || _Header._Magic != _Membership_traits::_Magic || _Header._Version != _Membership_traits::_Version
+            || _Header._Reserved != 0 || _Header._Linear_max > _Header._Sorted_max
+            || _Header._Sorted_max > _Membership_traits::_Max_size) {
+            return false; // unknown or damaged file
+        }
+
+        _Thresholds.linear_max = _Header._Linear_max;
+        _Thresholds.sorted_max = _Header._Sorted_max;
+        return true;
+    }
+
+    bool membership_thresholds::save() const noexcept {
+        try {
+            _Membership_traits::_File_header _Header = {};
+            _Header._Magic                           = _Membership_traits::_Magic;
+            _Header._Version                         = _Membership_traits::_Version;
+            _Header._Linear_max                      = static_cast<uint32_t>(linear_max);
+            _Header._Sorted_max                      = static_cast<uint32_t>(sorted_max);
+            file _File(_Membership_traits::_Get_file_path(), file_access::write);
+            file_stream _Stream(_File);
+            return _Stream.is_open() && _File.resize(0) // must be empty
+                && _Stream.write(reinterpret_cast<const byte_t*>(&_Header), sizeof(_Header));
+        } catch (...) {
+            return false;
+        }
+    }
+
+    membership_strategy membership_thresholds::select(const size_t _Count) const noexcept {
+        if (_Count <= linear_max) {
+            return membership_strategy::linear;
+        } else if (_Count <= sorted_max) {
+            return membership_strategy::sorted;
+        } else {
+            return membership_strategy::hashed;
+        }
+    }
+
+    membership_index::membership_index() noexcept
+        : _Mystrategy(membership_strategy::linear), _Mykeys(), _Myhash() {}
+
+    membership_index::membership_index(const ::std::vector<database_entry>& _Entries)
+        : _Mystrategy(membership_thresholds::current().select(_Entries.size())), _Mykeys(), _Myhash() {
+        _Build(_Entries);
+    }
+
+    membership_index::membership_index(
+        const ::std::vector<database_entry>& _Entries, const membership_strategy _Strategy)
+        : _Mystrategy(_Strategy), _Mykeys(), _Myhash() {
+        _Build(_Entries);
+    }
+
+    membership_index::~membership_index() noexcept {}
+
+    void membership_index::_Build(const ::std::vector<database_entry>& _Entries) {
+        if (_Mystrategy == membership_strategy::hashed) {
+            _Myhash = perfect_hash_set{_Entries};
+            return;
+        }
+
+        _Mykeys.reserve(_Entries.size());
+        for (const database_entry& _Entry : _Entries) {
+            _Mykeys.push_back(_Entry.checksum());
+        }
+
+        ::std::sort(_Mykeys.begin(), _Mykeys.end()); // required by binary search and size()
+        _Mykeys.erase(::std::unique(_Mykeys.begin(), _Mykeys.end()), _Mykeys.end());
+    }
+
+    bool membership_index::empty() const noexcept {
+        return _Mystrategy == membership_strategy::hashed ? _Myhash.empty() : _Mykeys.empty();
+    }
+
+    size_t membership_index::size() const noexcept {
+        return _Mystrategy == membership_strategy::hashed ? _Myhash.size() : _Mykeys.size();
+    }
+
+    membership_strategy membership_index::strategy() const noexcept {
+        return _Mystrategy;
+    }
+
+    bool membership_index::contains(const checksum_t _Val) const noexcept {
+        switch (_Mystrategy) {
+        case membership_strategy::linear:
+        {
+            const checksum_t* const _First = _Mykeys.data();
+            const checksum_t* const _Last  = _First + _Mykeys.size();
+            return _Membership_traits::_Use_avx2() ? _Membership_traits::_Scan_avx2(_First, _Last, _Val)
+                : _Membership_traits::_Scan_software(_First, _Last, _Val);
+        }
+        case membership_strategy::sorted:
+            return ::std::binary_search(_Mykeys.begin(), _Mykeys.end(), _Val);
+        case membership_strategy::hashed:
+            return _Myhash.contains(_Val);
+        default:
+            return false;
+        }
+    }
+} // namespace mjx
\ No newline at end of file
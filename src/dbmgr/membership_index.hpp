@@ -0,0 +1,125 @@
+// membership_index.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_MEMBERSHIP_INDEX_HPP_
+#define _DBMGR_MEMBERSHIP_INDEX_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/perfect_hash.hpp>
+#include <mjfs/path.hpp>
+#include <vector>
+
+namespace mjx {
+    class database_entry;
+
+    enum class membership_strategy : unsigned char {
+        linear, // linear scan (AVX2 if available)
+        sorted, // binary search
+        hashed // minimal perfect hash
+    };
+
+    struct membership_thresholds { // the largest sets handled by the simpler strategies
+        size_t linear_max; // the largest set scanned linearly
+        size_t sorted_max; // the largest set searched with binary search
+
+        // returns the thresholds of this host, calibrates and stores them if they haven't been stored yet
+        static const membership_thresholds& current();
+
+        // finds the thresholds by timing all the strategies on random sets
+        static membership_thresholds calibrate();
+
+        // loads the stored thresholds, fails if they haven't been stored yet or are invalid
+        static bool load(membership_thresholds& _Thresholds);
+
+        // stores the thresholds, they're used by the processes started afterwards
+        bool save() const noexcept;
+
+        // selects the strategy for the selected number of entries
+        membership_strategy select(const size_t _Count) const noexcept;
+    };
+
+    class membership_index;
+
+    struct _Membership_traits {
+        // Note: The thresholds are calibrated once per host and stored next to the database, so building
+        //       the index never times anything. The defaults are used only if the timer is unavailable.
+        //       They were measured on a test machine, where the linear scan won up to 256 entries and
+        //       the perfect hash beat binary search on mostly absent keys from 8 entries on.
+        //       The file holds only the header, it's rewritten by each calibration.
+        struct _File_header {
+            uint32_t _Magic; // always _Magic
+            uint16_t _Version; // always _Version
+            uint16_t _Reserved; // must be zero
+            uint32_t _Linear_max;
+            uint32_t _Sorted_max;
+        };
+
+        static_assert(sizeof(_File_header) == 16, "_File_header must be 16 bytes long");
+
+        static constexpr uint32_t _Magic                           = 0x544D'4C41; // "ALMT" in little-endian order
+        static constexpr uint16_t _Version                         = 1;
+        static constexpr size_t _Probe_count                       = 4096; // lookups timed per strategy and size
+        static constexpr size_t _Max_size                          = 65536; // the largest calibrated set
+        static constexpr size_t _Max_runs                          = 3; // the best run is taken
+        static constexpr membership_thresholds _Default_thresholds = {256, 256};
+
+        // returns a path to the thresholds file
+        static path _Get_file_path();
+
+        // loads the thresholds, calibrates and stores them if they haven't been stored yet
+        static membership_thresholds _Load_or_calibrate();
+
+        // measures the time of the lookups (in performance counter ticks)
+        static int64_t _Measure(const membership_index& _Index, const ::std::vector<checksum_t>& _Probes) noexcept;
+
+        // checks if AVX2 SIMD extension can be used
+        static bool _Use_avx2() noexcept;
+
+        // scans the checksums with AVX2 SIMD extension support
+        static bool _Scan_avx2(const checksum_t* _First, const checksum_t* const _Last, const checksum_t _Val) noexcept;
+
+        // scans the checksums without AVX2 SIMD extension support
+        static bool _Scan_software(
+            const checksum_t* _First, const checksum_t* const _Last, const checksum_t _Val) noexcept;
+    };
+
+    class membership_index { // immutable set of checksums, the representation depends on the size
+    public:
+        membership_index() noexcept;
+        membership_index(const membership_index&)     = default;
+        membership_index(membership_index&&) noexcept = default;
+        ~membership_index() noexcept;
+
+        explicit membership_index(const ::std::vector<database_entry>& _Entries);
+        membership_index(const ::std::vector<database_entry>& _Entries, const membership_strategy _Strategy);
+
+        membership_index& operator=(const membership_index&)     = default;
+        membership_index& operator=(membership_index&&) noexcept = default;
+
+        // checks if the index is empty
+        bool empty() const noexcept;
+
+        // returns the number of stored checksums
+        size_t size() const noexcept;
+
+        // returns the selected strategy
+        membership_strategy strategy() const noexcept;
+
+        // checks if the index contains the checksum
+        bool contains(const checksum_t _Val) const noexcept;
+
+    private:
+        // builds the index with the selected strategy
+        void _Build(const ::std::vector<database_entry>& _Entries);
+
+        membership_strategy _Mystrategy;
+        ::std::vector<checksum_t> _Mykeys; // unique checksums (used by linear and sorted strategies)
+        perfect_hash_set _Myhash; // used by hashed strategy
+    };
+} // namespace mjx
+
+#endif // _DBMGR_MEMBERSHIP_INDEX_HPP_
\ No newline at end of file
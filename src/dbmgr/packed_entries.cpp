@@ -0,0 +1,197 @@
+// packed_entries.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <dbmgr/database.hpp>
+#include <dbmgr/packed_entries.hpp>
+
+namespace mjx {
+    size_t _Packed_entry_traits::_Block_count(const size_t _Count) noexcept {
+        return (_Count + _Block_size - 1) / _Block_size;
+    }
+
+    size_t _Packed_entry_traits::_Entries_in_block(const size_t _Block, const size_t _Count) noexcept {
+        const size_t _Off = _Block * _Block_size;
+        return _Count - _Off < _Block_size ? _Count - _Off : _Block_size;
+    }
+
+    uint8_t _Packed_entry_traits::_Bit_width(uint64_t _Val) noexcept {
+        uint8_t _Width = 0;
+        for (; _Val != 0; _Val >>= 1) {
+            ++_Width;
+        }
+
+        return _Width;
+    }
+
+    _Packed_entry_traits::_Block_info _Packed_entry_traits::_Get_block_info(
+        const byte_t* const _Payload, const size_t _Block) noexcept {
+        _Block_info _Info; // the payload may be unaligned
+        ::memcpy(&_Info, _Payload + _Block * sizeof(_Block_info), sizeof(_Block_info));
+        return _Info;
+    }
+
+    uint64_t _Packed_entry_traits::_Read_bits(
+        const byte_t* const _Data, const size_t _Bit, const uint8_t _Width) noexcept {
+        if (_Width > 56) { // the value may span 9 bytes, read it in two parts
+            return _Read_bits(_Data, _Bit, 32)
+                | (_Read_bits(_Data, _Bit + 32, static_cast<uint8_t>(_Width - 32)) << 32);
+        }
+
+        uint64_t _Word;
+        ::memcpy(&_Word, _Data + _Bit / 8, sizeof(uint64_t));
+        return (_Word >> (_Bit % 8)) & ((uint64_t{1} << _Width) - 1);
+    }
+
+    void _Packed_entry_traits::_Write_bits(
+        byte_t* const _Data, const size_t _Bit, const uint8_t _Width, const uint64_t _Val) noexcept {
+        if (_Width > 56) { // the value may span 9 bytes, write it in two parts
+            _Write_bits(_Data, _Bit, 32, _Val & 0xFFFF'FFFF);
+            _Write_bits(_Data, _Bit + 32, static_cast<uint8_t>(_Width - 32), _Val >> 32);
+            return;
+        }
+
+        uint64_t _Word;
+        ::memcpy(&_Word, _Data + _Bit / 8, sizeof(uint64_t));
+        _Word |= _Val << (_Bit % 8);
+        ::memcpy(_Data + _Bit / 8, &_Word, sizeof(uint64_t));
+    }
+
+    size_t _Packed_entry_traits::_Encoded_size(const database_entry* const _Entries, const size_t _Count) noexcept {
+        const size_t _Blocks = _Block_count(_Count);
+        size_t _Size         = _Blocks * sizeof(_Block_info) + _Padding_size;
+        for (size_t _Block = 0; _Block < _Blocks; ++_Block) {
+            const database_entry* const _First = _Entries + _Block * _Block_size;
+            const size_t _Block_entries        = _Entries_in_block(_Block, _Count);
+            uint8_t _Width                     = 0;
+            uint8_t _Delta_width;
+            for (size_t _Idx = 1; _Idx < _Block_entries; ++_Idx) {
+                _Delta_width = _Bit_width(_First[_Idx].checksum() - _First[_Idx - 1].checksum());
+                if (_Delta_width > _Width) {
+                    _Width = _Delta_width;
+                }
+            }
+
+            _Size += ((_Block_entries - 1) * _Width + 7) / 8;
+        }
+
+        return _Size;
+    }
+
+    void _Packed_entry_traits::_Encode(
+        const database_entry* const _Entries, const size_t _Count, byte_t* const _Dest) noexcept {
+        const size_t _Blocks        = _Block_count(_Count);
+        const size_t _Index_size    = _Blocks * sizeof(_Block_info);
+        byte_t* const _Data         = _Dest + _Index_size;
+        uint32_t _Offset            = 0;
+        ::memset(_Dest, 0, _Encoded_size(_Entries, _Count));
+        for (size_t _Block = 0; _Block < _Blocks; ++_Block) {
+            const database_entry* const _First = _Entries + _Block * _Block_size;
+            const size_t _Block_entries        = _Entries_in_block(_Block, _Count);
+            _Block_info _Info                  = {0};
+            _Info._First                       = _First->checksum();
+            _Info._Offset                      = _Offset;
+            uint8_t _Delta_width;
+            for (size_t _Idx = 1; _Idx < _Block_entries; ++_Idx) {
+                _Delta_width = _Bit_width(_First[_Idx].checksum() - _First[_Idx - 1].checksum());
+                if (_Delta_width > _Info._Width) {
+                    _Info._Width = _Delta_width;
+                }
+            }
+
+            byte_t* const _Block_data = _Data + _Offset;
+            for (size_t _Idx = 1; _Idx < _Block_entries; ++_Idx) {
+                _Write_bits(_Block_data, (_Idx - 1) * _Info._Width, _Info._Width,
+                    _First[_Idx].checksum() - _First[_Idx - 1].checksum());
+            }
+
+            ::memcpy(_Dest + _Block * sizeof(_Block_info), &_Info, sizeof(_Block_info));
+            _Offset += static_cast<uint32_t>(((_Block_entries - 1) * _Info._Width + 7) / 8);
+        }
+    }
+
+    bool _Packed_entry_traits::_Is_valid(
+        const byte_t* const _Payload, const size_t _Size, const size_t _Count) noexcept {
+        const size_t _Blocks     = _Block_count(_Count);
+        const size_t _Index_size = _Blocks * sizeof(_Block_info);
+        if (_Blocks > _Size / sizeof(_Block_info) || _Size - _Index_size < _Padding_size) {
+            return false; // the payload is too small to store the skip index
+        }
+
+        const size_t _Data_size = _Size - _Index_size - _Padding_size;
+        size_t _Expected_offset = 0;
+        for (size_t _Block = 0; _Block < _Blocks; ++_Block) {
+            const _Block_info _Info = _Get_block_info(_Payload, _Block);
+            if (_Info._Width > 64 || _Info._Offset != _Expected_offset
+                || _Info._Reserved[0] != 0 || _Info._Reserved[1] != 0 || _Info._Reserved[2] != 0) {
+                return false;
+            }
+
+            if (_Block > 0 && _Info._First <= _Get_block_info(_Payload, _Block - 1)._First) {
+                return false; // blocks must be sorted
+            }
+
+            _Expected_offset += ((_Entries_in_block(_Block, _Count) - 1) * _Info._Width + 7) / 8;
+            if (_Expected_offset > _Data_size) {
+                return false;
+            }
+        }
+
+        return _Expected_offset == _Data_size;
+    }
+
+    void _Packed_entry_traits::_Decode(
+        const byte_t* const _Payload, const size_t _Count, database_entry* const _Dest) noexcept {
+        const size_t _Blocks       = _Block_count(_Count);
+        const byte_t* const _Data  = _Payload + _Blocks * sizeof(_Block_info);
+        database_entry* _Dest_iter = _Dest;
+        for (size_t _Block = 0; _Block < _Blocks; ++_Block) {
+            const _Block_info _Info         = _Get_block_info(_Payload, _Block);
+            const byte_t* const _Block_data = _Data + _Info._Offset;
+            const size_t _Block_entries     = _Entries_in_block(_Block, _Count);
+            checksum_t _Val                 = static_cast<checksum_t>(_Info._First);
+            *_Dest_iter++                   = database_entry{_Val};
+            for (size_t _Idx = 1; _Idx < _Block_entries; ++_Idx) {
+                _Val         += static_cast<checksum_t>(
+                    _Read_bits(_Block_data, (_Idx - 1) * _Info._Width, _Info._Width));
+                *_Dest_iter++ = database_entry{_Val};
+            }
+        }
+    }
+
+    bool _Packed_entry_traits::_Contains(
+        const byte_t* const _Payload, const size_t _Count, const checksum_t _Val) noexcept {
+        // find the last block whose first checksum is less than or equal to _Val
+        const size_t _Blocks = _Block_count(_Count);
+        size_t _First        = 0;
+        size_t _Last         = _Blocks;
+        size_t _Mid;
+        while (_First < _Last) {
+            _Mid = _First + (_Last - _First) / 2;
+            if (_Get_block_info(_Payload, _Mid)._First <= _Val) {
+                _First = _Mid + 1;
+            } else {
+                _Last = _Mid;
+            }
+        }
+
+        if (_First == 0) { // _Val is less than the first checksum
+            return false;
+        }
+
+        // decode the selected block only
+        const size_t _Block             = _First - 1;
+        const _Block_info _Info         = _Get_block_info(_Payload, _Block);
+        const byte_t* const _Block_data = _Payload + _Blocks * sizeof(_Block_info) + _Info._Offset;
+        const size_t _Block_entries     = _Entries_in_block(_Block, _Count);
+        checksum_t _Current             = static_cast<checksum_t>(_Info._First);
+        for (size_t _Idx = 1; _Idx < _Block_entries && _Current < _Val; ++_Idx) {
+            _Current += static_cast<checksum_t>(
+                _Read_bits(_Block_data, (_Idx - 1) * _Info._Width, _Info._Width));
+        }
+
+        return _Current == _Val;
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,75 @@
+// packed_entries.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_PACKED_ENTRIES_HPP_
+#define _DBMGR_PACKED_ENTRIES_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+
+namespace mjx {
+    class database_entry;
+
+    struct _Packed_entry_traits {
+        // Note: The packed encoding stores sorted checksums in fixed-size blocks. Each block stores
+        //       its first checksum in the skip index, followed by bit-packed deltas between the
+        //       consecutive checksums. All deltas within a block share the same bit width, which is
+        //       the width of the largest delta. The payload looks like this:
+        //
+        //       [skip index: _Block_info * block count][block 0 deltas]...[block N deltas][padding]
+        //
+        //       A lookup binary-searches the skip index and decodes a single block. The padding allows
+        //       reading deltas with unaligned 64-bit loads without checking the payload boundary.
+        static constexpr size_t _Block_size   = 128; // number of entries per block
+        static constexpr size_t _Padding_size = 8;
+
+        struct _Block_info { // skip index entry
+            uint64_t _First; // first checksum in the block
+            uint32_t _Offset; // offset of the block deltas (relative to the end of the skip index)
+            uint8_t _Width; // bit width of each delta
+            uint8_t _Reserved[3]; // must be zero
+        };
+
+        static_assert(sizeof(_Block_info) == 16, "_Block_info must be 16 bytes long");
+
+        // returns the number of blocks needed to store _Count entries
+        static size_t _Block_count(const size_t _Count) noexcept;
+
+        // returns the number of entries stored in the selected block
+        static size_t _Entries_in_block(const size_t _Block, const size_t _Count) noexcept;
+
+        // returns the number of bits needed to store the value
+        static uint8_t _Bit_width(uint64_t _Val) noexcept;
+
+        // returns the size of the encoded entries (in bytes), _Entries must be sorted and unique
+        static size_t _Encoded_size(const database_entry* const _Entries, const size_t _Count) noexcept;
+
+        // encodes the entries, _Dest must be at least _Encoded_size() bytes long
+        static void _Encode(
+            const database_entry* const _Entries, const size_t _Count, byte_t* const _Dest) noexcept;
+
+        // checks if the encoded payload is consistent (O(block count))
+        static bool _Is_valid(const byte_t* const _Payload, const size_t _Size, const size_t _Count) noexcept;
+
+        // decodes all the entries, the payload must be valid
+        static void _Decode(const byte_t* const _Payload, const size_t _Count, database_entry* const _Dest) noexcept;
+
+        // checks if the encoded payload contains the checksum, the payload must be valid
+        static bool _Contains(const byte_t* const _Payload, const size_t _Count, const checksum_t _Val) noexcept;
+
+        // returns the selected skip index entry
+        static _Block_info _Get_block_info(const byte_t* const _Payload, const size_t _Block) noexcept;
+
+        // reads _Width bits starting at the selected bit
+        static uint64_t _Read_bits(const byte_t* const _Data, const size_t _Bit, const uint8_t _Width) noexcept;
+
+        // writes _Width bits starting at the selected bit (the destination must be zeroed)
+        static void _Write_bits(
+            byte_t* const _Data, const size_t _Bit, const uint8_t _Width, const uint64_t _Val) noexcept;
+    };
+} // namespace mjx
+
+#endif // _DBMGR_PACKED_ENTRIES_HPP_
\ No newline at end of file
@@ -0,0 +1,285 @@
+// path_trie.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cstring>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/path_trie.hpp>
+
+namespace mjx {
+    [[nodiscard]] bool _Path_trie_traits::_Normalize(const path& _Path, path::string_type& _Result) {
+        // Note: The elements produced by the path decomposition are split further, since the root name
+        //       of a UNC path (\\server) contains separators itself. Dot components are resolved lexically.
+        ::std::vector<size_t> _Starts; // offset of each component in _Result
+        _Result.clear();
+        for (const path& _Elem : _Path) {
+            const wchar_t* _First      = _Elem.c_str();
+            const wchar_t* const _Last = _First + _Elem.native().size();
+            while (_First != _Last) {
+                while (_First != _Last && _Is_separator(*_First)) {
+                    ++_First;
+                }
+
+                const wchar_t* _Next = _First;
+                while (_Next != _Last && !_Is_separator(*_Next)) {
+                    ++_Next;
+                }
+
+                const size_t _Size = static_cast<size_t>(_Next - _First);
+                if (_Size == 0 || (_Size == 1 && _First[0] == L'.')) { // empty or current directory, skip it
+                } else if (_Size == 2 && _First[0] == L'.' && _First[1] == L'.') { // parent directory
+                    if (!_Starts.empty()) {
+                        _Result.resize(_Starts.back() > 0 ? _Starts.back() - 1 : 0); // drop the separator too
+                        _Starts.pop_back();
+                    }
+                } else {
+                    if (!_Result.empty()) {
+                        _Result.push_back(L'\\');
+                    }
+
+                    _Starts.push_back(_Result.size());
+                    for (; _First != _Next; ++_First) {
+                        _Result.push_back(_Crc32c_traits::_Fold_case(*_First));
+                    }
+                }
+
+                _First = _Next;
+            }
+        }
+
+        return !_Result.empty();
+    }
+
+    path_trie::path_trie() noexcept : _Mynodes(), _Mylabels() {}
+
+    path_trie::path_trie(const ::std::vector<database_rule>& _Rules) : _Mynodes(), _Mylabels() {
+        ::std::vector<_Pending_rule> _Pending;
+        for (const database_rule& _Rule : _Rules) {
+            if (_Rule.kind() != rule_kind::full_path && _Rule.kind() != rule_kind::directory) {
+                continue;
+            }
+
+            // Note: The rule data is a normalized path, so it can be split on backslashes only.
+            const wchar_t* _First      = reinterpret_cast<const wchar_t*>(_Rule.data().data());
+            const wchar_t* const _Last = _First + _Rule.data().size() / sizeof(wchar_t);
+            _Pending_rule _New_rule;
+            _New_rule._Flag = _Rule.kind() == rule_kind::full_path
+                ? _Path_trie_traits::_Match_file : _Path_trie_traits::_Match_directory;
+            while (_First != _Last) {
+                const wchar_t* _Next = ::std::find(_First, _Last, L'\\');
+                if (_Next != _First) {
+                    _New_rule._Components.emplace_back(_First, static_cast<size_t>(_Next - _First));
+                }
+
+                _First = _Next != _Last ? _Next + 1 : _Last;
+            }
+
+            if (!_New_rule._Components.empty()) {
+                _Pending.push_back(::std::move(_New_rule));
+            }
+        }
+
+        if (_Pending.empty()) {
+            return;
+        }
+
+        ::std::sort(_Pending.begin(), _Pending.end(), [](const _Pending_rule& _Left, const _Pending_rule& _Right) {
+            const size_t _Count = (::std::min)(_Left._Components.size(), _Right._Components.size());
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                const int _Result = _Compare(_Left._Components[_Idx], _Right._Components[_Idx]);
+                if (_Result != 0) {
+                    return _Result < 0;
+                }
+            }
+
+            return _Left._Components.size() < _Right._Components.size(); // a prefix goes first
+        });
+
+        _Mynodes.push_back(_Node{0, 0, 0, 0, 0, 0}); // root
+        _Build(_Pending.data(), _Pending.data() + _Pending.size(), 0, 0);
+    }
+
+    path_trie::~path_trie() noexcept {}
+
+    int path_trie::_Compare(const unicode_string_view _Left, const unicode_string_view _Right) noexcept {
+        const size_t _Count = (::std::min)(_Left.size(), _Right.size());
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+            if (_Left[_Idx] != _Right[_Idx]) {
+                return _Left[_Idx] < _Right[_Idx] ? -1 : 1;
+            }
+        }
+
+        return _Left.size() < _Right.size() ? -1 : (_Left.size() > _Right.size() ? 1 : 0);
+    }
+
+    void path_trie::_Build(const _Pending_rule* _First, const _Pending_rule* const _Last,
+        const size_t _Depth, const size_t _Node_idx) {
+        // Note: The rules are sorted, so the ones that end at this node go first, and the ones that
+        //       share the next component are adjacent. The nodes are referenced by their indices,
+        //       since adding the children may reallocate the nodes.
+        for (; _First != _Last && _First->_Components.size() == _Depth; ++_First) {
+            _Mynodes[_Node_idx]._Flags |= _First->_Flag;
+        }
+
+        size_t _Child_count = 0;
+        for (const _Pending_rule* _Iter = _First; _Iter != _Last; ++_Child_count) {
+            const unicode_string_view _Component = _Iter->_Components[_Depth];
+            do {
+                ++_Iter;
+            } while (_Iter != _Last && _Compare(_Iter->_Components[_Depth], _Component) == 0);
+        }
+
+        if (_Child_count == 0) {
+            return;
+        }
+
+        const size_t _First_child        = _Mynodes.size();
+        _Mynodes[_Node_idx]._First_child = static_cast<uint32_t>(_First_child);
+        _Mynodes[_Node_idx]._Child_count = static_cast<uint32_t>(_Child_count);
+        _Mynodes.resize(_First_child + _Child_count, _Node{0, 0, 0, 0, 0, 0});
+        for (size_t _Child = _First_child; _First != _Last; ++_Child) {
+            const _Pending_rule* _Group_last = _First;
+            do {
+                ++_Group_last;
+            } while (_Group_last != _Last
+                && _Compare(_Group_last->_Components[_Depth], _First->_Components[_Depth]) == 0);
+
+            // merge the chain of single-child nodes that no rule ends at into a single edge
+            size_t _End = _Depth + 1;
+            while (_First->_Components.size() > _End
+                && _Compare(_First->_Components[_End], (_Group_last - 1)->_Components[_End]) == 0) {
+                ++_End;
+            }
+
+            const size_t _Label_off = _Mylabels.size();
+            for (size_t _Idx = _Depth; _Idx < _End; ++_Idx) {
+                if (_Idx > _Depth) {
+                    _Mylabels.push_back(L'\\');
+                }
+
+                _Mylabels.insert(_Mylabels.end(), _First->_Components[_Idx].data(),
+                    _First->_Components[_Idx].data() + _First->_Components[_Idx].size());
+            }
+
+            _Mynodes[_Child]._Label_off  = static_cast<uint32_t>(_Label_off);
+            _Mynodes[_Child]._Label_size = static_cast<uint16_t>(_Mylabels.size() - _Label_off);
+            _Build(_First, _Group_last, _End, _Child);
+            _First = _Group_last;
+        }
+    }
+
+    const path_trie::_Node* path_trie::_Find_child(
+        const _Node& _Parent, const wchar_t* const _First, const wchar_t* const _Last) const noexcept {
+        // Note: The children are distinct by their first components, so binary search finds
+        //       the only candidate. The component is case-folded while it's compared.
+        size_t _Low  = _Parent._First_child;
+        size_t _High = _Low + _Parent._Child_count;
+        while (_Low < _High) {
+            const size_t _Mid                = _Low + (_High - _Low) / 2;
+            const wchar_t* _Label            = _Mylabels.data() + _Mynodes[_Mid]._Label_off;
+            const wchar_t* const _Label_last = _Label + _Mynodes[_Mid]._Label_size;
+            const wchar_t* _Pos              = _First;
+            int _Result                      = 0;
+            for (; _Pos != _Last && _Label != _Label_last && *_Label != L'\\'; ++_Pos, ++_Label) {
+                const wchar_t _Ch = _Crc32c_traits::_Fold_case(*_Pos);
+                if (_Ch != *_Label) {
+                    _Result = _Ch < *_Label ? -1 : 1;
+                    break;
+                }
+            }
+
+            if (_Result == 0) { // one component is a prefix of the other, the shorter one goes first
+                const bool _Label_done = _Label == _Label_last || *_Label == L'\\';
+                if (_Pos == _Last && _Label_done) {
+                    return &_Mynodes[_Mid];
+                }
+
+                _Result = _Pos == _Last ? -1 : 1;
+            }
+
+            if (_Result < 0) {
+                _High = _Mid;
+            } else {
+                _Low = _Mid + 1;
+            }
+        }
+
+        return nullptr;
+    }
+
+    const wchar_t* path_trie::_Match_label(
+        const _Node& _Child, const wchar_t* _Pos, const wchar_t* const _Last) const noexcept {
+        const wchar_t* _Label            = _Mylabels.data() + _Child._Label_off;
+        const wchar_t* const _Label_last = _Label + _Child._Label_size;
+        for (; _Label != _Label_last; ++_Label) {
+            if (*_Label == L'\\') { // matches one or more separators
+                if (_Pos == _Last || !_Path_trie_traits::_Is_separator(*_Pos)) {
+                    return nullptr;
+                }
+
+                do {
+                    ++_Pos;
+                } while (_Pos != _Last && _Path_trie_traits::_Is_separator(*_Pos));
+            } else {
+                if (_Pos == _Last || _Crc32c_traits::_Fold_case(*_Pos) != *_Label) {
+                    return nullptr;
+                }
+
+                ++_Pos;
+            }
+        }
+
+        // the label must end at the component boundary
+        return _Pos == _Last || _Path_trie_traits::_Is_separator(*_Pos) ? _Pos : nullptr;
+    }
+
+    bool path_trie::empty() const noexcept {
+        return _Mynodes.empty();
+    }
+
+    bool path_trie::matches(const unicode_string_view _Path) const noexcept {
+        if (_Mynodes.empty()) {
+            return false;
+        }
+
+        const wchar_t* _Pos        = _Path.data();
+        const wchar_t* const _Last = _Pos + _Path.size();
+        const _Node* _Current      = _Mynodes.data(); // root
+        const wchar_t* _Next;
+        for (;;) {
+            while (_Pos != _Last && _Path_trie_traits::_Is_separator(*_Pos)) {
+                ++_Pos;
+            }
+
+            if (_Pos == _Last) { // the whole path matched
+                return (_Current->_Flags & _Path_trie_traits::_Match_file) != 0;
+            }
+
+            if (_Current->_Flags & _Path_trie_traits::_Match_directory) { // the path is inside the directory
+                return true;
+            }
+
+            _Next = _Pos;
+            while (_Next != _Last && !_Path_trie_traits::_Is_separator(*_Next)) {
+                ++_Next;
+            }
+
+            _Current = _Find_child(*_Current, _Pos, _Next);
+            if (!_Current) {
+                return false;
+            }
+
+            _Pos = _Match_label(*_Current, _Pos, _Last);
+            if (!_Pos) {
+                return false;
+            }
+        }
+    }
+
+    database_rule make_path_rule(const rule_kind _Kind, const unicode_string_view _Normalized) {
+        const byte_t* const _Bytes = reinterpret_cast<const byte_t*>(_Normalized.data());
+        return database_rule{_Kind, ::std::vector<byte_t>(_Bytes, _Bytes + _Normalized.size() * sizeof(wchar_t))};
+    }
+} // namespace mjx
\ No newline at end of file
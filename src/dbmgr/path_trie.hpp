@@ -0,0 +1,91 @@
+// path_trie.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_PATH_TRIE_HPP_
+#define _DBMGR_PATH_TRIE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/database_rule.hpp>
+#include <mjfs/path.hpp>
+#include <mjstr/string_view.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Path_trie_traits {
+        // Note: Paths are normalized to absolute, case-folded components separated by a single
+        //       backslash, without any trailing separator. Rules are normalized once, when they're
+        //       added, the queried paths are normalized on the fly while they're matched.
+        static constexpr uint8_t _Match_file      = 0x01; // a full path rule ends at the node
+        static constexpr uint8_t _Match_directory = 0x02; // a directory rule ends at the node
+
+        // checks if the character is a directory separator
+        static constexpr bool _Is_separator(const wchar_t _Ch) noexcept {
+            return _Ch == L'\\' || _Ch == L'/';
+        }
+
+        // normalizes the path, fails if it has no components
+        [[nodiscard]] static bool _Normalize(const path& _Path, path::string_type& _Result);
+    };
+
+    class path_trie { // immutable radix trie of full path and directory rules
+    public:
+        path_trie() noexcept;
+        path_trie(const path_trie&)     = default;
+        path_trie(path_trie&&) noexcept = default;
+        ~path_trie() noexcept;
+
+        explicit path_trie(const ::std::vector<database_rule>& _Rules);
+
+        path_trie& operator=(const path_trie&)     = default;
+        path_trie& operator=(path_trie&&) noexcept = default;
+
+        // checks if the trie is empty (matches no path)
+        bool empty() const noexcept;
+
+        // checks if the path matches any rule (O(path length), regardless of the number of rules)
+        bool matches(const unicode_string_view _Path) const noexcept;
+
+    private:
+        struct _Node {
+            uint32_t _Label_off; // offset of the edge label in _Mylabels
+            uint16_t _Label_size; // one or more components separated by a backslash
+            uint8_t _Flags; // combination of _Match_file and _Match_directory
+            uint8_t _Reserved;
+            uint32_t _First_child; // children are stored contiguously, sorted by their labels
+            uint32_t _Child_count;
+        };
+
+        static_assert(sizeof(_Node) == 16, "_Node must be 16 bytes long");
+
+        struct _Pending_rule {
+            ::std::vector<unicode_string_view> _Components;
+            uint8_t _Flag;
+        };
+
+        // compares two components
+        static int _Compare(const unicode_string_view _Left, const unicode_string_view _Right) noexcept;
+
+        // builds the subtree of the rules that share the first _Depth components
+        void _Build(const _Pending_rule* _First, const _Pending_rule* const _Last,
+            const size_t _Depth, const size_t _Node_idx);
+
+        // finds the child whose label starts with the component
+        const _Node* _Find_child(const _Node& _Parent, const wchar_t* const _First,
+            const wchar_t* const _Last) const noexcept;
+
+        // matches the rest of the label, returns the position after it or null if it doesn't match
+        const wchar_t* _Match_label(
+            const _Node& _Child, const wchar_t* _Pos, const wchar_t* const _Last) const noexcept;
+
+        ::std::vector<_Node> _Mynodes; // the first node is the root
+        ::std::vector<wchar_t> _Mylabels;
+    };
+
+    // makes a rule that matches the normalized path
+    database_rule make_path_rule(const rule_kind _Kind, const unicode_string_view _Normalized);
+} // namespace mjx
+
+#endif // _DBMGR_PATH_TRIE_HPP_
\ No newline at end of file
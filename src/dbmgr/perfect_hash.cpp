@@ -0,0 +1,168 @@
+// perfect_hash.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <dbmgr/database.hpp>
+#include <dbmgr/perfect_hash.hpp>
+
+namespace mjx {
+    uint64_t _Perfect_hash_traits::_Hash(const checksum_t _Val, const size_t _Level) noexcept {
+        // Note: The checksums are already well distributed, but the levels need independent positions.
+        //       The mixing function comes from SplitMix64.
+        uint64_t _Hash = static_cast<uint64_t>(_Val) + (static_cast<uint64_t>(_Level) + 1) * 0x9E37'79B9'7F4A'7C15;
+        _Hash          = (_Hash ^ (_Hash >> 30)) * 0xBF58'476D'1CE4'E5B9;
+        _Hash          = (_Hash ^ (_Hash >> 27)) * 0x94D0'49BB'1331'11EB;
+        return _Hash ^ (_Hash >> 31);
+    }
+
+    size_t _Perfect_hash_traits::_Reduce(const uint64_t _Hash, const size_t _Size) noexcept {
+        // Note: Multiplication followed by a shift avoids the slow modulo operation.
+        return static_cast<size_t>(((_Hash >> 32) * static_cast<uint64_t>(_Size)) >> 32);
+    }
+
+    size_t _Perfect_hash_traits::_Popcount(uint64_t _Word) noexcept {
+        _Word -= (_Word >> 1) & 0x5555'5555'5555'5555;
+        _Word  = (_Word & 0x3333'3333'3333'3333) + ((_Word >> 2) & 0x3333'3333'3333'3333);
+        _Word  = (_Word + (_Word >> 4)) & 0x0F0F'0F0F'0F0F'0F0F;
+        return static_cast<size_t>((_Word * 0x0101'0101'0101'0101) >> 56);
+    }
+
+    perfect_hash_set::perfect_hash_set() noexcept
+        : _Mybits(), _Myranks(), _Mylevels(), _Mykeys(), _Myfallback() {}
+
+    perfect_hash_set::perfect_hash_set(const ::std::vector<database_entry>& _Entries)
+        : _Mybits(), _Myranks(), _Mylevels(), _Mykeys(), _Myfallback() {
+        ::std::vector<checksum_t> _Keys;
+        _Keys.reserve(_Entries.size());
+        for (const database_entry& _Entry : _Entries) {
+            _Keys.push_back(_Entry.checksum());
+        }
+
+        ::std::sort(_Keys.begin(), _Keys.end());
+        _Keys.erase(::std::unique(_Keys.begin(), _Keys.end()), _Keys.end());
+        _Build(::std::move(_Keys));
+    }
+
+    perfect_hash_set::~perfect_hash_set() noexcept {}
+
+    void perfect_hash_set::_Build(::std::vector<checksum_t>&& _Keys) {
+        struct _Placed_key {
+            size_t _Bit; // global position of the key
+            checksum_t _Val;
+        };
+
+        const size_t _Count = _Keys.size();
+        ::std::vector<_Placed_key> _Placed;
+        ::std::vector<checksum_t> _Next;
+        ::std::vector<uint64_t> _Seen;
+        ::std::vector<uint64_t> _Collided;
+        _Placed.reserve(_Count);
+        for (size_t _Level = 0; _Level < _Perfect_hash_traits::_Max_levels && !_Keys.empty(); ++_Level) {
+            const size_t _Words = (_Keys.size() * _Perfect_hash_traits::_Gamma + 63) / 64;
+            const size_t _Size  = _Words * 64; // number of bits in this level
+            const size_t _First = _Mybits.size() * 64; // global position of the first bit
+            _Seen.assign(_Words, 0);
+            _Collided.assign(_Words, 0);
+            for (const checksum_t _Key : _Keys) { // mark the colliding positions
+                const size_t _Pos    = _Perfect_hash_traits::_Reduce(_Perfect_hash_traits::_Hash(_Key, _Level), _Size);
+                const uint64_t _Mask = uint64_t{1} << (_Pos % 64);
+                if (_Seen[_Pos / 64] & _Mask) {
+                    _Collided[_Pos / 64] |= _Mask;
+                } else {
+                    _Seen[_Pos / 64] |= _Mask;
+                }
+            }
+
+            _Next.clear();
+            for (const checksum_t _Key : _Keys) { // keep the unique positions, move the rest to the next level
+                const size_t _Pos = _Perfect_hash_traits::_Reduce(_Perfect_hash_traits::_Hash(_Key, _Level), _Size);
+                if (_Collided[_Pos / 64] & (uint64_t{1} << (_Pos % 64))) {
+                    _Next.push_back(_Key);
+                } else {
+                    _Placed.push_back(_Placed_key{_First + _Pos, _Key});
+                }
+            }
+
+            for (size_t _Idx = 0; _Idx < _Words; ++_Idx) {
+                _Seen[_Idx] &= ~_Collided[_Idx];
+            }
+
+            _Mylevels.push_back(_First);
+            _Mybits.insert(_Mybits.end(), _Seen.begin(), _Seen.end());
+            _Keys.swap(_Next);
+        }
+
+        _Mylevels.push_back(_Mybits.size() * 64); // end of the last level
+        _Myfallback = ::std::move(_Keys); // already sorted
+
+        // compute the rank samples
+        uint32_t _Total = 0;
+        _Myranks.reserve(_Mybits.size() / _Perfect_hash_traits::_Rank_interval + 1);
+        for (size_t _Idx = 0; _Idx < _Mybits.size(); ++_Idx) {
+            if (_Idx % _Perfect_hash_traits::_Rank_interval == 0) {
+                _Myranks.push_back(_Total);
+            }
+
+            _Total += static_cast<uint32_t>(_Perfect_hash_traits::_Popcount(_Mybits[_Idx]));
+        }
+
+        // store the keys at their ranks
+        _Mykeys.resize(_Placed.size());
+        for (const _Placed_key& _Key : _Placed) {
+            _Mykeys[_Rank(_Key._Bit)] = _Key._Val;
+        }
+    }
+
+    size_t perfect_hash_set::_Rank(const size_t _Bit) const noexcept {
+        const size_t _Word = _Bit / 64;
+        size_t _Idx        = _Word - _Word % _Perfect_hash_traits::_Rank_interval;
+        size_t _Result     = _Myranks[_Idx / _Perfect_hash_traits::_Rank_interval];
+        for (; _Idx < _Word; ++_Idx) {
+            _Result += _Perfect_hash_traits::_Popcount(_Mybits[_Idx]);
+        }
+
+        return _Result + _Perfect_hash_traits::_Popcount(_Mybits[_Word] & ((uint64_t{1} << (_Bit % 64)) - 1));
+    }
+
+    size_t perfect_hash_set::_Find_index(const checksum_t _Val) const noexcept {
+        size_t _Size;
+        size_t _Pos;
+        for (size_t _Level = 0; _Level + 1 < _Mylevels.size(); ++_Level) {
+            _Size = _Mylevels[_Level + 1] - _Mylevels[_Level];
+            _Pos  = _Mylevels[_Level] + _Perfect_hash_traits::_Reduce(_Perfect_hash_traits::_Hash(_Val, _Level), _Size);
+            if (_Mybits[_Pos / 64] & (uint64_t{1} << (_Pos % 64))) { // the key belongs to this level
+                return _Rank(_Pos);
+            }
+        }
+
+        return _Mykeys.size();
+    }
+
+    bool perfect_hash_set::empty() const noexcept {
+        return _Mykeys.empty() && _Myfallback.empty();
+    }
+
+    size_t perfect_hash_set::size() const noexcept {
+        return _Mykeys.size() + _Myfallback.size();
+    }
+
+    bool perfect_hash_set::contains(const checksum_t _Val) const noexcept {
+        const size_t _Idx = _Find_index(_Val);
+        if (_Idx < _Mykeys.size()) { // a foreign key may map onto a stored one, compare them
+            return _Mykeys[_Idx] == _Val;
+        }
+
+        return !_Myfallback.empty() && ::std::binary_search(_Myfallback.begin(), _Myfallback.end(), _Val);
+    }
+
+    double perfect_hash_set::bits_per_key() const noexcept {
+        const size_t _Count = size();
+        if (_Count == 0) {
+            return 0.0;
+        }
+
+        return static_cast<double>(_Mybits.size() * 64 + _Myranks.size() * 32) / static_cast<double>(_Count);
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,78 @@
+// perfect_hash.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_PERFECT_HASH_HPP_
+#define _DBMGR_PERFECT_HASH_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <vector>
+
+namespace mjx {
+    class database_entry;
+
+    struct _Perfect_hash_traits {
+        // Note: The perfect hash is built in levels (BBHash). Each key is hashed into a bit array
+        //       of the current level. Keys that land on a unique position set their bit, the colliding
+        //       ones are moved to the next level. The rank of the set bit is the index of the key.
+        //       Keys that still collide after the last level are stored in the sorted fallback array.
+        static constexpr size_t _Gamma         = 2; // bits per key in each level (about 3.3 bits per key in total)
+        static constexpr size_t _Max_levels    = 24;
+        static constexpr size_t _Rank_interval = 8; // number of words per rank sample (512 bits)
+
+        // hashes the checksum for the selected level
+        static uint64_t _Hash(const checksum_t _Val, const size_t _Level) noexcept;
+
+        // maps the hash onto the range [0, _Size)
+        static size_t _Reduce(const uint64_t _Hash, const size_t _Size) noexcept;
+
+        // returns the number of set bits in the word
+        static size_t _Popcount(uint64_t _Word) noexcept;
+    };
+
+    class perfect_hash_set { // immutable set of checksums with minimal perfect hash lookup
+    public:
+        perfect_hash_set() noexcept;
+        perfect_hash_set(const perfect_hash_set&)     = default;
+        perfect_hash_set(perfect_hash_set&&) noexcept = default;
+        ~perfect_hash_set() noexcept;
+
+        explicit perfect_hash_set(const ::std::vector<database_entry>& _Entries);
+
+        perfect_hash_set& operator=(const perfect_hash_set&)     = default;
+        perfect_hash_set& operator=(perfect_hash_set&&) noexcept = default;
+
+        // checks if the set is empty
+        bool empty() const noexcept;
+
+        // returns the number of stored checksums
+        size_t size() const noexcept;
+
+        // checks if the set contains the checksum
+        bool contains(const checksum_t _Val) const noexcept;
+
+        // returns the size of the hash structure (in bits per key, without the verification keys)
+        double bits_per_key() const noexcept;
+
+    private:
+        // builds the levels from unique checksums
+        void _Build(::std::vector<checksum_t>&& _Keys);
+
+        // returns the rank of the selected bit (number of set bits before it)
+        size_t _Rank(const size_t _Bit) const noexcept;
+
+        // returns the index of the checksum, or size() if not found
+        size_t _Find_index(const checksum_t _Val) const noexcept;
+
+        ::std::vector<uint64_t> _Mybits; // concatenated bit arrays of all levels
+        ::std::vector<uint32_t> _Myranks; // rank samples
+        ::std::vector<size_t> _Mylevels; // first bit of each level (plus the end)
+        ::std::vector<checksum_t> _Mykeys; // keys indexed by rank (for verification)
+        ::std::vector<checksum_t> _Myfallback; // sorted keys that couldn't be placed
+    };
+} // namespace mjx
+
+#endif // _DBMGR_PERFECT_HASH_HPP_
\ No newline at end of file
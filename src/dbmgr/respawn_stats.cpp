@@ -0,0 +1,78 @@
+// respawn_stats.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <dbmgr/database.hpp>
+#include <dbmgr/respawn_stats.hpp>
+#include <memory>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+
+namespace mjx {
+    path _Respawn_stats_traits::_Get_file_path() {
+        return database_location::current().directory() / L"respawns.stats";
+    }
+
+    bool load_respawn_stats(::std::vector<respawn_record>& _Records, service_counters& _Counters) {
+        file _File(_Respawn_stats_traits::_Get_file_path(), file_access::read, file_share::all);
+        file_stream _Stream(_File);
+        if (!_Stream.is_open()) { // no statistics yet
+            return false;
+        }
+
+        _Respawn_stats_traits::_File_header _Header;
+        if (_Stream.read(reinterpret_cast<byte_t*>(&_Header), sizeof(_Header)) != sizeof(_Header)
+            || _Header._Magic != _Respawn_stats_traits::_Magic || _Header._Version != _Respawn_stats_traits::_Version
+            || _Header._Reserved != 0 || _Header._Count > _Respawn_stats_traits::_Max_count
+            || _File.size() != sizeof(_Header) + sizeof(service_counters) + _Header._Count * sizeof(respawn_record)) {
+            return false; // unknown or truncated file
+        }
+
+        const size_t _Size = sizeof(service_counters) + _Header._Count * sizeof(respawn_record);
+        ::std::vector<byte_t> _Payload(_Size);
+        if (_Stream.read(_Payload.data(), _Size) != _Size
+            || static_cast<uint32_t>(compute_checksum(byte_string_view{_Payload.data(), _Size})) != _Header._Checksum) {
+            return false;
+        }
+
+        ::memcpy(::std::addressof(_Counters), _Payload.data(), sizeof(service_counters));
+        _Records.resize(_Header._Count);
+        ::memcpy(_Records.data(), _Payload.data() + sizeof(service_counters), _Size - sizeof(service_counters));
+        return true;
+    }
+
+    bool save_respawn_stats(
+        const ::std::vector<respawn_record>& _Records, const service_counters& _Counters) noexcept {
+        try {
+            const size_t _Size = sizeof(service_counters) + _Records.size() * sizeof(respawn_record);
+            ::std::vector<byte_t> _Payload(_Size);
+            ::memcpy(_Payload.data(), ::std::addressof(_Counters), sizeof(service_counters));
+            ::memcpy(_Payload.data() + sizeof(service_counters), _Records.data(), _Size - sizeof(service_counters));
+            _Respawn_stats_traits::_File_header _Header = {};
+            _Header._Magic                              = _Respawn_stats_traits::_Magic;
+            _Header._Version                            = _Respawn_stats_traits::_Version;
+            _Header._Count                              = static_cast<uint32_t>(_Records.size());
+            _Header._Checksum                           =
+                static_cast<uint32_t>(compute_checksum(byte_string_view{_Payload.data(), _Size}));
+            file _File(_Respawn_stats_traits::_Get_file_path(), file_access::write);
+            file_stream _Stream(_File);
+            return _Stream.is_open() && _File.resize(0) // must be empty
+                && _Stream.write(reinterpret_cast<const byte_t*>(&_Header), sizeof(_Header))
+                && _Stream.write(_Payload.data(), _Size);
+        } catch (...) {
+            return false; // try again later
+        }
+    }
+
+    double respawn_rate(const respawn_record& _Record) noexcept {
+        // Note: N terminations span N - 1 intervals between the first and the last one.
+        if (_Record.kills < 2 || _Record.last_kill <= _Record.first_kill) {
+            return 0.0;
+        }
+
+        return static_cast<double>(_Record.kills - 1) * static_cast<double>(_Respawn_stats_traits::_Ticks_per_minute)
+            / static_cast<double>(_Record.last_kill - _Record.first_kill);
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,69 @@
+// respawn_stats.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_RESPAWN_STATS_HPP_
+#define _DBMGR_RESPAWN_STATS_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <mjfs/path.hpp>
+#include <vector>
+
+namespace mjx {
+    struct respawn_record { // terminations of a single application, as reported by the service
+        checksum_t checksum;
+        uint64_t first_kill; // FILETIME of the first termination
+        uint64_t last_kill; // FILETIME of the last termination
+        uint32_t kills; // number of terminations
+        uint32_t hot; // 1 if the application is terminated on sight, 0 otherwise
+    };
+
+    static_assert(sizeof(respawn_record) == 32, "respawn_record must be 32 bytes long");
+
+    struct service_counters { // state of the service's queues, as reported by the service
+        uint32_t ingest_peak; // largest number of processes waiting for the matching stage
+        uint32_t enforce_peak; // largest number of processes waiting for the enforcement stage
+        uint64_t ingest_overflows; // number of times the new processes were dropped and all processes rescanned
+        uint64_t enforce_overflows; // number of processes terminated by the matching stage itself
+        uint64_t audit_drops; // number of audit records dropped, because the audit queue was full
+    };
+
+    static_assert(sizeof(service_counters) == 32, "service_counters must be 32 bytes long");
+
+    struct _Respawn_stats_traits {
+        // Note: The service writes the statistics next to the database, so the database manager can read
+        //       them without any connection to the service. The file is rewritten as a whole.
+        //       The header is followed by the counters and the records, the checksum covers both.
+        struct _File_header {
+            uint32_t _Magic; // always _Magic
+            uint16_t _Version; // always _Version
+            uint16_t _Reserved; // must be zero
+            uint32_t _Count; // number of records
+            uint32_t _Checksum; // CRC-32C of the counters and the records
+        };
+
+        static_assert(sizeof(_File_header) == 16, "_File_header must be 16 bytes long");
+
+        static constexpr uint32_t _Magic            = 0x5352'4C41; // "ALRS" in little-endian order
+        static constexpr uint16_t _Version          = 2; // version 1 had no counters
+        static constexpr size_t _Max_count          = 4096; // applications beyond this number aren't reported
+        static constexpr uint64_t _Ticks_per_minute = 600'000'000; // FILETIME ticks per minute
+
+        // returns a path to the statistics file
+        static path _Get_file_path();
+    };
+
+    // loads the respawn statistics and the counters, fails if the file doesn't exist or is invalid
+    bool load_respawn_stats(::std::vector<respawn_record>& _Records, service_counters& _Counters);
+
+    // saves the respawn statistics and the counters
+    bool save_respawn_stats(const ::std::vector<respawn_record>& _Records, const service_counters& _Counters) noexcept;
+
+    // returns the number of terminations per minute, or 0 if the application has been terminated just once
+    double respawn_rate(const respawn_record& _Record) noexcept;
+} // namespace mjx
+
+#endif // _DBMGR_RESPAWN_STATS_HPP_
\ No newline at end of file
@@ -0,0 +1,221 @@
+// schedule.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <dbmgr/schedule.hpp>
+#include <dbmgr/tinywin.hpp>
+
+namespace mjx {
+    uint64_t _Schedule_traits::_Get_local_time() noexcept {
+        FILETIME _Utc;
+        FILETIME _Local;
+        ::GetSystemTimeAsFileTime(&_Utc);
+        if (!::FileTimeToLocalFileTime(&_Utc, &_Local)) { // time zone unavailable, use UTC
+            _Local = _Utc;
+        }
+
+        return (static_cast<uint64_t>(_Local.dwHighDateTime) << 32) | _Local.dwLowDateTime;
+    }
+
+    uint8_t _Schedule_traits::_Day_of_week(const uint64_t _Minute) noexcept {
+        return static_cast<uint8_t>((_Minute / _Minutes_per_day + 1) % 7); // the epoch is a Monday
+    }
+
+    [[nodiscard]] bool _Schedule_traits::_Parse_day(
+        const wchar_t*& _First, const wchar_t* const _Last, uint8_t& _Day) noexcept {
+        static constexpr wchar_t _Names[7][4] = {L"sun", L"mon", L"tue", L"wed", L"thu", L"fri", L"sat"};
+        if (_Last - _First < 3) {
+            return false;
+        }
+
+        for (uint8_t _Idx = 0; _Idx < 7; ++_Idx) {
+            if ((_First[0] | 0x20) == _Names[_Idx][0] && (_First[1] | 0x20) == _Names[_Idx][1]
+                && (_First[2] | 0x20) == _Names[_Idx][2]) {
+                _First += 3;
+                _Day    = _Idx;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    [[nodiscard]] bool _Schedule_traits::_Parse_time(
+        const wchar_t*& _First, const wchar_t* const _Last, uint16_t& _Time) noexcept {
+        if (_Last - _First < 5 || _First[2] != L':') {
+            return false;
+        }
+
+        for (const size_t _Idx : {0, 1, 3, 4}) {
+            if (_First[_Idx] < L'0' || _First[_Idx] > L'9') {
+                return false;
+            }
+        }
+
+        const uint16_t _Hours   = static_cast<uint16_t>((_First[0] - L'0') * 10 + (_First[1] - L'0'));
+        const uint16_t _Minutes = static_cast<uint16_t>((_First[3] - L'0') * 10 + (_First[4] - L'0'));
+        if (_Minutes >= 60 || _Hours > 24 || (_Hours == 24 && _Minutes != 0)) { // 24:00 ends the day
+            return false;
+        }
+
+        _First += 5;
+        _Time   = static_cast<uint16_t>(_Hours * 60 + _Minutes);
+        return true;
+    }
+
+    bool _Schedule_traits::_Skip_word(
+        const wchar_t*& _First, const wchar_t* const _Last, const unicode_string_view _Word) noexcept {
+        const size_t _Size = _Word.size();
+        if (static_cast<size_t>(_Last - _First) < _Size || ::memcmp(_First, _Word.data(), _Size * sizeof(wchar_t)) != 0
+            || (_First + _Size != _Last && _First[_Size] != L'@')) { // must be followed by the time
+            return false;
+        }
+
+        _First += _Size;
+        return true;
+    }
+
+    [[nodiscard]] bool _Schedule_traits::_Parse(const unicode_string_view _Spec, time_window& _Window) noexcept {
+        const wchar_t* _First      = _Spec.data();
+        const wchar_t* const _Last = _First + _Spec.size();
+        uint8_t _Days              = 0;
+        if (_Skip_word(_First, _Last, L"daily")) {
+            _Days = 0b111'1111;
+        } else if (_Skip_word(_First, _Last, L"weekdays")) {
+            _Days = 0b011'1110;
+        } else if (_Skip_word(_First, _Last, L"weekends")) {
+            _Days = 0b100'0001;
+        } else {
+            uint8_t _From;
+            uint8_t _To;
+            for (;;) {
+                if (!_Parse_day(_First, _Last, _From)) {
+                    return false;
+                }
+
+                _To = _From;
+                if (_First != _Last && *_First == L'-') { // day range, may wrap around the week
+                    ++_First;
+                    if (!_Parse_day(_First, _Last, _To)) {
+                        return false;
+                    }
+                }
+
+                for (uint8_t _Day = _From;; _Day = static_cast<uint8_t>((_Day + 1) % 7)) {
+                    _Days |= static_cast<uint8_t>(1 << _Day);
+                    if (_Day == _To) {
+                        break;
+                    }
+                }
+
+                if (_First == _Last || *_First != L'+') {
+                    break;
+                }
+
+                ++_First;
+            }
+        }
+
+        uint16_t _Start;
+        uint16_t _End;
+        if (_First == _Last || *_First++ != L'@' || !_Parse_time(_First, _Last, _Start)
+            || _First == _Last || *_First++ != L'-' || !_Parse_time(_First, _Last, _End) || _First != _Last) {
+            return false;
+        }
+
+        if (_Start == _End || _Start == _Minutes_per_day) { // empty window or starts at the end of the day
+            return false;
+        }
+
+        _Window.days  = _Days;
+        _Window.start = _Start;
+        _Window.end   = _End;
+        return true;
+    }
+
+    [[nodiscard]] bool _Schedule_traits::_Split(
+        const unicode_string_view _Target, unicode_string_view& _Name, unicode_string_view& _Spec) noexcept {
+        const size_t _Time_pos = _Target.rfind(L'@');
+        if (_Time_pos == unicode_string_view::npos || _Time_pos == 0) {
+            return false;
+        }
+
+        const size_t _Days_pos = _Target.rfind(L'@', _Time_pos - 1);
+        if (_Days_pos == unicode_string_view::npos || _Days_pos == 0) { // no days or no name
+            return false;
+        }
+
+        _Name = _Target.substr(0, _Days_pos);
+        _Spec = _Target.substr(_Days_pos + 1);
+        return true;
+    }
+
+    bool _Schedule_traits::_Is_active(const time_window& _Window, const uint64_t _Minute) noexcept {
+        const uint16_t _Time = static_cast<uint16_t>(_Minute % _Minutes_per_day);
+        const uint8_t _Day   = _Day_of_week(_Minute);
+        if (_Window.start < _Window.end) { // within a single day
+            return (_Window.days & (1 << _Day)) != 0 && _Time >= _Window.start && _Time < _Window.end;
+        } else { // spans midnight, the window belongs to the day it opens on
+            return ((_Window.days & (1 << _Day)) != 0 && _Time >= _Window.start)
+                || ((_Window.days & (1 << ((_Day + 6) % 7))) != 0 && _Time < _Window.end);
+        }
+    }
+
+    uint64_t _Schedule_traits::_Next_change(const time_window& _Window, const uint64_t _Minute) noexcept {
+        // Note: Each enabled day contributes its opening and closing minute. A week and a day
+        //       is enough to find the next one, the previous day is checked because of the windows
+        //       that span midnight.
+        const uint64_t _Today = _Minute / _Minutes_per_day;
+        uint64_t _Result      = _No_change;
+        uint64_t _First;
+        uint64_t _Candidates[2];
+        for (uint64_t _Day = _Today > 0 ? _Today - 1 : 0; _Day <= _Today + 7; ++_Day) {
+            if ((_Window.days & (1 << _Day_of_week(_Day * _Minutes_per_day))) == 0) { // the window is closed
+                continue;
+            }
+
+            _First         = _Day * _Minutes_per_day;
+            _Candidates[0] = _First + _Window.start;
+            _Candidates[1] = _First + _Window.end + (_Window.start < _Window.end ? 0 : _Minutes_per_day);
+            for (const uint64_t _Candidate : _Candidates) {
+                if (_Candidate > _Minute && _Candidate < _Result) {
+                    _Result = _Candidate;
+                }
+            }
+        }
+
+        return _Result;
+    }
+
+    [[nodiscard]] bool _Schedule_traits::_Decode(
+        const database_rule& _Rule, checksum_t& _Checksum, time_window& _Window) noexcept {
+        if (_Rule.kind() != rule_kind::schedule || _Rule.data().size() != sizeof(_Record)) {
+            return false;
+        }
+
+        _Record _Data;
+        ::memcpy(&_Data, _Rule.data().data(), sizeof(_Record));
+        if ((_Data._Days & 0b111'1111) == 0 || _Data._Start >= _Minutes_per_day
+            || _Data._End > _Minutes_per_day || _Data._Start == _Data._End) {
+            return false;
+        }
+
+        _Checksum     = _Data._Checksum;
+        _Window.days  = _Data._Days;
+        _Window.start = _Data._Start;
+        _Window.end   = _Data._End;
+        return true;
+    }
+
+    database_rule make_schedule_rule(const checksum_t _Checksum, const time_window& _Window) {
+        _Schedule_traits::_Record _Data = {}; // the reserved bytes must be zero, the rules are compared bytewise
+        _Data._Checksum                 = _Checksum;
+        _Data._Start                    = _Window.start;
+        _Data._End                      = _Window.end;
+        _Data._Days                     = _Window.days;
+        const byte_t* const _Bytes      = reinterpret_cast<const byte_t*>(&_Data);
+        return database_rule{rule_kind::schedule, ::std::vector<byte_t>(_Bytes, _Bytes + sizeof(_Data))};
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,81 @@
+// schedule.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_SCHEDULE_HPP_
+#define _DBMGR_SCHEDULE_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <dbmgr/database_rule.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    struct time_window { // weekly window in local time, minute resolution
+        uint8_t days; // bit n is set if the window opens on day n (0 is Sunday)
+        uint16_t start; // minute of the day the window opens at
+        uint16_t end; // minute of the day the window closes at (not greater than start if it spans midnight)
+    };
+
+    struct _Schedule_traits {
+        // Note: The time is measured in whole minutes of local time since January 1, 1601 (a Monday),
+        //       which is the FILETIME epoch. The schedule is evaluated only at the window boundaries,
+        //       never when a process is created.
+        static constexpr uint64_t _Minutes_per_day  = 1440;
+        static constexpr uint64_t _Ticks_per_minute = 600'000'000; // FILETIME ticks (100 ns)
+        static constexpr uint64_t _No_change        = UINT64_MAX;
+
+        struct _Record { // rule data
+            checksum_t _Checksum; // checksum of the application name
+            uint16_t _Start;
+            uint16_t _End;
+            uint8_t _Days;
+            uint8_t _Reserved[3]; // must be zero
+        };
+
+        static_assert(sizeof(_Record) == 16, "_Record must be 16 bytes long");
+
+        // returns the current local time (in FILETIME ticks)
+        static uint64_t _Get_local_time() noexcept;
+
+        // returns the day of the week of the minute (0 is Sunday)
+        static uint8_t _Day_of_week(const uint64_t _Minute) noexcept;
+
+        // parses the window in the "days@HH:MM-HH:MM" format, days are "daily", "weekdays", "weekends"
+        // or '+' separated days and day ranges (e.g. "mon-fri", "sat+sun", "mon+wed-fri")
+        [[nodiscard]] static bool _Parse(const unicode_string_view _Spec, time_window& _Window) noexcept;
+
+        // splits the "name@days@HH:MM-HH:MM" target into the name and the window, the name may contain '@'
+        [[nodiscard]] static bool _Split(
+            const unicode_string_view _Target, unicode_string_view& _Name, unicode_string_view& _Spec) noexcept;
+
+        // checks if the window is open at the selected minute
+        static bool _Is_active(const time_window& _Window, const uint64_t _Minute) noexcept;
+
+        // returns the first minute after the selected one at which the window opens or closes
+        static uint64_t _Next_change(const time_window& _Window, const uint64_t _Minute) noexcept;
+
+        // decodes the rule, fails if the rule isn't a valid schedule
+        [[nodiscard]] static bool _Decode(
+            const database_rule& _Rule, checksum_t& _Checksum, time_window& _Window) noexcept;
+
+        // parses the day name (e.g. "mon") and advances the iterator past it
+        [[nodiscard]] static bool _Parse_day(
+            const wchar_t*& _First, const wchar_t* const _Last, uint8_t& _Day) noexcept;
+
+        // parses the time in the "HH:MM" format and advances the iterator past it
+        [[nodiscard]] static bool _Parse_time(
+            const wchar_t*& _First, const wchar_t* const _Last, uint16_t& _Time) noexcept;
+
+        // skips the word if the iterator points to it, the word must be followed by '@'
+        static bool _Skip_word(
+            const wchar_t*& _First, const wchar_t* const _Last, const unicode_string_view _Word) noexcept;
+    };
+
+    // makes a rule that locks the application with the selected checksum within the window
+    database_rule make_schedule_rule(const checksum_t _Checksum, const time_window& _Window);
+} // namespace mjx
+
+#endif // _DBMGR_SCHEDULE_HPP_
\ No newline at end of file
@@ -3,23 +3,208 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
 #include <cstdio>
 #include <dbmgr/task.hpp>
+#include <dbmgr/aho_corasick.hpp>
+#include <dbmgr/audit_log.hpp>
 #include <dbmgr/database.hpp>
+#include <dbmgr/entry_list.hpp>
+#include <dbmgr/glob_dfa.hpp>
+#include <dbmgr/image_hash.hpp>
+#include <dbmgr/instance_limit.hpp>
+#include <dbmgr/membership_index.hpp>
+#include <dbmgr/path_trie.hpp>
+#include <dbmgr/respawn_stats.hpp>
+#include <dbmgr/schedule.hpp>
+#include <iterator>
 #include <mjmem/object_allocator.hpp>
+#include <mjstr/conversion.hpp>
 
 namespace mjx {
+    task_plan::task_plan() noexcept : _Mystates(), _Mybulk(), _Mycleared(false) {}
+
+    task_plan::~task_plan() noexcept {}
+
+    task_plan::_Entry_state& task_plan::_Resolve(const database_entry& _Entry) {
+        const auto _Iter = _Mystates.find(_Entry.checksum());
+        if (_Iter != _Mystates.end()) { // already resolved, don't touch the database again
+            return _Iter->second;
+        }
+
+        bool _Locked;
+        if (::std::binary_search(_Mybulk.begin(), _Mybulk.end(), _Entry)) {
+            _Locked = true;
+        } else if (_Mycleared) { // all previous entries were unlocked
+            _Locked = false;
+        } else {
+            _Locked = database::current().contains(_Entry);
+        }
+
+        return _Mystates.emplace(_Entry.checksum(), _Entry_state{_Locked, _Locked}).first->second;
+    }
+
+    void task_plan::_Reset() noexcept {
+        _Mystates.clear();
+        _Mybulk.clear();
+        _Mycleared = false;
+    }
+
+    bool task_plan::is_locked(const database_entry& _Entry) {
+        return _Resolve(_Entry)._Current;
+    }
+
+    void task_plan::lock(const database_entry& _Entry) {
+        _Resolve(_Entry)._Current = true;
+    }
+
+    void task_plan::unlock(const database_entry& _Entry) {
+        _Resolve(_Entry)._Current = false;
+    }
+
+    void task_plan::unlock_all() noexcept {
+        _Reset();
+        _Mycleared = true;
+    }
+
+    size_t task_plan::lock_all(::std::vector<database_entry>&& _Entries) {
+        ::std::sort(_Entries.begin(), _Entries.end());
+        _Entries.erase(::std::unique(_Entries.begin(), _Entries.end()), _Entries.end());
+        const size_t _Count = _Entries.size();
+        for (auto& _Pair : _Mystates) { // the new entries override previously planned changes
+            if (::std::binary_search(_Entries.begin(), _Entries.end(), database_entry{_Pair.first})) {
+                _Pair.second._Current = true;
+            }
+        }
+
+        if (_Mybulk.empty()) {
+            _Mybulk = ::std::move(_Entries);
+        } else {
+            const size_t _Old_size = _Mybulk.size();
+            _Mybulk.insert(_Mybulk.end(), _Entries.begin(), _Entries.end());
+            ::std::inplace_merge(_Mybulk.begin(), _Mybulk.begin() + _Old_size, _Mybulk.end());
+            _Mybulk.erase(::std::unique(_Mybulk.begin(), _Mybulk.end()), _Mybulk.end());
+        }
+
+        return _Count;
+    }
+
+    bool task_plan::_Keeps_entries(
+        const ::std::vector<database_entry>& _Locked, ::std::vector<database_entry>& _Unlocked) const {
+        ::std::sort(_Unlocked.begin(), _Unlocked.end());
+        for (const database_entry& _Entry : _Locked) {
+            if (!::std::binary_search(_Unlocked.begin(), _Unlocked.end(), _Entry)) { // stays locked
+                return true;
+            }
+        }
+
+        if (_Mycleared) { // no previous entry is kept
+            return false;
+        }
+
+        const database& _Db  = database::current();
+        const size_t _Erased = static_cast<size_t>(::std::count_if(_Unlocked.begin(), _Unlocked.end(),
+            [&_Db](const database_entry& _Entry) {
+                return _Db.contains(_Entry); // entries locked with lock_all() may not be stored yet
+            }));
+        return _Db.entry_count() > _Erased;
+    }
+
+    bool task_plan::commit() {
+        // Note: Entries that were locked and then unlocked (or vice versa) cancel each other out
+        //       and never reach the database. Entries unlocked after lock_all() must be erased
+        //       after the bulk entries are merged, because lock_all() overrides earlier changes.
+        //       An empty allow list would terminate every application the user starts, so changes
+        //       that would empty it are discarded as a whole and the database stays intact.
+        ::std::vector<database_entry> _Locked = ::std::move(_Mybulk);
+        ::std::vector<database_entry> _Unlocked;
+        for (const auto& _Pair : _Mystates) {
+            if (_Pair.second._Current != _Pair.second._Initial) {
+                if (_Pair.second._Current) {
+                    _Locked.push_back(database_entry{_Pair.first});
+                } else {
+                    _Unlocked.push_back(database_entry{_Pair.first});
+                }
+            }
+        }
+
+        if (_Mycleared || !_Locked.empty() || !_Unlocked.empty()) { // apply the changes
+            database& _Db = database::current();
+            if (_Db.get_enforcement_mode() == enforcement_mode::allow_list && !_Keeps_entries(_Locked, _Unlocked)) {
+                _Reset();
+                return false;
+            }
+
+            if (_Mycleared) {
+                _Db.clear();
+            }
+
+            if (!_Locked.empty()) {
+                _Db.merge(::std::move(_Locked));
+            }
+
+            if (!_Unlocked.empty()) {
+                _Db.erase(::std::move(_Unlocked));
+            }
+        }
+
+        _Reset();
+        return true;
+    }
+
+    const char* task_plan::error() const noexcept {
+        return "The allow list can't be emptied, select the deny mode first.";
+    }
+
+    bool task::modifies_database() const noexcept {
+        return true;
+    }
+
     help::help() noexcept {}
 
     help::~help() noexcept {}
 
-    bool help::execute() {
+    bool help::execute(task_plan&) {
         ::puts(
             "Usage:\n"
             "    --lock=name - Locks an application.\n"
             "    --unlock=name - Unlocks an application.\n"
+            "    --lock-image=file - Locks an executable by its content, so renaming it doesn't help.\n"
+            "    --unlock-image=file - Unlocks an executable locked by its content.\n"
+            "    --lock-path=file - Locks an executable by its full path.\n"
+            "    --unlock-path=file - Unlocks an executable locked by its full path.\n"
+            "    --lock-dir=directory - Locks all executables in a directory and its subdirectories.\n"
+            "    --unlock-dir=directory - Unlocks a directory locked with --lock-dir.\n"
+            "    --lock-glob=pattern - Locks all executables whose names match a pattern (* and ? wildcards).\n"
+            "    --unlock-glob=pattern - Unlocks a pattern locked with --lock-glob.\n"
+            "    --lock-cmdline=text - Locks all interpreters (python, node, powershell, ...) whose command lines\n"
+            "                          contain the text.\n"
+            "    --unlock-cmdline=text - Unlocks a text locked with --lock-cmdline.\n"
+            "    --lock-schedule=name@days@HH:MM-HH:MM - Locks an application within a weekly time window, days are\n"
+            "                                            daily, weekdays, weekends or days and ranges joined with +\n"
+            "                                            (e.g. Game.exe@mon-fri@09:00-17:00).\n"
+            "    --unlock-schedule=name@days@HH:MM-HH:MM - Unlocks a schedule locked with --lock-schedule.\n"
+            "    --limit-instances=name@count - Allows at most count running instances of an application, newer\n"
+            "                                   instances are terminated.\n"
+            "    --unlimit-instances=name - Removes the instance limit of an application.\n"
             "    --unlock-all - Unlocks all locked applications.\n"
-            "    --status=name - Checks if an application is locked."
+            "    --status=name - Checks if an application is locked.\n"
+            "    --import=file - Locks all applications listed in a file (one name per line).\n"
+            "    --export - Writes checksums of all locked applications to the standard output.\n"
+            "               The checksums can't be imported back, since --import expects names.\n"
+            "    --respawns - Shows how often the service terminates each application, the most terminated first,\n"
+            "                 and how deep its queues have grown.\n"
+            "    --query-log[=query] - Shows the terminations recorded by the service, the oldest first. The query\n"
+            "                          joins filters with commas: since:date, until:date (YYYY-MM-DD[THH:MM],\n"
+            "                          local time), outcome:terminated|exited|failed and app:name (must be last).\n"
+            "    --calibrate - Measures the lookup thresholds on this machine, the service uses them after a restart.\n"
+            "    --checksum-mode=mode - Selects how names are hashed (exact or case-insensitive).\n"
+            "                           The mode can be changed only if no application is locked.\n"
+            "    --checksum-width=bits - Selects the checksum width (32 or 64 bits).\n"
+            "                            The width can be changed only if no application is locked.\n"
+            "    --enforcement-mode=mode - Selects what happens to the listed applications (deny or allow).\n"
+            "                              In the allow mode, only the listed applications and essential\n"
+            "                              system processes may run, the rules still lock the matching ones."
         );
         return true;
     }
@@ -28,23 +213,23 @@ namespace mjx {
         return nullptr; // error never occurs
     }
 
+    bool help::modifies_database() const noexcept {
+        return false;
+    }
+
     lock::lock(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
 
     lock::~lock() noexcept {}
 
-    bool lock::execute() {
-        database& _Db = database::current();
-        if (_Db.has_entry(_Mytarget)) {
+    bool lock::execute(task_plan& _Plan) {
+        const database_entry _Entry = database::current().make_entry(_Mytarget);
+        if (_Plan.is_locked(_Entry)) {
             _Myerror = "The application is already locked.";
             return false;
         }
 
-        if (_Db.append(_Mytarget)) {
-            return true;
-        } else {
-            _Myerror = "Failed to lock the application, try again.";
-            return false;
-        }
+        _Plan.lock(_Entry);
+        return true;
     }
 
     const char* lock::error() const noexcept {
@@ -55,22 +240,386 @@ namespace mjx {
 
     unlock::~unlock() noexcept {}
 
-    bool unlock::execute() {
-        database& _Db = database::current();
-        if (!_Db.has_entry(_Mytarget)) {
+    bool unlock::execute(task_plan& _Plan) {
+        const database_entry _Entry = database::current().make_entry(_Mytarget);
+        if (!_Plan.is_locked(_Entry)) {
             _Myerror = "The application is not locked.";
             return false;
         }
 
-        if (_Db.erase(_Mytarget)) {
-            return true;
-        } else {
-            _Myerror = "Failed to unlock the application, try again.";
+        _Plan.unlock(_Entry);
+        return true;
+    }
+
+    const char* unlock::error() const noexcept {
+        return _Myerror;
+    }
+
+    lock_image::lock_image(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    lock_image::~lock_image() noexcept {}
+
+    bool lock_image::execute(task_plan& _Plan) {
+        image_hash _Hash;
+        if (!::mjx::compute_image_hash(path{_Mytarget}, _Hash)) {
+            _Myerror = "Failed to hash the executable.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        if (!database::current().append_rule(::mjx::make_image_hash_rule(_Hash))) {
+            _Myerror = "The executable is already locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* lock_image::error() const noexcept {
+        return _Myerror;
+    }
+
+    unlock_image::unlock_image(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    unlock_image::~unlock_image() noexcept {}
+
+    bool unlock_image::execute(task_plan& _Plan) {
+        image_hash _Hash;
+        if (!::mjx::compute_image_hash(path{_Mytarget}, _Hash)) {
+            _Myerror = "Failed to hash the executable.";
             return false;
         }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        if (!database::current().erase_rule(::mjx::make_image_hash_rule(_Hash))) {
+            _Myerror = "The executable is not locked.";
+            return false;
+        }
+
+        return true;
     }
 
-    const char* unlock::error() const noexcept {
+    const char* unlock_image::error() const noexcept {
+        return _Myerror;
+    }
+
+    lock_path::lock_path(const unicode_string_view _Target, const rule_kind _Kind) noexcept
+        : _Mytarget(_Target), _Mykind(_Kind), _Myerror(nullptr) {}
+
+    lock_path::~lock_path() noexcept {}
+
+    bool lock_path::execute(task_plan& _Plan) {
+        path _Path(_Mytarget);
+        if (_Path.is_relative()) { // the service doesn't share the working directory, store the absolute path
+            _Path = ::mjx::current_path() / _Path;
+        }
+
+        path::string_type _Normalized;
+        if (!_Path_trie_traits::_Normalize(_Path, _Normalized)) {
+            _Myerror = "Invalid path.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        if (!database::current().append_rule(::mjx::make_path_rule(_Mykind, _Normalized))) {
+            _Myerror = "The path is already locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* lock_path::error() const noexcept {
+        return _Myerror;
+    }
+
+    unlock_path::unlock_path(const unicode_string_view _Target, const rule_kind _Kind) noexcept
+        : _Mytarget(_Target), _Mykind(_Kind), _Myerror(nullptr) {}
+
+    unlock_path::~unlock_path() noexcept {}
+
+    bool unlock_path::execute(task_plan& _Plan) {
+        path _Path(_Mytarget);
+        if (_Path.is_relative()) { // must match the path stored by lock_path
+            _Path = ::mjx::current_path() / _Path;
+        }
+
+        path::string_type _Normalized;
+        if (!_Path_trie_traits::_Normalize(_Path, _Normalized)) {
+            _Myerror = "Invalid path.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        if (!database::current().erase_rule(::mjx::make_path_rule(_Mykind, _Normalized))) {
+            _Myerror = "The path is not locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* unlock_path::error() const noexcept {
+        return _Myerror;
+    }
+
+    lock_glob::lock_glob(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    lock_glob::~lock_glob() noexcept {}
+
+    bool lock_glob::execute(task_plan& _Plan) {
+        if (!_Glob_dfa_traits::_Is_valid_pattern(_Mytarget)) {
+            _Myerror = "Invalid pattern.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        const unicode_string _Normalized = _Glob_dfa_traits::_Normalize(_Mytarget);
+        if (!database::current().append_rule(::mjx::make_glob_rule(_Normalized))) {
+            _Myerror = "The pattern is already locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* lock_glob::error() const noexcept {
+        return _Myerror;
+    }
+
+    unlock_glob::unlock_glob(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    unlock_glob::~unlock_glob() noexcept {}
+
+    bool unlock_glob::execute(task_plan& _Plan) {
+        if (!_Glob_dfa_traits::_Is_valid_pattern(_Mytarget)) {
+            _Myerror = "Invalid pattern.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        const unicode_string _Normalized = _Glob_dfa_traits::_Normalize(_Mytarget);
+        if (!database::current().erase_rule(::mjx::make_glob_rule(_Normalized))) {
+            _Myerror = "The pattern is not locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* unlock_glob::error() const noexcept {
+        return _Myerror;
+    }
+
+    lock_command_line::lock_command_line(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    lock_command_line::~lock_command_line() noexcept {}
+
+    bool lock_command_line::execute(task_plan& _Plan) {
+        if (!_Aho_corasick_traits::_Is_valid_pattern(_Mytarget)) {
+            _Myerror = "Invalid text.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        const unicode_string _Normalized = _Aho_corasick_traits::_Normalize(_Mytarget);
+        if (!database::current().append_rule(::mjx::make_command_line_rule(_Normalized))) {
+            _Myerror = "The text is already locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* lock_command_line::error() const noexcept {
+        return _Myerror;
+    }
+
+    unlock_command_line::unlock_command_line(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    unlock_command_line::~unlock_command_line() noexcept {}
+
+    bool unlock_command_line::execute(task_plan& _Plan) {
+        if (!_Aho_corasick_traits::_Is_valid_pattern(_Mytarget)) {
+            _Myerror = "Invalid text.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        const unicode_string _Normalized = _Aho_corasick_traits::_Normalize(_Mytarget);
+        if (!database::current().erase_rule(::mjx::make_command_line_rule(_Normalized))) {
+            _Myerror = "The text is not locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* unlock_command_line::error() const noexcept {
+        return _Myerror;
+    }
+
+    lock_schedule::lock_schedule(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    lock_schedule::~lock_schedule() noexcept {}
+
+    bool lock_schedule::execute(task_plan& _Plan) {
+        unicode_string_view _Name;
+        unicode_string_view _Spec;
+        time_window _Window;
+        if (!_Schedule_traits::_Split(_Mytarget, _Name, _Spec) || !_Schedule_traits::_Parse(_Spec, _Window)) {
+            _Myerror = "Invalid schedule.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db = database::current();
+        if (!_Db.append_rule(::mjx::make_schedule_rule(_Db.make_entry(_Name).checksum(), _Window))) {
+            _Myerror = "The schedule is already locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* lock_schedule::error() const noexcept {
+        return _Myerror;
+    }
+
+    unlock_schedule::unlock_schedule(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    unlock_schedule::~unlock_schedule() noexcept {}
+
+    bool unlock_schedule::execute(task_plan& _Plan) {
+        unicode_string_view _Name;
+        unicode_string_view _Spec;
+        time_window _Window;
+        if (!_Schedule_traits::_Split(_Mytarget, _Name, _Spec) || !_Schedule_traits::_Parse(_Spec, _Window)) {
+            _Myerror = "Invalid schedule.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db = database::current();
+        if (!_Db.erase_rule(::mjx::make_schedule_rule(_Db.make_entry(_Name).checksum(), _Window))) {
+            _Myerror = "The schedule is not locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* unlock_schedule::error() const noexcept {
+        return _Myerror;
+    }
+
+    limit_instances::limit_instances(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    limit_instances::~limit_instances() noexcept {}
+
+    bool limit_instances::execute(task_plan& _Plan) {
+        unicode_string_view _Name;
+        instance_limit _Limit;
+        if (!_Instance_limit_traits::_Parse(_Mytarget, _Name, _Limit.limit)) {
+            _Myerror = "Invalid limit.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db   = database::current();
+        _Limit.checksum = _Db.make_entry(_Name).checksum();
+        instance_limit _Old;
+        if (_Instance_limit_traits::_Find(_Db.get_rules(), _Limit.checksum, _Old)) { // replace the previous limit
+            if (_Old.limit == _Limit.limit || !_Db.erase_rule(::mjx::make_instance_limit_rule(_Old))) {
+                _Myerror = "The limit is already set.";
+                return false;
+            }
+        }
+
+        if (!_Db.append_rule(::mjx::make_instance_limit_rule(_Limit))) {
+            _Myerror = "The limit is already set.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* limit_instances::error() const noexcept {
+        return _Myerror;
+    }
+
+    unlimit_instances::unlimit_instances(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    unlimit_instances::~unlimit_instances() noexcept {}
+
+    bool unlimit_instances::execute(task_plan& _Plan) {
+        if (!_Plan.commit()) { // rules aren't planned, apply changes planned by the previous tasks first
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db = database::current();
+        instance_limit _Limit;
+        if (!_Instance_limit_traits::_Find(_Db.get_rules(), _Db.make_entry(_Mytarget).checksum(), _Limit)
+            || !_Db.erase_rule(::mjx::make_instance_limit_rule(_Limit))) {
+            _Myerror = "The application has no instance limit.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* unlimit_instances::error() const noexcept {
         return _Myerror;
     }
 
@@ -78,8 +627,8 @@ namespace mjx {
 
     unlock_all::~unlock_all() noexcept {}
 
-    bool unlock_all::execute() {
-        database::current().clear();
+    bool unlock_all::execute(task_plan& _Plan) {
+        _Plan.unlock_all();
         return true;
     }
 
@@ -87,22 +636,353 @@ namespace mjx {
         return nullptr; // error never occurs
     }
 
-    status::status(const unicode_string_view _Target) noexcept : _Mytarget(_Target) {}
+    status::status(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
 
     status::~status() noexcept {}
 
-    bool status::execute() {
-        if (database::current().has_entry(_Mytarget)) {
-            ::puts("[STATUS]: The application is locked.");
-        } else {
-            ::puts("[STATUS]: The application is not locked.");
+    bool status::execute(task_plan& _Plan) {
+        // Note: The entry is resolved once per plan, so repeated statuses of the same application don't
+        //       touch the database again. Each of them is still reported, since it may follow a change.
+        if (!database::current().is_valid()) { // an invalid file is read as empty, don't report the entry as unlocked
+            _Myerror = "apps.db is invalid or from a newer version, it can't be checked.";
+            return false;
         }
 
+        const database_entry _Entry = database::current().make_entry(_Mytarget);
+        const utf8_string _Name     = ::mjx::to_utf8_string(_Mytarget);
+        ::printf(_Plan.is_locked(_Entry) ? "[STATUS]: %s is locked.\n" : "[STATUS]: %s is not locked.\n",
+            _Name.c_str());
         return true;
     }
 
     const char* status::error() const noexcept {
-        return nullptr; // error never occurs
+        return _Myerror;
+    }
+
+    bool status::modifies_database() const noexcept {
+        return false;
+    }
+
+    import_list::import_list(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    import_list::~import_list() noexcept {}
+
+    bool import_list::execute(task_plan& _Plan) {
+        ::std::vector<database_entry> _Entries;
+        size_t _Skipped;
+        if (!::mjx::import_entry_list(
+            path{_Mytarget}, database::current().get_checksum_mode(), _Entries, _Skipped)) {
+            _Myerror = "Failed to read the import file.";
+            return false;
+        }
+
+        if (_Skipped > 0) {
+            ::printf("[IMPORT]: %zu line(s) skipped, the names are longer than %zu characters or not valid UTF-8.\n",
+                _Skipped, _Entry_list_traits::_Max_name_length);
+        }
+
+        const size_t _Count = _Plan.lock_all(::std::move(_Entries));
+        ::printf("[IMPORT]: %zu application(s) locked.\n", _Count);
+        return true;
+    }
+
+    const char* import_list::error() const noexcept {
+        return _Myerror;
+    }
+
+    export_list::export_list() noexcept : _Myerror(nullptr) {}
+
+    export_list::~export_list() noexcept {}
+
+    bool export_list::execute(task_plan& _Plan) {
+        if (!_Plan.commit()) { // export must include changes planned by the previous tasks
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        // Note: Entries are formatted into a large buffer and written in big chunks,
+        //       since calling printf() for each entry is too slow for large databases.
+        static constexpr size_t _Buf_size = 17 * 4096; // up to 16 hex digits and LF per line
+        static constexpr char _Digits[]   = "0123456789ABCDEF";
+        const database& _Db               = database::current();
+        const size_t _Digit_count         = _Has_bits(_Db.get_checksum_mode(), checksum_mode::wide) ? 16 : 8;
+        const size_t _Line_size           = _Digit_count + 1;
+        char _Buf[_Buf_size];
+        size_t _Off = 0;
+        checksum_t _Val;
+        for (const database_entry& _Entry : _Db.get_entries()) {
+            _Val = _Entry.checksum();
+            for (size_t _Idx = _Digit_count; _Idx > 0; --_Idx) {
+                _Buf[_Off + _Idx - 1] = _Digits[_Val & 0xF];
+                _Val                >>= 4;
+            }
+
+            _Buf[_Off + _Digit_count] = '\n';
+            _Off                     += _Line_size;
+            if (_Off + _Line_size > _Buf_size) { // buffer full, flush it
+                ::fwrite(_Buf, 1, _Off, stdout);
+                _Off = 0;
+            }
+        }
+
+        if (_Off > 0) {
+            ::fwrite(_Buf, 1, _Off, stdout);
+        }
+
+        return true;
+    }
+
+    const char* export_list::error() const noexcept {
+        return _Myerror;
+    }
+
+    bool export_list::modifies_database() const noexcept {
+        return false;
+    }
+
+    respawn_report::respawn_report() noexcept : _Myerror(nullptr) {}
+
+    respawn_report::~respawn_report() noexcept {}
+
+    bool respawn_report::execute(task_plan&) {
+        // Note: The statistics are written by the service once a minute, so they may be slightly behind.
+        ::std::vector<respawn_record> _Records;
+        service_counters _Counters;
+        if (!::mjx::load_respawn_stats(_Records, _Counters)) {
+            _Myerror = "The service hasn't reported any statistics yet.";
+            return false;
+        }
+
+        ::std::sort(_Records.begin(), _Records.end(),
+            [](const respawn_record& _Left, const respawn_record& _Right) noexcept {
+                return _Left.kills > _Right.kills;
+            });
+        const int _Digit_count = _Has_bits(database::current().get_checksum_mode(), checksum_mode::wide) ? 16 : 8;
+        for (const respawn_record& _Record : _Records) {
+            ::printf("[RESPAWN]: %0*llX - %u termination(s), %.1f per minute%s\n", _Digit_count,
+                static_cast<unsigned long long>(_Record.checksum), _Record.kills, ::mjx::respawn_rate(_Record),
+                _Record.hot != 0 ? ", terminated on sight" : "");
+        }
+
+        ::printf("[PIPELINE]: matching queue - %u process(es) at most, full %llu time(s)\n",
+            _Counters.ingest_peak, static_cast<unsigned long long>(_Counters.ingest_overflows));
+        ::printf("[PIPELINE]: enforcement queue - %u process(es) at most, full %llu time(s)\n",
+            _Counters.enforce_peak, static_cast<unsigned long long>(_Counters.enforce_overflows));
+        ::printf("[PIPELINE]: audit queue - %llu record(s) dropped\n",
+            static_cast<unsigned long long>(_Counters.audit_drops));
+        return true;
+    }
+
+    const char* respawn_report::error() const noexcept {
+        return _Myerror;
+    }
+
+    bool respawn_report::modifies_database() const noexcept {
+        return false;
+    }
+
+    query_log::query_log(const unicode_string_view _Target) noexcept : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    query_log::~query_log() noexcept {}
+
+    bool query_log::execute(task_plan&) {
+        // Note: The records are written by the service every few seconds, so the latest ones may be missing.
+        static constexpr const char* _Reasons[]  = {"unknown", "checksum", "path", "name", "command line", "image",
+            "respawn", "instance limit", "descendant"};
+        static constexpr const char* _Outcomes[] = {"unknown", "terminated", "exited", "failed"};
+        static_assert(::std::size(_Reasons) == static_cast<size_t>(audit_reason::descendant) + 1,
+            "_Reasons must name every audit_reason");
+        static_assert(::std::size(_Outcomes) == static_cast<size_t>(audit_outcome::failed) + 1,
+            "_Outcomes must name every audit_outcome");
+        audit_query _Query;
+        unicode_string_view _Name;
+        if (!_Audit_log_traits::_Parse_query(_Mytarget, _Query, _Name)) {
+            _Myerror = "Invalid query.";
+            return false;
+        }
+
+        const database& _Db = database::current();
+        if (!_Name.empty()) {
+            _Query.checksum = _Db.make_entry(_Name).checksum();
+        }
+
+        ::std::vector<audit_record> _Records;
+        if (!::mjx::query_audit_log(_Query, _Records)) {
+            _Myerror = "The service hasn't recorded any termination yet.";
+            return false;
+        }
+
+        const int _Digit_count = _Has_bits(_Db.get_checksum_mode(), checksum_mode::wide) ? 16 : 8;
+        uint64_t _Time;
+        uint32_t _Year;
+        uint32_t _Month;
+        uint32_t _Day;
+        uint32_t _Seconds;
+        uint8_t _Reason;
+        uint8_t _Outcome;
+        for (const audit_record& _Record : _Records) {
+            _Time = _Audit_log_traits::_To_local_time(_Record.time);
+            _Audit_log_traits::_Split_day(_Time / _Audit_log_traits::_Ticks_per_day, _Year, _Month, _Day);
+            _Seconds = static_cast<uint32_t>(_Time % _Audit_log_traits::_Ticks_per_day / 10'000'000);
+            _Reason  = static_cast<uint8_t>(_Record.reason);
+            _Outcome = static_cast<uint8_t>(_Record.outcome);
+            if (_Reason >= ::std::size(_Reasons)) { // written by a newer service, print as unknown
+                _Reason = 0;
+            }
+
+            if (_Outcome >= ::std::size(_Outcomes)) { // written by a newer service, print as unknown
+                _Outcome = 0;
+            }
+
+            ::printf("[LOG]: %04u-%02u-%02u %02u:%02u:%02u - PID %u - %0*llX - %s - %s\n", _Year, _Month, _Day,
+                _Seconds / 3600, _Seconds / 60 % 60, _Seconds % 60, _Record.pid, _Digit_count,
+                static_cast<unsigned long long>(_Record.checksum), _Reasons[_Reason], _Outcomes[_Outcome]);
+        }
+
+        ::printf("[LOG]: %zu termination(s) found.\n", _Records.size());
+        return true;
+    }
+
+    const char* query_log::error() const noexcept {
+        return _Myerror;
+    }
+
+    bool query_log::modifies_database() const noexcept {
+        return false;
+    }
+
+    calibrate::calibrate() noexcept : _Myerror(nullptr) {}
+
+    calibrate::~calibrate() noexcept {}
+
+    bool calibrate::execute(task_plan&) {
+        // Note: The thresholds are read once by each process, so the service uses the new ones
+        //       only after it's restarted.
+        const membership_thresholds _Thresholds = membership_thresholds::calibrate();
+        if (!_Thresholds.save()) {
+            _Myerror = "Failed to save the thresholds.";
+            return false;
+        }
+
+        ::printf("[CALIBRATE]: Linear scan up to %zu entries, binary search up to %zu entries, perfect hash above.\n"
+            "[CALIBRATE]: Restart the service to apply the thresholds.\n", _Thresholds.linear_max,
+            _Thresholds.sorted_max);
+        return true;
+    }
+
+    const char* calibrate::error() const noexcept {
+        return _Myerror;
+    }
+
+    bool calibrate::modifies_database() const noexcept {
+        return false;
+    }
+
+    set_checksum_mode::set_checksum_mode(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    set_checksum_mode::~set_checksum_mode() noexcept {}
+
+    bool set_checksum_mode::execute(task_plan& _Plan) {
+        checksum_mode _Mode;
+        if (_Mytarget == L"exact") {
+            _Mode = checksum_mode::exact;
+        } else if (_Mytarget == L"case-insensitive") {
+            _Mode = checksum_mode::case_insensitive;
+        } else {
+            _Myerror = "Unknown checksum mode.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // the database must be checked after changes planned by the previous tasks
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db = database::current();
+        if (!_Db.set_checksum_mode((_Db.get_checksum_mode() & checksum_mode::wide) | _Mode)) { // keep the width
+            _Myerror = "The checksum mode can be changed only if no application is locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* set_checksum_mode::error() const noexcept {
+        return _Myerror;
+    }
+
+    set_checksum_width::set_checksum_width(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    set_checksum_width::~set_checksum_width() noexcept {}
+
+    bool set_checksum_width::execute(task_plan& _Plan) {
+        checksum_mode _Width;
+        if (_Mytarget == L"32") {
+            _Width = checksum_mode::exact;
+        } else if (_Mytarget == L"64") {
+            _Width = checksum_mode::wide;
+        } else {
+            _Myerror = "Unknown checksum width.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // the database must be checked after changes planned by the previous tasks
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db = database::current();
+        if (!_Db.set_checksum_mode( // keep the case sensitivity
+            (_Db.get_checksum_mode() & checksum_mode::case_insensitive) | _Width)) {
+            _Myerror = "The checksum width can be changed only if no application is locked.";
+            return false;
+        }
+
+        return true;
+    }
+
+    const char* set_checksum_width::error() const noexcept {
+        return _Myerror;
+    }
+
+    set_enforcement_mode::set_enforcement_mode(const unicode_string_view _Target) noexcept
+        : _Mytarget(_Target), _Myerror(nullptr) {}
+
+    set_enforcement_mode::~set_enforcement_mode() noexcept {}
+
+    bool set_enforcement_mode::execute(task_plan& _Plan) {
+        enforcement_mode _Mode;
+        if (_Mytarget == L"deny") {
+            _Mode = enforcement_mode::deny_list;
+        } else if (_Mytarget == L"allow") {
+            _Mode = enforcement_mode::allow_list;
+        } else {
+            _Myerror = "Unknown enforcement mode.";
+            return false;
+        }
+
+        if (!_Plan.commit()) { // the database must be checked after changes planned by the previous tasks
+            _Myerror = _Plan.error();
+            return false;
+        }
+
+        database& _Db = database::current();
+        if (_Mode == enforcement_mode::allow_list && _Db.get_entries().empty()) {
+            // Note: An empty allow list would terminate every application the user starts,
+            //       so at least one application must be listed first.
+            _Myerror = "The allow mode can be selected only if at least one application is listed.";
+            return false;
+        }
+
+        _Db.set_enforcement_mode(_Mode);
+        return true;
+    }
+
+    const char* set_enforcement_mode::error() const noexcept {
+        return _Myerror;
     }
 
     [[nodiscard]] task* make_task(const wchar_t* const _Arg) {
@@ -113,13 +993,53 @@ namespace mjx {
                 return nullptr;
             }
 
-            const unicode_string_view _Target = _Arg + _Eq_pos + 1;
-            if (_As_view.contains(L"--lock")) {
+            // Note: The command must match exactly, since some commands are prefixes of the others.
+            const unicode_string_view _Command = _As_view.substr(0, _Eq_pos);
+            const unicode_string_view _Target  = _Arg + _Eq_pos + 1;
+            if (_Command == L"--lock") {
                 return ::mjx::create_object<lock>(_Target);
-            } else if (_As_view.contains(L"--unlock")) {
+            } else if (_Command == L"--unlock") {
                 return ::mjx::create_object<unlock>(_Target);
-            } else if (_As_view.contains(L"--status")) {
+            } else if (_Command == L"--lock-image") {
+                return ::mjx::create_object<lock_image>(_Target);
+            } else if (_Command == L"--unlock-image") {
+                return ::mjx::create_object<unlock_image>(_Target);
+            } else if (_Command == L"--lock-path") {
+                return ::mjx::create_object<lock_path>(_Target, rule_kind::full_path);
+            } else if (_Command == L"--unlock-path") {
+                return ::mjx::create_object<unlock_path>(_Target, rule_kind::full_path);
+            } else if (_Command == L"--lock-dir") {
+                return ::mjx::create_object<lock_path>(_Target, rule_kind::directory);
+            } else if (_Command == L"--unlock-dir") {
+                return ::mjx::create_object<unlock_path>(_Target, rule_kind::directory);
+            } else if (_Command == L"--lock-glob") {
+                return ::mjx::create_object<lock_glob>(_Target);
+            } else if (_Command == L"--unlock-glob") {
+                return ::mjx::create_object<unlock_glob>(_Target);
+            } else if (_Command == L"--lock-cmdline") {
+                return ::mjx::create_object<lock_command_line>(_Target);
+            } else if (_Command == L"--unlock-cmdline") {
+                return ::mjx::create_object<unlock_command_line>(_Target);
+            } else if (_Command == L"--lock-schedule") {
+                return ::mjx::create_object<lock_schedule>(_Target);
+            } else if (_Command == L"--unlock-schedule") {
+                return ::mjx::create_object<unlock_schedule>(_Target);
+            } else if (_Command == L"--limit-instances") {
+                return ::mjx::create_object<limit_instances>(_Target);
+            } else if (_Command == L"--unlimit-instances") {
+                return ::mjx::create_object<unlimit_instances>(_Target);
+            } else if (_Command == L"--status") {
                 return ::mjx::create_object<status>(_Target);
+            } else if (_Command == L"--import") {
+                return ::mjx::create_object<import_list>(_Target);
+            } else if (_Command == L"--query-log") {
+                return ::mjx::create_object<query_log>(_Target);
+            } else if (_Command == L"--checksum-mode") {
+                return ::mjx::create_object<set_checksum_mode>(_Target);
+            } else if (_Command == L"--checksum-width") {
+                return ::mjx::create_object<set_checksum_width>(_Target);
+            } else if (_Command == L"--enforcement-mode") {
+                return ::mjx::create_object<set_enforcement_mode>(_Target);
             } else { // unknown command
                 return nullptr;
             }
@@ -128,6 +1048,14 @@ namespace mjx {
                 return ::mjx::create_object<help>();
             } else if (_As_view == L"--unlock-all") {
                 return ::mjx::create_object<unlock_all>();
+            } else if (_As_view == L"--export") {
+                return ::mjx::create_object<export_list>();
+            } else if (_As_view == L"--respawns") {
+                return ::mjx::create_object<respawn_report>();
+            } else if (_As_view == L"--query-log") {
+                return ::mjx::create_object<query_log>(unicode_string_view{});
+            } else if (_As_view == L"--calibrate") {
+                return ::mjx::create_object<calibrate>();
             } else { // unknown command
                 return nullptr;
             }
@@ -142,8 +1070,8 @@ namespace mjx {
         _Mytask.reset(_Task);
     }
 
-    bool task_executor::execute() {
-        return _Mytask ? _Mytask->execute() : false;
+    bool task_executor::execute(task_plan& _Plan) {
+        return _Mytask ? _Mytask->execute(_Plan) : false;
     }
 
     const char* task_executor::error() const noexcept {
@@ -167,7 +1095,7 @@ namespace mjx {
 
     [[nodiscard]] task* task_queue::_Pop() noexcept {
         task* const _Task = _Mytasks.front();
-        _Mytasks.erase(_Mytasks.begin());
+        _Mytasks.pop_front();
         return _Task;
     }
 
@@ -176,16 +1104,40 @@ namespace mjx {
     }
 
     bool task_queue::execute() {
+        // Note: Tasks don't modify the database directly. Instead, they record their changes
+        //       in the plan, which is applied once all tasks are executed. If any task fails,
+        //       the changes made by the previous tasks are still applied, unless they would empty
+        //       the allow list. If the database file can't be loaded, the tasks that would modify
+        //       it fail before any task is executed.
+        for (task* const _Task : _Mytasks) {
+            if (_Task->modifies_database()) { // an invalid file must stay intact, don't start any task
+                if (!database::current().is_valid()) {
+                    _Myerror = "apps.db is invalid or from a newer version, it can't be modified.";
+                    return false;
+                }
+
+                break;
+            }
+        }
+
+        task_plan _Plan;
         task_executor _Executor;
+        bool _Result = true;
         while (!_Mytasks.empty()) {
             _Executor.bind_task(_Pop());
-            if (!_Executor.execute()) {
+            if (!_Executor.execute(_Plan)) {
                 _Myerror = _Executor.error();
-                return false;
+                _Result  = false;
+                break;
             }
         }
 
-        return true;
+        if (!_Plan.commit()) { // the changes planned by the previous tasks are discarded
+            _Myerror = _Plan.error();
+            _Result  = false;
+        }
+
+        return _Result;
     }
 
     const char* task_queue::error() const noexcept {
@@ -6,15 +6,71 @@
 #pragma once
 #ifndef _DBMGR_TASK_HPP_
 #define _DBMGR_TASK_HPP_
+#include <dbmgr/database.hpp>
+#include <deque>
 #include <mjmem/smart_pointer.hpp>
 #include <mjstr/string_view.hpp>
+#include <unordered_map>
 #include <vector>
 
 namespace mjx {
+    class task_plan { // collects database changes, so that they can be applied as one batch
+    public:
+        task_plan() noexcept;
+        ~task_plan() noexcept;
+
+        task_plan(const task_plan&)            = delete;
+        task_plan& operator=(const task_plan&) = delete;
+
+        // checks if the entry is locked (includes planned changes)
+        bool is_locked(const database_entry& _Entry);
+
+        // plans locking the entry
+        void lock(const database_entry& _Entry);
+
+        // plans unlocking the entry
+        void unlock(const database_entry& _Entry);
+
+        // plans unlocking all entries
+        void unlock_all() noexcept;
+
+        // plans locking all the entries, returns the number of unique entries
+        size_t lock_all(::std::vector<database_entry>&& _Entries);
+
+        // applies all planned changes to the database, discards them if they would empty the allow list
+        [[nodiscard]] bool commit();
+
+        // returns the reason why the changes were discarded
+        const char* error() const noexcept;
+
+    private:
+        struct _Entry_state {
+            bool _Initial; // state before any planned change
+            bool _Current; // state after all planned changes
+        };
+
+        // returns the state of the entry, resolves it if necessary
+        _Entry_state& _Resolve(const database_entry& _Entry);
+
+        // checks if at least one entry stays locked after the changes (sorts the unlocked entries)
+        bool _Keeps_entries(
+            const ::std::vector<database_entry>& _Locked, ::std::vector<database_entry>& _Unlocked) const;
+
+        // resets the plan
+        void _Reset() noexcept;
+
+        ::std::unordered_map<checksum_t, _Entry_state> _Mystates;
+        ::std::vector<database_entry> _Mybulk; // sorted entries locked with lock_all()
+        bool _Mycleared; // true if all entries were unlocked
+    };
+
     class __declspec(novtable) task { // base class for all tasks
     public:
-        virtual bool execute()                     = 0;
+        virtual bool execute(task_plan& _Plan)     = 0;
         virtual const char* error() const noexcept = 0;
+
+        // checks if the task may modify the database (most tasks do)
+        virtual bool modifies_database() const noexcept;
     };
 
     class help : public task {
@@ -23,10 +79,13 @@ namespace mjx {
         ~help() noexcept;
 
         // shows the application usage
-        bool execute() override;
+        bool execute(task_plan& _Plan) override;
 
         // returns an error (never occurs)
         const char* error() const noexcept override;
+
+        // checks if the task may modify the database (never)
+        bool modifies_database() const noexcept override;
     };
 
     class lock : public task {
@@ -35,7 +94,7 @@ namespace mjx {
         ~lock() noexcept;
 
         // locks the specified application
-        bool execute() override;
+        bool execute(task_plan& _Plan) override;
 
         // returns an error
         const char* error() const noexcept override;
@@ -51,7 +110,7 @@ namespace mjx {
         ~unlock() noexcept;
 
         // unlocks the specified application
-        bool execute() override;
+        bool execute(task_plan& _Plan) override;
         
         // returns an error
         const char* error() const noexcept override;
@@ -61,13 +120,207 @@ namespace mjx {
         const char* _Myerror;
     };
 
+    class lock_image : public task {
+    public:
+        explicit lock_image(const unicode_string_view _Target) noexcept;
+        ~lock_image() noexcept;
+
+        // locks the specified executable by its content, regardless of its name
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class unlock_image : public task {
+    public:
+        explicit unlock_image(const unicode_string_view _Target) noexcept;
+        ~unlock_image() noexcept;
+
+        // unlocks the specified executable locked by its content
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class lock_path : public task {
+    public:
+        lock_path(const unicode_string_view _Target, const rule_kind _Kind) noexcept;
+        ~lock_path() noexcept;
+
+        // locks the specified executable or all executables in the specified directory
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        rule_kind _Mykind; // either full_path or directory
+        const char* _Myerror;
+    };
+
+    class unlock_path : public task {
+    public:
+        unlock_path(const unicode_string_view _Target, const rule_kind _Kind) noexcept;
+        ~unlock_path() noexcept;
+
+        // unlocks the specified executable or directory locked by its path
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        rule_kind _Mykind; // either full_path or directory
+        const char* _Myerror;
+    };
+
+    class lock_glob : public task {
+    public:
+        explicit lock_glob(const unicode_string_view _Target) noexcept;
+        ~lock_glob() noexcept;
+
+        // locks all executables whose names match the specified wildcard pattern
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class unlock_glob : public task {
+    public:
+        explicit unlock_glob(const unicode_string_view _Target) noexcept;
+        ~unlock_glob() noexcept;
+
+        // unlocks the specified wildcard pattern
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class lock_command_line : public task {
+    public:
+        explicit lock_command_line(const unicode_string_view _Target) noexcept;
+        ~lock_command_line() noexcept;
+
+        // locks all interpreters whose command lines contain the specified substring
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class unlock_command_line : public task {
+    public:
+        explicit unlock_command_line(const unicode_string_view _Target) noexcept;
+        ~unlock_command_line() noexcept;
+
+        // unlocks the specified command line substring
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class lock_schedule : public task {
+    public:
+        explicit lock_schedule(const unicode_string_view _Target) noexcept;
+        ~lock_schedule() noexcept;
+
+        // locks an application within the specified weekly time window
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class unlock_schedule : public task {
+    public:
+        explicit unlock_schedule(const unicode_string_view _Target) noexcept;
+        ~unlock_schedule() noexcept;
+
+        // unlocks an application locked within the specified weekly time window
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class limit_instances : public task {
+    public:
+        explicit limit_instances(const unicode_string_view _Target) noexcept;
+        ~limit_instances() noexcept;
+
+        // limits the number of running instances of an application (replaces the previous limit)
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class unlimit_instances : public task {
+    public:
+        explicit unlimit_instances(const unicode_string_view _Target) noexcept;
+        ~unlimit_instances() noexcept;
+
+        // removes the instance limit of an application
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
     class unlock_all : public task {
     public:
         unlock_all() noexcept;
         ~unlock_all() noexcept;
 
         // unlocks all locked applications
-        bool execute() override;
+        bool execute(task_plan& _Plan) override;
 
         // returns an error
         const char* error() const noexcept override;
@@ -79,13 +332,154 @@ namespace mjx {
         ~status() noexcept;
 
         // checks if the specified application is locked
-        bool execute() override;
+        bool execute(task_plan& _Plan) override;
         
-        // returns an error (never occurs)
+        // returns an error
+        const char* error() const noexcept override;
+
+        // checks if the task may modify the database (never)
+        bool modifies_database() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class import_list : public task {
+    public:
+        explicit import_list(const unicode_string_view _Target) noexcept;
+        ~import_list() noexcept;
+
+        // locks all applications listed in the specified file
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
         const char* error() const noexcept override;
 
     private:
         unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class export_list : public task {
+    public:
+        export_list() noexcept;
+        ~export_list() noexcept;
+
+        // writes all locked entries to the standard output
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+        // checks if the task may modify the database (never)
+        bool modifies_database() const noexcept override;
+
+    private:
+        const char* _Myerror;
+    };
+
+    class respawn_report : public task {
+    public:
+        respawn_report() noexcept;
+        ~respawn_report() noexcept;
+
+        // writes the respawn statistics reported by the service to the standard output
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+        // checks if the task may modify the database (never)
+        bool modifies_database() const noexcept override;
+
+    private:
+        const char* _Myerror;
+    };
+
+    class query_log : public task {
+    public:
+        explicit query_log(const unicode_string_view _Target) noexcept;
+        ~query_log() noexcept;
+
+        // writes the terminations selected by the query (all if empty) to the standard output
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+        // checks if the task may modify the database (never)
+        bool modifies_database() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class calibrate : public task {
+    public:
+        calibrate() noexcept;
+        ~calibrate() noexcept;
+
+        // measures and stores the membership thresholds of this host
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+        // checks if the task may modify the database (never)
+        bool modifies_database() const noexcept override;
+
+    private:
+        const char* _Myerror;
+    };
+
+    class set_checksum_mode : public task {
+    public:
+        explicit set_checksum_mode(const unicode_string_view _Target) noexcept;
+        ~set_checksum_mode() noexcept;
+
+        // changes how the application names are hashed
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class set_checksum_width : public task {
+    public:
+        explicit set_checksum_width(const unicode_string_view _Target) noexcept;
+        ~set_checksum_width() noexcept;
+
+        // changes the width of the checksums (32 or 64 bits)
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
+    };
+
+    class set_enforcement_mode : public task {
+    public:
+        explicit set_enforcement_mode(const unicode_string_view _Target) noexcept;
+        ~set_enforcement_mode() noexcept;
+
+        // changes whether the listed applications are terminated or permitted
+        bool execute(task_plan& _Plan) override;
+
+        // returns an error
+        const char* error() const noexcept override;
+
+    private:
+        unicode_string_view _Mytarget;
+        const char* _Myerror;
     };
 
     [[nodiscard]] task* make_task(const wchar_t* const _Arg);
@@ -99,7 +493,7 @@ namespace mjx {
         void bind_task(task* const _Task) noexcept;
         
         // executes the binded task
-        bool execute();
+        bool execute(task_plan& _Plan);
 
         // returns an error
         const char* error() const noexcept;
@@ -119,7 +513,7 @@ namespace mjx {
         // adds a new task to the queue
         void push(task* const _Task);
         
-        // executes all tasks stored in the queue
+        // executes all tasks stored in the queue, then applies their changes as one batch
         bool execute();
 
         // returns an error
@@ -132,7 +526,7 @@ namespace mjx {
         // removes and returns the task from the top of the queue
         [[nodiscard]] task* _Pop() noexcept;
 
-        ::std::vector<task*> _Mytasks;
+        ::std::deque<task*> _Mytasks;
         const char* _Myerror;
     };
 } // namespace mjx
@@ -0,0 +1,150 @@
+// xor_filter.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <dbmgr/database.hpp>
+#include <dbmgr/xor_filter.hpp>
+
+namespace mjx {
+    uint64_t _Xor_filter_traits::_Hash(const checksum_t _Val, const uint64_t _Seed) noexcept {
+        // Note: The finalizer comes from MurmurHash3, it's a bijection, so unique checksums
+        //       always produce unique hashes.
+        uint64_t _Hash = static_cast<uint64_t>(_Val) + _Seed;
+        _Hash          = (_Hash ^ (_Hash >> 33)) * 0xFF51'AFD7'ED55'8CCD;
+        _Hash          = (_Hash ^ (_Hash >> 33)) * 0xC4CE'B9FE'1A85'EC53;
+        return _Hash ^ (_Hash >> 33);
+    }
+
+    uint64_t _Xor_filter_traits::_Next_seed(const uint64_t _Seed) noexcept {
+        return _Seed + 0x9E37'79B9'7F4A'7C15;
+    }
+
+    size_t _Xor_filter_traits::_Reduce(const uint32_t _Hash, const size_t _Size) noexcept {
+        return static_cast<size_t>((static_cast<uint64_t>(_Hash) * static_cast<uint64_t>(_Size)) >> 32);
+    }
+
+    uint8_t _Xor_filter_traits::_Fingerprint(const uint64_t _Hash) noexcept {
+        return static_cast<uint8_t>(_Hash ^ (_Hash >> 32));
+    }
+
+    xor_filter::xor_filter() noexcept : _Myfingerprints(), _Myseed(0), _Mysegment(0), _Mysaturated(false) {}
+
+    xor_filter::xor_filter(const ::std::vector<database_entry>& _Entries)
+        : _Myfingerprints(), _Myseed(0), _Mysegment(0), _Mysaturated(false) {
+        if (_Entries.empty()) {
+            return;
+        }
+
+        ::std::vector<checksum_t> _Keys;
+        _Keys.reserve(_Entries.size());
+        for (const database_entry& _Entry : _Entries) {
+            _Keys.push_back(_Entry.checksum());
+        }
+
+        ::std::sort(_Keys.begin(), _Keys.end());
+        _Keys.erase(::std::unique(_Keys.begin(), _Keys.end()), _Keys.end());
+
+        // Note: The filter needs about 1.23 slots per key, plus some slack for tiny sets.
+        _Mysegment = (32 + (_Keys.size() * 123 + 99) / 100 + 2) / 3;
+        for (size_t _Attempt = 0; _Attempt < _Xor_filter_traits::_Max_attempts; ++_Attempt) {
+            _Myseed = _Xor_filter_traits::_Next_seed(_Myseed);
+            if (_Try_build(_Keys)) {
+                return;
+            }
+        }
+
+        // the construction failed (extremely unlikely), accept all checksums to avoid false negatives
+        _Myfingerprints.clear();
+        _Mysaturated = true;
+    }
+
+    xor_filter::~xor_filter() noexcept {}
+
+    void xor_filter::_Get_slots(const uint64_t _Hash, size_t (&_Slots)[3]) const noexcept {
+        _Slots[0] = _Xor_filter_traits::_Reduce(static_cast<uint32_t>(_Hash), _Mysegment);
+        _Slots[1] = _Xor_filter_traits::_Reduce(
+            static_cast<uint32_t>((_Hash << 21) | (_Hash >> 43)), _Mysegment) + _Mysegment;
+        _Slots[2] = _Xor_filter_traits::_Reduce(
+            static_cast<uint32_t>((_Hash << 42) | (_Hash >> 22)), _Mysegment) + 2 * _Mysegment;
+    }
+
+    bool xor_filter::_Try_build(const ::std::vector<checksum_t>& _Keys) {
+        struct _Peeled_key {
+            uint64_t _Hash;
+            size_t _Slot; // the only slot owned by the key
+        };
+
+        const size_t _Capacity = 3 * _Mysegment;
+        ::std::vector<uint64_t> _Masks(_Capacity, 0); // xor of all hashes mapped to each slot
+        ::std::vector<uint32_t> _Counts(_Capacity, 0); // number of hashes mapped to each slot
+        size_t _Slots[3];
+        for (const checksum_t _Key : _Keys) {
+            const uint64_t _Hash = _Xor_filter_traits::_Hash(_Key, _Myseed);
+            _Get_slots(_Hash, _Slots);
+            for (const size_t _Slot : _Slots) {
+                _Masks[_Slot] ^= _Hash;
+                ++_Counts[_Slot];
+            }
+        }
+
+        // peel the slots that are mapped to a single key
+        ::std::vector<size_t> _Queue;
+        ::std::vector<_Peeled_key> _Stack;
+        _Stack.reserve(_Keys.size());
+        for (size_t _Slot = 0; _Slot < _Capacity; ++_Slot) {
+            if (_Counts[_Slot] == 1) {
+                _Queue.push_back(_Slot);
+            }
+        }
+
+        while (!_Queue.empty()) {
+            const size_t _Slot = _Queue.back();
+            _Queue.pop_back();
+            if (_Counts[_Slot] != 1) { // already peeled
+                continue;
+            }
+
+            const uint64_t _Hash = _Masks[_Slot];
+            _Stack.push_back(_Peeled_key{_Hash, _Slot});
+            _Get_slots(_Hash, _Slots);
+            for (const size_t _Other : _Slots) {
+                _Masks[_Other] ^= _Hash;
+                if (--_Counts[_Other] == 1) {
+                    _Queue.push_back(_Other);
+                }
+            }
+        }
+
+        if (_Stack.size() != _Keys.size()) { // the key graph has a cycle, try another seed
+            return false;
+        }
+
+        // assign the fingerprints in the reverse peeling order
+        _Myfingerprints.assign(_Capacity, 0);
+        for (auto _Iter = _Stack.rbegin(); _Iter != _Stack.rend(); ++_Iter) {
+            _Get_slots(_Iter->_Hash, _Slots);
+            _Myfingerprints[_Iter->_Slot] = static_cast<uint8_t>(_Xor_filter_traits::_Fingerprint(_Iter->_Hash)
+                ^ _Myfingerprints[_Slots[0]] ^ _Myfingerprints[_Slots[1]] ^ _Myfingerprints[_Slots[2]]);
+        }
+
+        return true;
+    }
+
+    bool xor_filter::empty() const noexcept {
+        return _Myfingerprints.empty() && !_Mysaturated;
+    }
+
+    bool xor_filter::may_contain(const checksum_t _Val) const noexcept {
+        if (_Myfingerprints.empty()) { // either empty or saturated
+            return _Mysaturated;
+        }
+
+        const uint64_t _Hash = _Xor_filter_traits::_Hash(_Val, _Myseed);
+        size_t _Slots[3];
+        _Get_slots(_Hash, _Slots);
+        return _Xor_filter_traits::_Fingerprint(_Hash)
+            == (_Myfingerprints[_Slots[0]] ^ _Myfingerprints[_Slots[1]] ^ _Myfingerprints[_Slots[2]]);
+    }
+} // namespace mjx
\ No newline at end of file
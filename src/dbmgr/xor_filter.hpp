@@ -0,0 +1,68 @@
+// xor_filter.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _DBMGR_XOR_FILTER_HPP_
+#define _DBMGR_XOR_FILTER_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <dbmgr/checksum.hpp>
+#include <vector>
+
+namespace mjx {
+    class database_entry;
+
+    struct _Xor_filter_traits {
+        // Note: The xor filter stores an 8-bit fingerprint in three slots per key, one in each segment.
+        //       A checksum may belong to the set only if the fingerprints in its slots xor to its own
+        //       fingerprint. The false-positive rate is about 1/256, at about 9.84 bits per key.
+        static constexpr size_t _Max_attempts = 64; // number of seeds to try before giving up
+
+        // hashes the checksum with the selected seed
+        static uint64_t _Hash(const checksum_t _Val, const uint64_t _Seed) noexcept;
+
+        // returns the next seed
+        static uint64_t _Next_seed(const uint64_t _Seed) noexcept;
+
+        // maps the hash onto the range [0, _Size)
+        static size_t _Reduce(const uint32_t _Hash, const size_t _Size) noexcept;
+
+        // returns the fingerprint of the hash
+        static uint8_t _Fingerprint(const uint64_t _Hash) noexcept;
+    };
+
+    class xor_filter { // immutable approximate set of checksums with no false negatives
+    public:
+        xor_filter() noexcept;
+        xor_filter(const xor_filter&)     = default;
+        xor_filter(xor_filter&&) noexcept = default;
+        ~xor_filter() noexcept;
+
+        explicit xor_filter(const ::std::vector<database_entry>& _Entries);
+
+        xor_filter& operator=(const xor_filter&)     = default;
+        xor_filter& operator=(xor_filter&&) noexcept = default;
+
+        // checks if the filter is empty (rejects all checksums)
+        bool empty() const noexcept;
+
+        // checks if the checksum may belong to the set (false means it certainly doesn't)
+        bool may_contain(const checksum_t _Val) const noexcept;
+
+    private:
+        // tries to build the filter with the current seed
+        bool _Try_build(const ::std::vector<checksum_t>& _Keys);
+
+        // returns the slots of the hash
+        void _Get_slots(const uint64_t _Hash, size_t (&_Slots)[3]) const noexcept;
+
+        ::std::vector<uint8_t> _Myfingerprints; // three segments
+        uint64_t _Myseed;
+        size_t _Mysegment; // size of a single segment
+        bool _Mysaturated; // true if the filter couldn't be built (accepts all checksums)
+    };
+} // namespace mjx
+
+#endif // _DBMGR_XOR_FILTER_HPP_
\ No newline at end of file
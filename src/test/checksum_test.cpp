@@ -0,0 +1,134 @@
+// checksum_test.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <dbmgr/checksum.hpp>
+#include <vector>
+
+namespace mjx {
+    struct _Checksum_test_traits {
+        // Note: Every kernel is compared with the reference kernel of its mode (the table-driven one
+        //       for CRC-32C) and with the byte-by-byte implementation used at compile time, which shares
+        //       no code with the kernels. The inputs cover all the lengths around the SIMD block sizes,
+        //       every alignment within a block, and random lengths. The characters are biased towards
+        //       the folded ranges and their boundaries, where the vectorized case folding can go wrong.
+        static constexpr size_t _Max_offset    = 8; // alignments tested (in UTF-16 code units)
+        static constexpr size_t _Max_length    = 80; // all lengths up to this one are tested
+        static constexpr size_t _Random_count  = 20000;
+        static constexpr size_t _Random_length = 4096; // max length of the random inputs
+        static constexpr uint64_t _Seed        = 0x2545'F491'4F6C'DD1D;
+
+        // returns the next pseudo-random number (xorshift64)
+        static uint64_t _Next_random(uint64_t& _State) noexcept;
+
+        // returns a random character, mostly from the folded ranges and their boundaries
+        static wchar_t _Random_char(uint64_t& _State) noexcept;
+
+        // computes the checksum byte by byte (shares no code with the kernels)
+        static checksum_t _Compute_expected(
+            const checksum_mode _Mode, const wchar_t* const _First, const wchar_t* const _Last) noexcept;
+
+        // checks the kernel on the selected input, reports the mismatch
+        static bool _Check(const _Checksum_kernel& _Kernel, const wchar_t* const _First, const size_t _Length,
+            const size_t _Offset) noexcept;
+    };
+
+    uint64_t _Checksum_test_traits::_Next_random(uint64_t& _State) noexcept {
+        _State ^= _State << 13;
+        _State ^= _State >> 7;
+        _State ^= _State << 17;
+        return _State;
+    }
+
+    wchar_t _Checksum_test_traits::_Random_char(uint64_t& _State) noexcept {
+        static constexpr wchar_t _Edges[] = {L'\0', L'@', L'A', L'Z', L'[', L'`', L'a', L'z', L'{', 0x007F, 0x00BF,
+            0x00C0, 0x00D6, 0x00D7, 0x00D8, 0x00DE, 0x00DF, 0x00E0, 0x00FE, 0x00FF, 0x7FFF, 0x8000, 0x8041, 0xFFFF};
+        const uint64_t _Val = _Next_random(_State);
+        switch (_Val % 4) {
+        case 0:
+            return _Edges[(_Val >> 8) % (sizeof(_Edges) / sizeof(_Edges[0]))];
+        case 1:
+            return static_cast<wchar_t>(L'A' + (_Val >> 8) % 58); // 'A' to 'z'
+        case 2:
+            return static_cast<wchar_t>(0x00C0 + (_Val >> 8) % 64); // Latin-1 letters
+        default:
+            return static_cast<wchar_t>(_Val >> 8);
+        }
+    }
+
+    checksum_t _Checksum_test_traits::_Compute_expected(
+        const checksum_mode _Mode, const wchar_t* const _First, const wchar_t* const _Last) noexcept {
+        const size_t _Bytes = static_cast<size_t>(_Last - _First) * sizeof(wchar_t);
+        const bool _Fold    = _Has_bits(_Mode, checksum_mode::case_insensitive);
+        return _Has_bits(_Mode, checksum_mode::wide) ? _Static_checksum_traits::_Xxh64(_First, _Bytes, _Fold)
+            : _Static_checksum_traits::_Crc32c(_First, _Bytes, _Fold);
+    }
+
+    bool _Checksum_test_traits::_Check(const _Checksum_kernel& _Kernel, const wchar_t* const _First,
+        const size_t _Length, const size_t _Offset) noexcept {
+        const wchar_t* const _Last         = _First + _Length;
+        const checksum_t _Actual           = _Kernel._Compute(_First, _Last);
+        const _Checksum_kernel& _Reference = _Checksum_kernel_traits::_Get_reference(_Kernel._Mode);
+        const checksum_t _Expected         = _Compute_expected(_Kernel._Mode, _First, _Last);
+        if (_Actual == _Expected && _Reference._Compute(_First, _Last) == _Expected) {
+            return true;
+        }
+
+        ::printf("[FAIL]: %s (reference %s), length %zu, offset %zu: expected %016llX, got %016llX\n",
+            _Kernel._Name, _Reference._Name, _Length, _Offset, static_cast<unsigned long long>(_Expected),
+            static_cast<unsigned long long>(_Actual));
+        return false;
+    }
+
+    inline int _Entry_point() {
+        uint64_t _State = _Checksum_test_traits::_Seed;
+        ::std::vector<wchar_t> _Buffer(_Checksum_test_traits::_Random_length + _Checksum_test_traits::_Max_offset);
+        size_t _Failures = 0;
+        size_t _Checks   = 0;
+        size_t _Length;
+        size_t _Offset;
+        for (const _Checksum_kernel& _Kernel : _Checksum_kernel_traits::_Kernels) {
+            if (!_Checksum_kernel_traits::_Is_available(_Kernel)) {
+                ::printf("[SKIP]: %s isn't available on this CPU\n", _Kernel._Name);
+                continue;
+            }
+
+            for (wchar_t& _Ch : _Buffer) {
+                _Ch = _Checksum_test_traits::_Random_char(_State);
+            }
+
+            for (_Offset = 0; _Offset < _Checksum_test_traits::_Max_offset; ++_Offset) { // edge cases
+                for (_Length = 0; _Length <= _Checksum_test_traits::_Max_length; ++_Length) {
+                    _Failures += _Checksum_test_traits::_Check(_Kernel, _Buffer.data() + _Offset, _Length, _Offset)
+                        ? 0 : 1;
+                    ++_Checks;
+                }
+            }
+
+            for (size_t _Idx = 0; _Idx < _Checksum_test_traits::_Random_count; ++_Idx) { // random inputs
+                _Offset = _Checksum_test_traits::_Next_random(_State) % _Checksum_test_traits::_Max_offset;
+                _Length = _Checksum_test_traits::_Next_random(_State) % (_Checksum_test_traits::_Random_length + 1);
+                _Buffer[_Offset + _Length / 2] = _Checksum_test_traits::_Random_char(_State); // vary the input
+                _Failures += _Checksum_test_traits::_Check(_Kernel, _Buffer.data() + _Offset, _Length, _Offset)
+                    ? 0 : 1;
+                ++_Checks;
+            }
+        }
+
+        ::printf("[CHECKSUM]: %zu checks, %zu failures\n", _Checks, _Failures);
+        return _Failures == 0 ? 0 : 1;
+    }
+} // namespace mjx
+
+int wmain() {
+    try {
+        return ::mjx::_Entry_point();
+    } catch (...) {
+        ::puts("[ERROR]: Unknown error.");
+        return -1;
+    }
+}
\ No newline at end of file
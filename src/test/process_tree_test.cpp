@@ -0,0 +1,78 @@
+// process_tree_test.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <applocker/audit_queue.hpp>
+#include <applocker/process_tree.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace mjx {
+    struct _Process_tree_test_traits {
+        // Note: The tree is built from made-up processes and only marked, nothing is terminated.
+        //       The launcher (100) has started a regular child (101) and a protected one (102),
+        //       both of them have started children of their own (103 and 104).
+        static constexpr uint32_t _Launcher  = 100;
+        static constexpr uint32_t _Child     = 101;
+        static constexpr uint32_t _Protected = 102;
+        static constexpr uint32_t _Grandson  = 103; // child of _Child
+        static constexpr uint32_t _Ward      = 104; // child of _Protected
+
+        // checks if the process is protected (only _Protected is)
+        static bool _Is_protected(const uint32_t _Id) noexcept;
+
+        // reports the failed check
+        static bool _Expect(const bool _Cond, const char* const _What) noexcept;
+    };
+
+    bool _Process_tree_test_traits::_Is_protected(const uint32_t _Id) noexcept {
+        return _Id == _Protected;
+    }
+
+    bool _Process_tree_test_traits::_Expect(const bool _Cond, const char* const _What) noexcept {
+        if (!_Cond) {
+            ::printf("[FAIL]: %s\n", _What);
+        }
+
+        return _Cond;
+    }
+
+    inline int _Entry_point() {
+        using _Traits = _Process_tree_test_traits;
+        _Audit_queue _Audit;
+        _Process_tree _Tree(_Audit);
+        _Tree._Reset(::std::vector<_Process_traits::_Tree_data>{{_Traits::_Launcher, 4, 1},
+            {_Traits::_Child, _Traits::_Launcher, 2}, {_Traits::_Protected, _Traits::_Launcher, 3},
+            {_Traits::_Grandson, _Traits::_Child, 4}, {_Traits::_Ward, _Traits::_Protected, 5}});
+        const ::std::vector<uint32_t> _Ids = _Tree._Doom(_Traits::_Launcher, &_Traits::_Is_protected);
+        bool _Passed                       = true;
+        _Passed &= _Traits::_Expect(!_Ids.empty() && _Ids[0] == _Traits::_Launcher, "the launcher must be first");
+        _Passed &= _Traits::_Expect(_Ids.size() == 3, "only the launcher, its child and grandson must be marked");
+        _Passed &= _Traits::_Expect(::std::find(_Ids.begin(), _Ids.end(), _Traits::_Protected) == _Ids.end(),
+            "the protected process must not be marked");
+        _Passed &= _Traits::_Expect(::std::find(_Ids.begin(), _Ids.end(), _Traits::_Ward) == _Ids.end(),
+            "the child of the protected process must not be marked");
+        _Passed &= _Traits::_Expect(!_Tree._Insert(200, _Traits::_Protected),
+            "a new child of the protected process must not be terminated");
+        _Passed &= _Traits::_Expect(!_Tree._Insert(201, _Traits::_Ward),
+            "a new grandchild of the protected process must not be terminated");
+        _Passed &= _Traits::_Expect(
+            _Tree._Insert(202, _Traits::_Child), "a new child of a marked process must be terminated");
+        _Passed &= _Traits::_Expect(_Tree._Doom(_Traits::_Launcher, &_Traits::_Is_protected).size() == 1,
+            "the marked descendants must not be marked again");
+        ::printf(_Passed ? "[PROCESS TREE]: OK\n" : "[PROCESS TREE]: Failed\n");
+        return _Passed ? 0 : 1;
+    }
+} // namespace mjx
+
+int wmain() {
+    try {
+        return ::mjx::_Entry_point();
+    } catch (...) {
+        ::puts("[ERROR]: Unknown error.");
+        return -1;
+    }
+}
\ No newline at end of file